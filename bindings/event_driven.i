@@ -4,13 +4,325 @@
 #define SWIG_FILE_WITH_INIT
 #include "iCub/eventdriven/vCodec.h"
 #include "iCub/eventdriven/vBottle.h"
-#include <yarp/os/Bottle.h>
+#include "iCub/eventdriven/vLog.h"
+#include <yarp/os/all.h>
 #include <deque>
 #include <vector>
 #include <memory>
+#include <cstring>
+#include <algorithm>
+
+namespace ev {
+
+/// \brief the bit positions of the address word of the compiled codec:
+/// x_shift x_mask y_shift y_mask y_flip p_shift c_shift t_shift stamp_mask
+/// (t_shift < 0 if there is no type bit, y = (y_flip - y) & y_mask if
+/// y_flip > 0)
+void addressLayout(int *layout, int n_layout)
+{
+#if defined CODEC_128x128
+    int l[9] = {8, 0x7F, 1, 0x7F, 127, 0, 15, -1, 0};
+#elif defined CODEC_304x240_20
+    int l[9] = {1, 0x1FF, 10, 0xFF, 0, 0, 20, 18, 0};
+#else
+    int l[9] = {1, 0x1FF, 12, 0xFF, 0, 0, 22, 23, 0};
+#endif
+    l[8] = vtsHelper::max_stamp;
+    for(int i = 0; i < n_layout && i < 9; i++)
+        layout[i] = l[i];
+}
+
+/// \brief seconds per stamp tick
+double stampPeriod()
+{
+    return vtsHelper::tsscaler;
+}
+
+/// \brief reads the events of one type from a binary event log (a
+/// yarpdatadumper data.log is converted once to a data.log.evlog sidecar) in
+/// blocks of raw int32, cut at a given (unwrapped) time
+class vLogSource
+{
+private:
+
+    vLogReader reader;
+    vLogChunk chunk;
+    vtsHelper unwrapper;
+    std::string type;
+    unsigned int w;
+    unsigned int pos;       //events of the chunk already read
+    unsigned int n_chunk;   //events in the chunk
+    double first_read;
+
+    //the next chunk of the type. \returns false at the end of the log
+    bool nextChunk()
+    {
+        while(reader.next(chunk)) {
+            if(chunk.tag() != type) continue;
+            n_chunk = chunk.header->n_ints / w;
+            if(!n_chunk) continue;
+            pos = 0;
+            unwrapper.resume(chunk.header->first_stamp, chunk.header->wraps);
+            return true;
+        }
+        n_chunk = pos = 0;
+        return false;
+    }
+
+public:
+
+    vLogSource() : w(0), pos(0), n_chunk(0), first_read(0) {}
+
+    bool open(const std::string &file, const std::string &type = "AE")
+    {
+        w = packetSize(type);
+        if(!w) {
+            yError() << "Do not know event-type" << type;
+            return false;
+        }
+        this->type = type;
+        std::string path = findBinaryLog(file);
+        if(path.empty() || !reader.open(path))
+            return false;
+        n_chunk = pos = 0;
+        return true;
+    }
+
+    void close() { reader.close(); }
+
+    unsigned int width() { return w; }
+
+    /// \brief the (unwrapped) time of the first and last events in seconds
+    double firstTime() { return reader.firstTime() * vtsHelper::tsscaler; }
+    double lastTime() { return reader.lastTime() * vtsHelper::tsscaler; }
+
+    /// \brief continue reading from the first event at, or after, a time
+    bool seek(double time)
+    {
+        n_chunk = pos = 0;
+        if(time <= firstTime()) {
+            reader.rewind();
+            return true;
+        }
+        if(!reader.seek(time * vtsHelper::vtsscaler))
+            return false;
+        if(!nextChunk())
+            return false;
+        unsigned long int t = time * vtsHelper::vtsscaler;
+        const std::int32_t *data = chunk.data;
+        while(pos < n_chunk && unwrapper(data[pos * w] & vtsHelper::max_stamp) < t)
+            pos++;
+        return true;
+    }
+
+    /// \brief copy up to n_raw / width() events, before the (unwrapped)
+    /// time until (seconds, < 0 for no limit), into raw.
+    /// \returns the number of events copied (0 at the end of the range)
+    int read(int *raw, int n_raw, double until)
+    {
+        unsigned int capacity = n_raw / w;
+        unsigned long int t_until = until < 0 ? (unsigned long int)-1 :
+                                                until * vtsHelper::vtsscaler;
+        unsigned int n = 0;
+        while(n < capacity) {
+
+            if(pos >= n_chunk && !nextChunk())
+                break;
+
+            //the events of this chunk before the time
+            const std::int32_t *data = chunk.data + pos * w;
+            unsigned int m = 0;
+            while(m < n_chunk - pos && n + m < capacity) {
+                unsigned long int t = unwrapper(data[m * w] & vtsHelper::max_stamp);
+                if(t >= t_until) break;
+                if(!n && !m) first_read = t * vtsHelper::tsscaler;
+                m++;
+            }
+            std::memcpy(raw + n * w, data, m * w * sizeof(std::int32_t));
+            n += m;
+            pos += m;
+
+            //stopped at the time. Unwrapping the same stamp again next time
+            //does not count a wrap.
+            if(pos < n_chunk && n < capacity)
+                break;
+        }
+        return n;
+    }
+
+    /// \brief the (unwrapped) time in seconds of the first event of the last
+    /// read
+    double readTime() { return first_read; }
+
+};
+
+/// \brief receives packets on a port as their raw int32 blocks (no event
+/// objects are created) and queues them to be copied into a numpy ring
+class vRawStream : public yarp::os::Thread
+{
+private:
+
+    struct packet : public yarp::os::Portable
+    {
+        std::string type;
+        std::vector<std::int32_t> data;
+        std::vector<std::int32_t> skipped;
+        bool valid;
+
+        /// \brief reads every (type, events) pair of a vBottle, keeping the
+        /// events of type. A packet that cannot be parsed is marked invalid
+        /// but only a failed connection returns false.
+        bool read(yarp::os::ConnectionReader &connection)
+        {
+            data.clear();
+            valid = false;
+            if(connection.expectInt() != BOTTLE_TAG_LIST)
+                return !connection.isError();
+            int n = connection.expectInt();
+            if(n % 2)
+                return !connection.isError();
+
+            for(int i = 0; i < n; i += 2) {
+                if(connection.expectInt() != BOTTLE_TAG_STRING)
+                    return !connection.isError();
+                int l = connection.expectInt();
+                if(l < 0)
+                    return !connection.isError();
+                std::string tag(l, '\0');
+                connection.expectBlock((char *)tag.data(), tag.size());
+                tag = tag.c_str(); //without a terminating NUL
+                if(connection.expectInt() != (BOTTLE_TAG_LIST|BOTTLE_TAG_INT))
+                    return !connection.isError();
+                int m = connection.expectInt();
+                if(m < 0)
+                    return !connection.isError();
+
+                std::vector<std::int32_t> &dest = tag == type ? data : skipped;
+                unsigned int k = tag == type ? data.size() : 0;
+                dest.resize(k + m);
+                if(!connection.expectBlock((char *)(dest.data() + k),
+                                           m * sizeof(std::int32_t)))
+                    return false;
+            }
+
+            valid = true;
+            return true;
+        }
+
+        bool write(yarp::os::ConnectionWriter &connection) const
+        {
+            return false;
+        }
+    };
+
+    yarp::os::Port port;
+    std::string type;
+    std::deque<std::vector<std::int32_t> > packets;
+    yarp::os::Stamp stamp;
+    yarp::os::Mutex m;
+    unsigned int limit;
+    unsigned int n_dropped;
+
+public:
+
+    vRawStream() : limit(1000), n_dropped(0) {}
+
+    bool open(const std::string &name, const std::string &type = "AE")
+    {
+        if(!packetSize(type)) {
+            yError() << "Do not know event-type" << type;
+            return false;
+        }
+        this->type = type;
+        port.setInputMode(true);
+        port.setOutputMode(false);
+        if(!port.open(name))
+            return false;
+        return start();
+    }
+
+    void close()
+    {
+        port.interrupt();
+        stop();
+        port.close();
+    }
+
+    void run()
+    {
+        packet p;
+        p.type = type;
+        while(!isStopping() && port.read(p)) {
+
+            if(!p.valid || p.data.empty()) continue;
+
+            m.lock();
+            port.getEnvelope(stamp);
+            if(packets.size() >= limit) {
+                packets.pop_front();
+                n_dropped++;
+            }
+            packets.push_back(std::vector<std::int32_t>());
+            packets.back().swap(p.data);
+            m.unlock();
+        }
+    }
+
+    void setLimit(unsigned int packets) { limit = packets; }
+
+    unsigned int width() { return packetSize(type); }
+
+    unsigned int dropped() { return n_dropped; }
+
+    double lastStamp()
+    {
+        m.lock();
+        double t = stamp.getTime();
+        m.unlock();
+        return t;
+    }
+
+    /// \brief copy the queued events into a ring of n_raw / width() events,
+    /// starting at event head (wrapping to the start of the ring).
+    /// \returns the number of events copied
+    int fill(int *raw, int n_raw, int head)
+    {
+        std::deque<std::vector<std::int32_t> > ready;
+        m.lock();
+        ready.swap(packets);
+        m.unlock();
+
+        unsigned int w = width();
+        unsigned int capacity = n_raw / w;
+        if(!capacity) return 0;
+        unsigned int pos = head % capacity;
+        int n_events = 0;
+        for(unsigned int i = 0; i < ready.size(); i++) {
+            const std::int32_t *data = ready[i].data();
+            unsigned int n = ready[i].size() / w;
+            n_events += n;
+            //only the newest capacity events can be kept
+            if(n > capacity) {
+                data += (n - capacity) * w;
+                pos = (pos + n - capacity) % capacity;
+                n = capacity;
+            }
+            unsigned int first = std::min(n, capacity - pos);
+            std::memcpy(raw + pos * w, data, first * w * sizeof(std::int32_t));
+            std::memcpy(raw, data + first * w,
+                        (n - first) * w * sizeof(std::int32_t));
+            pos = (pos + n) % capacity;
+        }
+        return n_events;
+    }
+
+};
+
+}
 %}
 
 %include "numpy.i"
+%include "std_string.i"
 
 %init %{
 import_array();
@@ -26,9 +338,41 @@ import_array();
                                             (unsigned int* s3, int m3),
                                             (unsigned int* s4, int m4),
                                             (unsigned int* s5, int m5)};
+%apply (int* INPLACE_ARRAY1, int DIM1) {(int* raw, int n_raw)};
+%apply (int* ARGOUT_ARRAY1, int DIM1) {(int* layout, int n_layout)};
 
 namespace ev {
 
+unsigned int packetSize(const std::string &type);
+void addressLayout(int *layout, int n_layout);
+double stampPeriod();
+
+class vRawStream
+{
+public:
+    vRawStream();
+    bool open(const std::string &name, const std::string &type = "AE");
+    void close();
+    void setLimit(unsigned int packets);
+    unsigned int width();
+    unsigned int dropped();
+    double lastStamp();
+    int fill(int *raw, int n_raw, int head);
+};
+
+class vLogSource
+{
+public:
+    vLogSource();
+    bool open(const std::string &file, const std::string &type = "AE");
+    void close();
+    unsigned int width();
+    double firstTime();
+    double lastTime();
+    bool seek(double time);
+    int read(int *raw, int n_raw, double until);
+    double readTime();
+};
 
 class vEvent
 {
@@ -138,34 +482,28 @@ public:
 
 
 %extend vBottle {
-    int getSize() {
-                return $self->find("AE").asList()->size() / 2;
+    int getSize(const std::string &type = "AE") {
+        yarp::os::Bottle *b = $self->find(type).asList();
+        unsigned int width = ev::packetSize(type);
+        if(!b || !width) return 0;
+        return b->size() / width;
     }
 
-    void _getData(unsigned int* r1, int n1,
-                 unsigned int* r2, int n2,
-         unsigned int* r3, int n3,
-                 unsigned int* r4, int n4,
-                 unsigned int* r5, int n5)
-    {
-        auto q = $self->get<ev::vEvent>();
-        if ((unsigned int)n1!= q.size()) {
-                std::cerr << "The size of the provided array does not match the expected size" << std::endl;
-            return;
-        }
-        unsigned int i;
-    for (i=0; i< q.size(); i++) {
-            ev::AE* m = ev::read_as<ev::AE>(q[i]);
-
-        r1[i] = m->channel;
-        r2[i] = m->stamp;
-        r3[i] = m->x;
-        r4[i] = m->y;
-        r5[i] = m->polarity;
+    std::string _getTypes() {
+        std::string types;
+        for(unsigned int i = 0; i + 1 < $self->size(); i += 2)
+            types += $self->get(i).asString() + " ";
+        return types;
     }
-        //if (abs(r2[q.size()-1]-r2[0]) > 10000) {
-        //    std::cout << "ERR:meh " << r2[q.size()-1] << " - " << r2[0] << " = " << r2[q.size()-1]-r2[0]  << std::endl;
-        //}
+
+    int _getRaw(const std::string &type, int* raw, int n_raw)
+    {
+        yarp::os::Bottle *b = $self->find(type).asList();
+        if(!b) return 0;
+        int n = std::min(n_raw, (int)b->size());
+        for(int i = 0; i < n; i++)
+            raw[i] = b->get(i).asInt();
+        return n;
     }
 
     void _setData(unsigned int* s1, int m1,
@@ -194,10 +532,213 @@ public:
 %pythoncode %{
 import numpy as np
 
+_layout = None
+
+def _address_layout():
+    global _layout
+    if _layout is None:
+        _layout = addressLayout(9)
+    return _layout
+
+_dtypes = {
+    'TS': [('ts', np.uint32)],
+    'AE': [('ts', np.uint32), ('ch', np.uint8), ('x', np.uint16),
+           ('y', np.uint16), ('pol', np.uint8), ('type', np.uint8)],
+}
+_dtypes['AE64'] = _dtypes['AE'] + [('uts', np.uint64)]
+_dtypes['LAE'] = _dtypes['AE'] + [('id', np.int32)]
+_dtypes['FLOW'] = _dtypes['AE'] + [('vx', np.float32), ('vy', np.float32)]
+_dtypes['GAE'] = _dtypes['LAE'] + [('sigx', np.float32), ('sigy', np.float32),
+                                   ('sigxy', np.float32)]
+
+def dtype(type='AE'):
+    """ the structured numpy dtype that decode() returns for an event-type"""
+    return np.dtype(_dtypes[type])
+
+def view(raw, type='AE'):
+    """ a read-only (events, ints per event) int32 view of a raw block of
+    events, as on the vPort wire. No data is copied"""
+    width = packetSize(type)
+    raw = np.asarray(raw, dtype=np.int32).reshape(-1, width)
+    raw.flags.writeable = False
+    return raw
+
+def decode(raw, type='AE'):
+    """ decode a raw int32 block of events (as on the vPort wire) into a
+    structured numpy array (see dtype()) in a single vectorised pass"""
+    raw = view(raw, type)
+    out = np.empty(len(raw), dtype=dtype(type))
+    xs, xm, ys, ym, yf, ps, cs, ts, sm = _address_layout()
+    out['ts'] = raw[:, 0] & sm
+    if type == 'TS':
+        return out
+    a = raw[:, 1]
+    out['x'] = (a >> xs) & xm
+    out['y'] = ((yf - (a >> ys)) if yf else (a >> ys)) & ym
+    out['pol'] = (a >> ps) & 1
+    out['ch'] = (a >> cs) & 1
+    out['type'] = (a >> ts) & 1 if ts >= 0 else 0
+    if type == 'AE64':
+        out['uts'] = out['ts'] + np.uint64(sm) * raw[:, 2].view(np.uint32)
+    elif type in ('LAE', 'GAE'):
+        out['id'] = raw[:, 2]
+    if type == 'FLOW':
+        f = raw[:, 2:4].copy().view(np.float32)
+        out['vx'], out['vy'] = f[:, 0], f[:, 1]
+    elif type == 'GAE':
+        f = raw[:, 3:6].copy().view(np.float32)
+        out['sigx'], out['sigy'], out['sigxy'] = f[:, 0], f[:, 1], f[:, 2]
+    return out
+
+def getTypes(binp):
+    """ the event-types contained in the vBottle provided by binp"""
+    return binp._getTypes().split()
+
+def getRaw(binp, type='AE'):
+    """ returns the raw (events, ints per event) int32 block of an event-type
+    contained in the vBottle provided by binp"""
+    raw = np.empty(binp.getSize(type) * packetSize(type), dtype=np.int32)
+    binp._getRaw(type, raw)
+    return raw.reshape(-1, packetSize(type))
+
+def getEvents(binp, type='AE'):
+    """ returns the events of an event-type contained in the vBottle provided
+    by binp as a structured numpy array (see dtype())"""
+    return decode(getRaw(binp, type), type)
+
 def getData(binp):
     """ returns the channel, timestamp, x, y and polarity contained
     in the  vBottle provided by binp"""
-    return np.stack(binp._getData(*[binp.getSize()]*5)).T
+    e = getEvents(binp, 'AE')
+    return np.stack([e['ch'], e['ts'], e['x'], e['y'], e['pol']]).T.astype(np.uint32)
+
+class EventRing(object):
+    """ a preallocated ring of the newest events received on a port. The
+    events are copied as raw int32 blocks by a reading thread, so the ring
+    keeps up with a live stream. yarp.Network.init() must be called first.
+
+        ring = EventRing('/python/AE:i', capacity=1000000)
+        ...
+        ring.update()
+        events = ring.latest(10000)
+    """
+
+    def __init__(self, name, capacity=1000000, type='AE'):
+        self.type = type
+        self.width = packetSize(type)
+        self.capacity = capacity
+        self.raw = np.zeros(capacity * self.width, dtype=np.int32)
+        self.head = 0
+        self.stream = vRawStream()
+        if not self.stream.open(name, type):
+            raise IOError('could not open ' + name)
+
+    def update(self):
+        """ copy the received events into the ring. Returns the number of
+        events received since the last update (older events are overwritten
+        if more than capacity arrived)"""
+        n = self.stream.fill(self.raw, self.head % self.capacity)
+        self.head += n
+        return n
+
+    def latest(self, n, decoded=True):
+        """ the newest n events in temporal order. A raw view of the ring is
+        returned (without copying) if decoded is False and the events do not
+        wrap around the end of the ring"""
+        n = min(n, self.head, self.capacity)
+        end = self.head % self.capacity
+        start = end - n
+        raw = self.raw.reshape(-1, self.width)
+        if start >= 0:
+            raw = raw[start:end]
+        else:
+            raw = np.concatenate((raw[start:], raw[:end]))
+        return decode(raw, self.type) if decoded else view(raw, self.type)
+
+    def close(self):
+        self.stream.close()
+
+class LogReader(object):
+    """ reads a recording in numpy blocks of a single event-type with
+    constant memory. A yarpdatadumper data.log is converted once into a
+    binary data.log.evlog alongside it, which is memory mapped and indexed
+    by time. Each block is returned as (t, events): the unwrapped time of
+    each event in seconds and the structured events (see dtype()).
+
+        log = LogReader('/data/atis/data.log')
+        for t, events in log.slices(0.01, start=10.0, stop=20.0):
+            ...
+        for t, events in log.batches(5000):
+            ...
+    """
+
+    def __init__(self, path, type='AE', buffer_events=1000000):
+        self.type = type
+        self.source = vLogSource()
+        if not self.source.open(path, type):
+            raise IOError('could not open ' + path)
+        self.width = self.source.width()
+        self.raw = np.zeros(buffer_events * self.width, dtype=np.int32)
+        self.start = self.source.firstTime()
+        #the first time after the last event
+        self.end = self.source.lastTime() + stampPeriod()
+
+    def _read(self, until, n=None):
+        raw = self.raw if n is None else self.raw[:n * self.width]
+        count = self.source.read(raw, until)
+        raw = raw[:count * self.width].reshape(-1, self.width)
+        events = decode(raw, self.type)
+        #unwrap relative to the first event read
+        _, _, _, _, _, _, _, _, max_stamp = _address_layout()
+        dt = np.diff(events['ts'].astype(np.int64))
+        dt[dt < -(max_stamp // 2)] += max_stamp
+        t = np.empty(count)
+        if count:
+            t[0] = 0
+            np.cumsum(dt * stampPeriod(), out=t[1:])
+            t += self.source.readTime()
+        return t, events
+
+    def slices(self, period, start=None, stop=None):
+        """ yield the events in consecutive periods of time (seconds). Empty
+        periods are yielded as empty arrays"""
+        t0 = self.start if start is None else start
+        stop = self.end if stop is None else stop
+        self.source.seek(t0)
+        while t0 < stop:
+            until = min(t0 + period, stop)
+            parts = [self._read(until)]
+            while len(parts[-1][0]) == len(self.raw) // self.width:
+                parts.append(self._read(until))
+            if len(parts) == 1:
+                yield parts[0]
+            else:
+                yield (np.concatenate([p[0] for p in parts]),
+                       np.concatenate([p[1] for p in parts]))
+            t0 = until
+
+    def batches(self, n, start=None, stop=None):
+        """ yield blocks of n events (the last may be smaller)"""
+        if n * self.width > len(self.raw):
+            self.raw = np.zeros(n * self.width, dtype=np.int32)
+        self.source.seek(self.start if start is None else start)
+        until = -1 if stop is None else stop
+        while True:
+            t, events = self._read(until, n)
+            if not len(t):
+                return
+            yield t, events
+
+    def read(self, start=None, stop=None):
+        """ all the events in a range of time (seconds)"""
+        start = self.start if start is None else start
+        stop = self.end if stop is None else stop
+        parts = list(self.slices(stop - start, start, stop))
+        return (np.concatenate([p[0] for p in parts]),
+                np.concatenate([p[1] for p in parts]))
+
+    def close(self):
+        self.source.close()
 
 def setData(binp, data):
     """ writes the channel, timestamp, x, y and polarity provided
@@ -0,0 +1,105 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "benchutils.h"
+
+using namespace ev;
+
+/// \brief encode a batch of events into a contiguous int block (as written by
+/// the vPort classes)
+template <typename T> static void BM_Encode(benchmark::State &state)
+{
+    vQueue q = makeEventsAs<T>(BATCH_ARGS(state));
+    std::vector<std::int32_t> data(q.size() * packetSize(T::tag));
+
+    for(auto _ : state) {
+        unsigned int pos = 0;
+        for(unsigned int i = 0; i < q.size(); i++)
+            q[i]->encode(data, pos);
+        benchmark::DoNotOptimize(data.data());
+    }
+    state.SetItemsProcessed(state.iterations() * q.size());
+    state.SetBytesProcessed(state.iterations() * data.size() * sizeof(std::int32_t));
+}
+
+/// \brief decode a contiguous int block into a vQueue (as read by the vPort
+/// classes)
+template <typename T> static void BM_Decode(benchmark::State &state)
+{
+    vQueue q = makeEventsAs<T>(BATCH_ARGS(state));
+    std::vector<std::int32_t> data(q.size() * packetSize(T::tag));
+    unsigned int pos = 0;
+    for(unsigned int i = 0; i < q.size(); i++)
+        q[i]->encode(data, pos);
+
+    event<> v = createEvent(T::tag);
+    for(auto _ : state) {
+        vQueue out;
+        int *d = data.data();
+        for(unsigned int i = 0; i < q.size(); i++) {
+            v->decode(d);
+            out.push_back(v->clone());
+        }
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * q.size());
+    state.SetBytesProcessed(state.iterations() * data.size() * sizeof(std::int32_t));
+}
+
+BENCHMARK_TEMPLATE(BM_Encode, AddressEvent)->Apply(batchArgs);
+BENCHMARK_TEMPLATE(BM_Encode, AddressEvent64)->Apply(batchArgs);
+BENCHMARK_TEMPLATE(BM_Encode, FlowEvent)->Apply(batchArgs);
+BENCHMARK_TEMPLATE(BM_Encode, LabelledAE)->Apply(batchArgs);
+BENCHMARK_TEMPLATE(BM_Encode, GaussianAE)->Apply(batchArgs);
+
+BENCHMARK_TEMPLATE(BM_Decode, AddressEvent)->Apply(batchArgs);
+BENCHMARK_TEMPLATE(BM_Decode, AddressEvent64)->Apply(batchArgs);
+BENCHMARK_TEMPLATE(BM_Decode, FlowEvent)->Apply(batchArgs);
+BENCHMARK_TEMPLATE(BM_Decode, LabelledAE)->Apply(batchArgs);
+BENCHMARK_TEMPLATE(BM_Decode, GaussianAE)->Apply(batchArgs);
+
+/// \brief build a vBottle from a batch of events
+static void BM_vBottleAdd(benchmark::State &state)
+{
+    vQueue q = makeEvents(BATCH_ARGS(state));
+
+    for(auto _ : state) {
+        vBottle b;
+        for(unsigned int i = 0; i < q.size(); i++)
+            b.addEvent(q[i]);
+        benchmark::DoNotOptimize(b);
+    }
+    state.SetItemsProcessed(state.iterations() * q.size());
+}
+BENCHMARK(BM_vBottleAdd)->Apply(batchArgs);
+
+/// \brief extract the events of a vBottle
+static void BM_vBottleGet(benchmark::State &state)
+{
+    vQueue q = makeEvents(BATCH_ARGS(state));
+    vBottle b;
+    for(unsigned int i = 0; i < q.size(); i++)
+        b.addEvent(q[i]);
+
+    for(auto _ : state) {
+        vQueue out = b.get<AE>();
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * q.size());
+}
+BENCHMARK(BM_vBottleGet)->Apply(batchArgs);
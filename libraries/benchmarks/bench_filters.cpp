@@ -0,0 +1,78 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "benchutils.h"
+#include <algorithm>
+
+using namespace ev;
+
+/// \brief the per-event salt and pepper check
+static void BM_vNoiseFilterCheck(benchmark::State &state)
+{
+    vQueue q = makeEvents(EVENT_ARGS(state));
+    vNoiseFilter filter;
+    filter.initialise(state.range(1), state.range(1) == 128 ? 128 : 240,
+                      0.01 * vtsHelper::vtsscaler, 1);
+
+    unsigned int i = 0;
+    for(auto _ : state) {
+        AE *v = read_as<AE>(q[i]);
+        benchmark::DoNotOptimize(filter.check(v->x, v->y, v->polarity,
+                                              v->channel, v->stamp));
+        if(++i == q.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_vNoiseFilterCheck)->Apply(eventArgs);
+
+/// \brief the batch salt and pepper filter on encoded events
+static void BM_vNoiseFilterBatch(benchmark::State &state)
+{
+    std::vector<std::int32_t> raw = makeRawEvents(EVENT_ARGS(state));
+    std::vector<std::int32_t> data(raw.size());
+    vNoiseFilter filter;
+    filter.initialise(state.range(1), state.range(1) == 128 ? 128 : 240,
+                      0.01 * vtsHelper::vtsscaler, 1);
+#if defined CODEC_304x240_20
+    filter.setRawLayout(vRawLayout::codec304x240_20());
+#endif
+
+    for(auto _ : state) {
+        std::copy(raw.begin(), raw.end(), data.begin());
+        benchmark::DoNotOptimize(filter.filter(data.data(), data.size() / 2));
+    }
+    state.SetItemsProcessed(state.iterations() * raw.size() / 2);
+}
+BENCHMARK(BM_vNoiseFilterBatch)->Apply(eventArgs);
+
+/// \brief sort a batch of events in which the two channels are interleaved
+/// out of order
+static void BM_qsort(benchmark::State &state)
+{
+    vQueue q = makeEvents(BATCH_ARGS(state));
+    for(unsigned int i = 1; i < q.size(); i += 2)
+        std::swap(q[i - 1], q[i]);
+
+    for(auto _ : state) {
+        vQueue sorted = q;
+        qsort(sorted, true);
+        benchmark::DoNotOptimize(sorted);
+    }
+    state.SetItemsProcessed(state.iterations() * q.size());
+}
+BENCHMARK(BM_qsort)->Apply(batchArgs);
@@ -0,0 +1,109 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "benchutils.h"
+#include <yarp/os/DummyConnector.h>
+
+using namespace ev;
+
+/// \brief serialise a batch of events with vGenPortInterface to an in-memory
+/// connection (the work done by a vGenWritePort per packet)
+static void BM_vPortWrite(benchmark::State &state)
+{
+    vQueue q = makeEvents(BATCH_ARGS(state));
+    vGenPortInterface out;
+    out.setHeader(AE::tag);
+    yarp::os::DummyConnector connection;
+    connection.setTextMode(false);
+
+    for(auto _ : state) {
+        connection.reset();
+        out.setInternalData(q);
+        out.write(connection.getWriter());
+    }
+    state.SetItemsProcessed(state.iterations() * q.size());
+}
+BENCHMARK(BM_vPortWrite)->Apply(batchArgs);
+
+/// \brief serialise and deserialise a batch of events with vGenPortInterface
+/// through an in-memory connection
+static void BM_vPortWriteRead(benchmark::State &state)
+{
+    vQueue q = makeEvents(BATCH_ARGS(state));
+    vGenPortInterface out, in;
+    out.setHeader(AE::tag);
+    yarp::os::DummyConnector connection;
+    connection.setTextMode(false);
+
+    for(auto _ : state) {
+        connection.reset();
+        out.setInternalData(q);
+        out.write(connection.getWriter());
+
+        vQueue received;
+        in.setReadContainer(received);
+        in.read(connection.getReader());
+        benchmark::DoNotOptimize(received);
+    }
+    state.SetItemsProcessed(state.iterations() * q.size());
+}
+BENCHMARK(BM_vPortWriteRead)->Apply(batchArgs);
+
+/// \brief send an already encoded block with vGenPortInterface (the raw write
+/// path of vGenWritePort)
+static void BM_vPortWriteRaw(benchmark::State &state)
+{
+    std::vector<std::int32_t> raw = makeRawEvents(BATCH_ARGS(state));
+    vGenPortInterface out;
+    out.setHeader(AE::tag);
+    yarp::os::DummyConnector connection;
+    connection.setTextMode(false);
+
+    for(auto _ : state) {
+        connection.reset();
+        out.setExternalData((const char *)raw.data(),
+                            raw.size() * sizeof(std::int32_t));
+        out.write(connection.getWriter());
+    }
+    state.SetItemsProcessed(state.iterations() * raw.size() / 2);
+}
+BENCHMARK(BM_vPortWriteRaw)->Apply(batchArgs);
+
+/// \brief serialise and deserialise a batch of events as a vBottle through
+/// an in-memory connection, for comparison with vGenPortInterface
+static void BM_vBottleWriteRead(benchmark::State &state)
+{
+    vQueue q = makeEvents(BATCH_ARGS(state));
+    yarp::os::DummyConnector connection;
+    connection.setTextMode(false);
+
+    for(auto _ : state) {
+        connection.reset();
+        vBottle out;
+        for(unsigned int i = 0; i < q.size(); i++)
+            out.addEvent(q[i]);
+        out.write(connection.getWriter());
+
+        vBottle in;
+        in.read(connection.getReader());
+        vQueue received = in.get<AE>();
+        benchmark::DoNotOptimize(received);
+    }
+    state.SetItemsProcessed(state.iterations() * q.size());
+}
+BENCHMARK(BM_vBottleWriteRead)->Apply(batchArgs);
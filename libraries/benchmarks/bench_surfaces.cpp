@@ -0,0 +1,169 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "benchutils.h"
+
+using namespace ev;
+
+/// \brief add a stream of events to a surface (the surface is re-filled once
+/// the stream is exhausted, so the cost includes the event removal)
+template <typename S> static void addToSurface(S &surface, const vQueue &q,
+                                               benchmark::State &state)
+{
+    unsigned int i = 0;
+    for(auto _ : state) {
+        surface.fastAddEvent(q[i]);
+        if(++i == q.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/// \brief query the neighbourhood of each event of a filled surface
+template <typename S> static void querySurface(S &surface, const vQueue &q,
+                                               benchmark::State &state)
+{
+    for(unsigned int i = 0; i < q.size(); i++)
+        surface.fastAddEvent(q[i]);
+
+    unsigned int i = 0;
+    for(auto _ : state) {
+        AE *v = read_as<AE>(q[i]);
+        vQueue neighbours = surface.getSurf(v->x, v->y, 5);
+        benchmark::DoNotOptimize(neighbours);
+        if(++i == q.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_temporalSurfaceAdd(benchmark::State &state)
+{
+    vQueue q = makeEvents(EVENT_ARGS(state));
+    temporalSurface surface(state.range(1), state.range(1) == 128 ? 128 : 240,
+                            0.01 * vtsHelper::vtsscaler);
+    addToSurface(surface, q, state);
+}
+BENCHMARK(BM_temporalSurfaceAdd)->Apply(eventArgs);
+
+static void BM_temporalSurfaceQuery(benchmark::State &state)
+{
+    vQueue q = makeEvents(EVENT_ARGS(state));
+    temporalSurface surface(state.range(1), state.range(1) == 128 ? 128 : 240,
+                            0.01 * vtsHelper::vtsscaler);
+    querySurface(surface, q, state);
+}
+BENCHMARK(BM_temporalSurfaceQuery)->Apply(eventArgs);
+
+static void BM_fixedSurfaceAdd(benchmark::State &state)
+{
+    vQueue q = makeEvents(EVENT_ARGS(state));
+    fixedSurface surface(1000, state.range(1), state.range(1) == 128 ? 128 : 240);
+    addToSurface(surface, q, state);
+}
+BENCHMARK(BM_fixedSurfaceAdd)->Apply(eventArgs);
+
+static void BM_fixedSurfaceQuery(benchmark::State &state)
+{
+    vQueue q = makeEvents(EVENT_ARGS(state));
+    fixedSurface surface(1000, state.range(1), state.range(1) == 128 ? 128 : 240);
+    querySurface(surface, q, state);
+}
+BENCHMARK(BM_fixedSurfaceQuery)->Apply(eventArgs);
+
+static void BM_lifetimeSurfaceAdd(benchmark::State &state)
+{
+    vQueue q = makeEventsAs<FlowEvent>(EVENT_ARGS(state));
+    for(unsigned int i = 0; i < q.size(); i++) {
+        read_as<FlowEvent>(q[i])->vx = 0.001;
+        read_as<FlowEvent>(q[i])->vy = 0.001;
+    }
+    lifetimeSurface surface(state.range(1), state.range(1) == 128 ? 128 : 240);
+    unsigned int i = 0;
+    for(auto _ : state) {
+        vQueue removed = surface.addEvent(q[i]);
+        benchmark::DoNotOptimize(removed);
+        if(++i == q.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_lifetimeSurfaceAdd)->Apply(eventArgs);
+
+static void BM_vSurfaceAdd(benchmark::State &state)
+{
+    vQueue q = makeEvents(EVENT_ARGS(state));
+    vSurface surface(state.range(1), state.range(1) == 128 ? 128 : 240);
+    unsigned int i = 0;
+    for(auto _ : state) {
+        surface.addEvent(is_event<AE>(q[i]));
+        if(++i == q.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_vSurfaceAdd)->Apply(eventArgs);
+
+static void BM_vSurfaceQuery(benchmark::State &state)
+{
+    vQueue q = makeEvents(EVENT_ARGS(state));
+    vSurface surface(state.range(1), state.range(1) == 128 ? 128 : 240);
+    for(unsigned int i = 0; i < q.size(); i++)
+        surface.addEvent(is_event<AE>(q[i]));
+
+    unsigned int i = 0;
+    for(auto _ : state) {
+        AE *v = read_as<AE>(q[i]);
+        vQueue neighbours = surface.getSurf(v->x, v->y, 5);
+        benchmark::DoNotOptimize(neighbours);
+        if(++i == q.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_vSurfaceQuery)->Apply(eventArgs);
+
+static void BM_historicalSurfaceQuery(benchmark::State &state)
+{
+    vQueue q = makeEvents(EVENT_ARGS(state));
+    historicalSurface surface;
+    surface.initialise(state.range(1) == 128 ? 128 : 240, state.range(1));
+    surface.addEvents(q);
+
+    int window = 0.01 * vtsHelper::vtsscaler;
+    unsigned int i = 0;
+    for(auto _ : state) {
+        AE *v = read_as<AE>(q[i]);
+        vQueue neighbours = surface.getSurface(0, window, 5, v->x, v->y);
+        benchmark::DoNotOptimize(neighbours);
+        if(++i == q.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_historicalSurfaceQuery)->Apply(eventArgs);
+
+/// \brief add a batch of events to an empty temporal window and read the
+/// window
+static void BM_vTempWindow(benchmark::State &state)
+{
+    vQueue q = makeEvents(EVENT_ARGS(state));
+
+    for(auto _ : state) {
+        vTempWindow window;
+        window.addEvents(q);
+        vQueue w = window.getWindow();
+        benchmark::DoNotOptimize(w);
+    }
+    state.SetItemsProcessed(state.iterations() * q.size());
+}
+BENCHMARK(BM_vTempWindow)->Apply(eventArgs);
@@ -0,0 +1,99 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BENCHUTILS__
+#define __BENCHUTILS__
+
+#include <benchmark/benchmark.h>
+#include <iCub/eventdriven/all.h>
+#include <vector>
+
+/// \brief encoded events from the synthetic generator (a moving edge over
+/// background noise) using the address encoding the library was built with
+inline std::vector<std::int32_t> makeRawEvents(unsigned int n_events,
+                                               int width, int height,
+                                               double rate)
+{
+    ev::vEventGenerator generator;
+#if defined CODEC_128x128
+    generator.setCodec(ev::codec_128x128);
+#elif defined CODEC_304x240_20
+    generator.setCodec(ev::codec_304x240_20);
+#else
+    generator.setCodec(ev::codec_304x240_24);
+#endif
+    generator.setResolution(width, height);
+    generator.setRate(rate);
+    generator.setChannels(ev::vEventGenerator::split);
+    generator.addPattern(ev::vEventGenerator::edge, 1.0, 500.0, 0.0, 0.3);
+    generator.addPattern(ev::vEventGenerator::noise, 0.1);
+
+    std::vector<std::int32_t> raw(2 * n_events);
+    generator.generate(raw.data(), n_events);
+    return raw;
+}
+
+/// \brief the synthetic events decoded as AddressEvents
+inline ev::vQueue makeEvents(unsigned int n_events, int width, int height,
+                             double rate)
+{
+    std::vector<std::int32_t> raw = makeRawEvents(n_events, width, height, rate);
+    ev::vQueue q;
+    int *data = raw.data();
+    for(unsigned int i = 0; i < n_events; i++) {
+        auto v = ev::make_event<ev::AE>();
+        v->decode(data);
+        q.push_back(v);
+    }
+    return q;
+}
+
+/// \brief the synthetic events converted to another event-type
+template <typename T> ev::vQueue makeEventsAs(unsigned int n_events,
+                                              int width, int height,
+                                              double rate)
+{
+    ev::vQueue q = makeEvents(n_events, width, height, rate);
+    for(unsigned int i = 0; i < q.size(); i++)
+        q[i] = ev::make_event<T>(q[i]);
+    return q;
+}
+
+/// \brief the parameters of the benchmarks over event streams: the number of
+/// events per batch, the sensor width (128x128 or 304x240) and the event rate
+inline void eventArgs(benchmark::internal::Benchmark *b)
+{
+    b->ArgNames({"events", "width", "kevps"});
+    for(int n : {1000, 10000})
+        for(int w : {128, 304})
+            for(int r : {100, 10000})
+                b->Args({n, w, r});
+}
+
+/// \brief the parameters of the benchmarks over batches of events
+inline void batchArgs(benchmark::internal::Benchmark *b)
+{
+    b->ArgNames({"events"});
+    b->RangeMultiplier(10)->Range(100, 100000);
+}
+
+#define EVENT_ARGS(state) state.range(0), state.range(1), \
+    state.range(1) == 128 ? 128 : 240, state.range(2) * 1000.0
+#define BATCH_ARGS(state) state.range(0), 304, 240, 1000000.0
+
+#endif
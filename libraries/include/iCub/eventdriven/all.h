@@ -7,4 +7,14 @@
 #include "iCub/eventdriven/vSurfaceHandlerTh.h"
 #include "iCub/eventdriven/vCollectSend.h"
 #include "iCub/eventdriven/vPort.h"
+#include "iCub/eventdriven/vLog.h"
+#include "iCub/eventdriven/vProcessor.h"
+#include "iCub/eventdriven/vEventGenerator.h"
+#include "iCub/eventdriven/vStats.h"
+#include "iCub/eventdriven/vTrace.h"
+#include "iCub/eventdriven/vClock.h"
+#include "iCub/eventdriven/vImageCodec.h"
+#include "iCub/eventdriven/vHotPixels.h"
+#include "iCub/eventdriven/vFilteredPort.h"
 
+#include "iCub/eventdriven/vPyramid.h"
@@ -0,0 +1,138 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VCLOCK__
+#define __VCLOCK__
+
+#include <yarp/os/all.h>
+#include "iCub/eventdriven/vtsHelper.h"
+#include <deque>
+
+namespace ev {
+
+/// \brief a model of the device clock (event stamps) against the host clock.
+/// The grabber adds the stamp of the newest event of each packet with the
+/// host time it was sent. The host time of an event is then
+/// host = host_ref + rate * (device - device_ref), fitted by least squares to
+/// the samples with the least delay (transport and queueing only ever add
+/// delay), so an event is mapped to the time it would have reached the
+/// grabber with the smallest delay observed. The model is thread-safe:
+/// samples can be added by one thread while others query it.
+class vClockModel
+{
+private:
+
+    struct sample {
+        double device;
+        double host;
+    };
+
+    yarp::os::Mutex m;
+    vtsHelper unwrapper;
+    std::deque<sample> samples;
+    sample pending;
+    bool has_pending;
+    unsigned int window;
+    double spacing;
+    unsigned int since_fit;
+
+    //the fitted model
+    bool valid;
+    double device_ref;
+    double host_ref;
+    double rate;
+    double spread;
+
+    void fit();
+
+public:
+
+    /// \brief fit over window samples, each the least delayed of spacing
+    /// seconds of packets
+    vClockModel(unsigned int window = 500, double spacing = 0.02);
+
+    /// \brief add the (wrapping) stamp of an event and the host time it was
+    /// seen at. Every stamp must be added to unwrap them correctly.
+    void add(unsigned int stamp, double host_time);
+
+    /// \brief add an unwrapped device time in seconds
+    void addUnwrapped(double device_time, double host_time);
+
+    /// \brief forget all samples (e.g. the device was reset)
+    void reset();
+
+    bool isValid();
+
+    /// \brief the host time of an (unwrapped) device time in seconds
+    double toHost(double device_time);
+
+    /// \brief the device time (seconds, unwrapped) at a host time
+    double toDevice(double host_time);
+
+    /// \brief the (wrapping) stamp the device has at a host time
+    unsigned int deviceStamp(double host_time);
+
+    /// \brief how long ago (seconds of host time) an event with the given
+    /// (wrapping) stamp happened
+    double age(unsigned int stamp);
+
+    /// \brief the rate of the device clock relative to the host - 1
+    double drift();
+
+    /// \brief the difference (host - device) at the newest sample
+    double offset();
+
+    /// \brief the spread of the delay of the samples used (seconds)
+    double jitter();
+
+    /// \brief (device_ref host_ref rate jitter) to publish the model
+    void toBottle(yarp::os::Bottle &b);
+
+    /// \brief use a published model
+    bool fromBottle(const yarp::os::Bottle &b);
+
+};
+
+/// \brief receives a vClockModel published by a grabber (e.g.
+/// /zynqGrabber/clock:o) so it can be queried in another module
+class vClockReader : public yarp::os::BufferedPort<yarp::os::Bottle>
+{
+private:
+
+    vClockModel clock;
+
+public:
+
+    bool open(const std::string &name)
+    {
+        this->useCallback();
+        return yarp::os::BufferedPort<yarp::os::Bottle>::open(name);
+    }
+
+    void onRead(yarp::os::Bottle &b)
+    {
+        clock.fromBottle(b);
+    }
+
+    vClockModel & model() { return clock; }
+
+};
+
+}
+
+#endif
@@ -21,6 +21,7 @@
 
 
 #include <yarp/os/Bottle.h>
+#include "iCub/eventdriven/vtsHelper.h"
 #include <memory>
 #include <deque>
 #include <math.h>
@@ -120,6 +121,53 @@ public:
 };
 using AE = AddressEvent;
 
+/// \brief an AddressEvent with an unwrapped 64-bit timestamp. The wrapped
+/// stamp is kept consistent so the event can be used as an AddressEvent.
+class AddressEvent64 : public AddressEvent
+{
+public:
+    static const std::string tag;
+    std::uint64_t ustamp;
+
+    AddressEvent64();
+    AddressEvent64(const vEvent &v);
+    AddressEvent64(const AddressEvent64 &v);
+
+    virtual event<> clone();
+    virtual void encode(yarp::os::Bottle &b) const;
+    virtual void encode(std::vector<std::int32_t> &b, unsigned int &pos) const;
+    virtual bool decode(const yarp::os::Bottle &packet, size_t &pos);
+    virtual void decode(int *&data);
+    virtual yarp::os::Property getContent() const;
+    virtual std::string getType() const;
+
+    void setUnwrappedStamp(std::uint64_t ustamp);
+};
+using AE64 = AddressEvent64;
+
+/// \brief AddressEvent64 differences need no wrap correction
+template <> struct stampTraits<AddressEvent64>
+{
+    typedef std::uint64_t type;
+    typedef std::int64_t delta_type;
+
+    static type get(const AddressEvent64 &v) { return v.ustamp; }
+    static delta_type delta(type later, type earlier) {
+        return later - earlier;
+    }
+    /// \brief the unwrapped stamp nearest to the reference that has the
+    /// wrapped (TIMER_BITS) stamp
+    static type fromWrapped(type reference, unsigned int stamp) {
+        delta_type half = vtsHelper::max_stamp / 2;
+        delta_type dt = (delta_type)stamp -
+                (delta_type)(reference % vtsHelper::max_stamp);
+        if(dt > half) dt -= vtsHelper::max_stamp;
+        else if(dt < -half) dt += vtsHelper::max_stamp;
+        if(dt < 0 && (type)-dt > reference) return 0;
+        return reference + dt;
+    }
+};
+
 /// \brief an AddressEvent with a velocity in visual space
 class FlowEvent : public AddressEvent
 {
@@ -0,0 +1,125 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VEVENTGENERATOR__
+#define __VEVENTGENERATOR__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ev {
+
+/// \brief the address encodings a synthetic stream can be written with. The
+/// codec is selected at run-time, so one build can load any consumer.
+enum vAddressCodec { codec_128x128, codec_304x240_20, codec_304x240_24 };
+
+/// \brief generates synthetic AddressEvent streams (moving edges, circles
+/// and corners, uniform noise, hot pixels and bursts) directly as encoded
+/// [stamp, address] pairs, at rates well beyond those of the sensors. Event
+/// stamps advance according to the event rate, not the wall clock.
+class vEventGenerator
+{
+public:
+
+    enum patternType { edge, circle, corner, noise, hotpixel };
+    enum channelMode { left = 0, right = 1, split = 2 };
+
+private:
+
+    struct pattern {
+        patternType type;
+        double weight;      //relative share of the events
+        double speed;       //pixels per second
+        double size;        //radius, arm length or number of hot pixels
+        double angle;       //edge orientation (radians)
+        double x, y;        //current position
+        double vx, vy;      //current direction of motion
+        unsigned int first; //first hot pixel of this pattern
+    };
+
+    //patterns
+    std::vector<pattern> patterns;
+    std::vector<std::uint32_t> thresholds;
+    std::vector<std::int32_t> hot_pixels;
+    std::vector<float> unit_x;
+    std::vector<float> unit_y;
+
+    //parameters
+    int width;
+    int height;
+    vAddressCodec codec;
+    channelMode channels;
+    double rate;
+    double burst_period;
+    double burst_length;
+    double burst_gain;
+    double update_period;
+
+    //state
+    double time;
+    double next_update;
+    std::uint64_t rng;
+
+    std::uint32_t random() {
+        rng ^= rng >> 12; rng ^= rng << 25; rng ^= rng >> 27;
+        return (rng * 2685821657736338717ULL) >> 32;
+    }
+    int random(int n) { return ((std::uint64_t)random() * n) >> 32; }
+
+    std::int32_t encode(int x, int y, int p, int c) const;
+    void updatePatterns();
+    bool sample(const pattern &pt, int &x, int &y, int &p);
+
+public:
+
+    vEventGenerator();
+
+    void setResolution(int width, int height);
+    void setCodec(vAddressCodec codec) { this->codec = codec; }
+    void setChannels(channelMode channels) { this->channels = channels; }
+    /// \brief the average number of events per second (of event time)
+    void setRate(double events_per_second) { rate = events_per_second; }
+    /// \brief every period seconds the rate is multiplied by gain for length
+    /// seconds (period 0 disables bursts)
+    void setBursts(double period, double length, double gain);
+    void setSeed(std::uint64_t seed) { rng = seed ? seed : 1; }
+
+    /// \brief add a pattern producing a weighted share of the events
+    void addPattern(patternType type, double weight, double speed = 100.0,
+                    double size = 20.0, double angle = 0.0);
+    void clearPatterns();
+
+    /// \brief fill data with n_events encoded events (2 * n_events ints),
+    /// returning the number of ints written
+    unsigned int generate(std::int32_t *data, unsigned int n_events);
+
+    /// \brief the unwrapped event time of the last generated event
+    std::uint64_t currentTime() const { return (std::uint64_t)time; }
+    /// \brief the rate at the current event time, including bursts
+    double currentRate() const;
+
+    static bool parseCodec(const std::string &name, vAddressCodec &codec);
+    static bool parsePattern(const std::string &name, patternType &type);
+    static bool parseChannels(const std::string &name, channelMode &mode);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,364 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VFILTEREDPORT__
+#define __VFILTEREDPORT__
+
+#include <yarp/os/all.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vPort.h"
+
+namespace ev {
+
+/// \brief the events a subscriber asks a vFilteredWritePort for: the events
+/// of a channel, inside a region, of which one in every decimate is sent
+struct vPortFilter
+{
+    int channel;
+    bool roi;
+    int x0, y0, x1, y1;
+    unsigned int decimate;
+    unsigned int count;
+
+    vPortFilter() : channel(-1), roi(false), x0(0), y0(0), x1(0), y1(0),
+        decimate(1), count(0) {}
+
+    /// \brief set the region x0 <= x <= x1, y0 <= y <= y1
+    void setROI(int x0, int y0, int x1, int y1)
+    {
+        roi = true;
+        this->x0 = x0; this->y0 = y0; this->x1 = x1; this->y1 = y1;
+    }
+
+    /// \brief set from [channel c] [roi (x0 y0 x1 y1)] [decimate n]
+    bool fromBottle(const yarp::os::Bottle &b)
+    {
+        channel = b.check("channel") ? b.find("channel").asInt() : -1;
+        decimate = b.check("decimate") ?
+                    std::max(b.find("decimate").asInt(), 1) : 1;
+        roi = false;
+        if(b.check("roi")) {
+            yarp::os::Bottle *r = b.find("roi").asList();
+            if(!r || r->size() != 4) return false;
+            setROI(r->get(0).asInt(), r->get(1).asInt(), r->get(2).asInt(),
+                   r->get(3).asInt());
+        }
+        return true;
+    }
+
+    void toBottle(yarp::os::Bottle &b) const
+    {
+        if(channel >= 0) {
+            b.addString("channel"); b.addInt(channel);
+        }
+        if(roi) {
+            b.addString("roi");
+            yarp::os::Bottle &r = b.addList();
+            r.addInt(x0); r.addInt(y0); r.addInt(x1); r.addInt(y1);
+        }
+        if(decimate > 1) {
+            b.addString("decimate"); b.addInt(decimate);
+        }
+    }
+
+    inline bool pass(const AE &v)
+    {
+        if(channel >= 0 && (int)v.channel != channel) return false;
+        if(roi && ((int)v.x < x0 || (int)v.x > x1 ||
+                   (int)v.y < y0 || (int)v.y > y1)) return false;
+        if(decimate > 1 && ++count % decimate) return false;
+        return true;
+    }
+};
+
+/// \brief the address of an event in a std::deque<AE> or a vQueue
+inline const AE & vAddressOf(const AE &v) { return v; }
+inline const AE & vAddressOf(const event<vEvent> &v) { return *read_as<AE>(v); }
+
+inline void vSetWriteType(vGenWritePort &port, const std::string &tag)
+{
+    port.setWriteType(tag);
+}
+template <class T> inline void vSetWriteType(vWritePort<T> &, const std::string &) {}
+
+/// \brief a write port (P, a vGenWritePort or vWritePort<T>, writing queues Q)
+/// whose readers can ask, over the <name>/filter port, for only a part of the
+/// events (see vPortFilterClient). Each subscriber is given its own port,
+/// <name><reader>, connected to the reader in place of the full stream, and
+/// its events are filtered before they are encoded:
+/// subscribe <reader> [channel c] [roi (x0 y0 x1 y1)] [decimate n]
+/// unsubscribe <reader>
+/// list
+template <class Q, class P> class vFilteredWritePort : public yarp::os::PortReader
+{
+private:
+
+    struct subscription {
+        std::string target;
+        std::string carrier; //of name -> target before subscribing, or ""
+        vPortFilter filter;
+        P port;
+        Q q;
+    };
+
+    std::string name;
+    std::string tag;
+    P port;
+    yarp::os::Port rpc_port;
+    std::vector<subscription *> subs;
+    yarp::os::Mutex m;
+
+    /// \brief the carrier of the connection from the port to target, asked
+    /// to the port itself, or "" if they are not connected
+    std::string carrierTo(const std::string &target)
+    {
+        yarp::os::Bottle cmd, reply;
+        cmd.addString("list");
+        cmd.addString("out");
+        cmd.addString(target);
+        if(!yarp::os::Network::write(yarp::os::Network::queryName(name), cmd,
+                                     reply, true, true))
+            return "";
+        return reply.find("carrier").asString();
+    }
+
+    bool subscribe(const std::string &target, const vPortFilter &filter)
+    {
+        m.lock();
+        for(unsigned int i = 0; i < subs.size(); i++) {
+            if(subs[i]->target != target) continue;
+            unsigned int count = subs[i]->filter.count;
+            subs[i]->filter = filter;
+            subs[i]->filter.count = count;
+            m.unlock();
+            return true;
+        }
+        m.unlock();
+
+        subscription *s = new subscription;
+        s->target = target;
+        s->carrier = carrierTo(target);
+        s->filter = filter;
+        vSetWriteType(s->port, tag);
+        if(!s->port.open(name + target)) {
+            delete s;
+            return false;
+        }
+        //the subscriber port is connected as the full stream was
+        if(!yarp::os::Network::connect(name + target, target,
+                                       s->carrier.empty() ? "tcp" : s->carrier)) {
+            s->port.close();
+            delete s;
+            return false;
+        }
+
+        m.lock();
+        subs.push_back(s);
+        m.unlock();
+        if(!s->carrier.empty())
+            yarp::os::Network::disconnect(name, target);
+        yInfo() << target << "subscribed to" << name;
+        return true;
+    }
+
+    bool unsubscribe(const std::string &target)
+    {
+        subscription *s = nullptr;
+        m.lock();
+        for(unsigned int i = 0; i < subs.size(); i++) {
+            if(subs[i]->target != target) continue;
+            s = subs[i];
+            subs.erase(subs.begin() + i);
+            break;
+        }
+        m.unlock();
+        if(!s) return false;
+
+        //the full stream is restored only if it was connected
+        if(!s->carrier.empty())
+            yarp::os::Network::connect(name, target, s->carrier);
+        s->port.close();
+        delete s;
+        yInfo() << target << "unsubscribed from" << name;
+        return true;
+    }
+
+public:
+
+    ~vFilteredWritePort()
+    {
+        close();
+    }
+
+    bool open(const std::string &name)
+    {
+        this->name = name;
+        if(!port.open(name))
+            return false;
+        rpc_port.setReader(*this);
+        return rpc_port.open(name + "/filter");
+    }
+
+    void close()
+    {
+        rpc_port.close();
+        m.lock();
+        for(unsigned int i = 0; i < subs.size(); i++) {
+            subs[i]->port.close();
+            delete subs[i];
+        }
+        subs.clear();
+        m.unlock();
+        port.close();
+    }
+
+    void setWriteType(const std::string &tag)
+    {
+        this->tag = tag;
+        vSetWriteType(port, tag);
+    }
+
+    /// \brief send the queue to the readers of the full stream, and the
+    /// filtered queue to each subscriber
+    bool write(const Q &q, const vTrace &trace)
+    {
+        bool ok = true;
+        if(port.getOutputCount())
+            ok = port.write(q, trace);
+
+        m.lock();
+        for(unsigned int i = 0; i < subs.size(); i++) {
+            subscription &s = *subs[i];
+            s.q.clear();
+            for(typename Q::const_iterator qi = q.begin(); qi != q.end(); qi++) {
+                if(s.filter.pass(vAddressOf(*qi)))
+                    s.q.push_back(*qi);
+            }
+            if(s.q.size())
+                s.port.write(s.q, trace);
+        }
+        m.unlock();
+
+        return ok;
+    }
+
+    /// \brief the requests of the subscribers
+    bool read(yarp::os::ConnectionReader &connection)
+    {
+        yarp::os::Bottle cmd, reply;
+        if(!cmd.read(connection))
+            return false;
+
+        std::string command = cmd.get(0).asString();
+        std::string target = cmd.get(1).asString();
+        bool ok = false;
+        if(command == "subscribe" && target.size()) {
+            vPortFilter filter;
+            ok = filter.fromBottle(cmd) && subscribe(target, filter);
+        } else if(command == "unsubscribe" && target.size()) {
+            ok = unsubscribe(target);
+        } else if(command == "list") {
+            m.lock();
+            for(unsigned int i = 0; i < subs.size(); i++) {
+                yarp::os::Bottle &sub = reply.addList();
+                sub.addString(subs[i]->target);
+                subs[i]->filter.toBottle(sub);
+            }
+            m.unlock();
+            ok = true;
+        }
+
+        yarp::os::ConnectionWriter *writer = connection.getWriter();
+        if(writer) {
+            if(command != "list")
+                reply.addString(ok ? "ok" : "fail");
+            reply.write(*writer);
+        }
+        return true;
+    }
+
+};
+
+typedef vFilteredWritePort<vQueue, vGenWritePort> vGenFilteredWritePort;
+
+/// \brief asks a vFilteredWritePort to send a reading port only the events it
+/// needs. Requests are not answered, so they can be sent as the region of
+/// interest moves (but not faster than the publisher can open a connection).
+class vPortFilterClient
+{
+private:
+
+    yarp::os::Port port;
+    std::string target;
+    bool subscribed;
+
+public:
+
+    vPortFilterClient() : subscribed(false) {}
+
+    /// \brief open the port <name>/filter:o sending requests for the reading
+    /// port target
+    bool open(const std::string &name, const std::string &target)
+    {
+        this->target = target;
+        port.setOutputMode(true);
+        return port.open(name + "/filter:o");
+    }
+
+    /// \brief connect to the vFilteredWritePort publisher (its port name)
+    bool connect(const std::string &publisher)
+    {
+        return yarp::os::Network::connect(port.getName(),
+                                          publisher + "/filter", "tcp");
+    }
+
+    bool request(const vPortFilter &filter)
+    {
+        yarp::os::Bottle cmd;
+        cmd.addString("subscribe");
+        cmd.addString(target);
+        filter.toBottle(cmd);
+        subscribed = port.write(cmd);
+        return subscribed;
+    }
+
+    /// \brief go back to receiving the full stream
+    bool release()
+    {
+        if(!subscribed) return true;
+        yarp::os::Bottle cmd;
+        cmd.addString("unsubscribe");
+        cmd.addString(target);
+        subscribed = false;
+        return port.write(cmd);
+    }
+
+    void close()
+    {
+        release();
+        port.close();
+    }
+
+};
+
+}
+
+#endif
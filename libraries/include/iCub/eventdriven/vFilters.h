@@ -19,43 +19,116 @@
 #ifndef __VFILTER__
 #define __VFILTER__
 
-#include <yarp/sig/Image.h>
+#include <yarp/os/all.h>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "iCub/eventdriven/vtsHelper.h"
 
 namespace ev {
 
-/// \brief an efficient event-based salt and pepper filter
+/// \brief the bit positions of a raw [stamp, address] event pair, used to
+/// filter blocks of events without decoding them into event objects
+struct vRawLayout
+{
+    unsigned int x_shift;
+    unsigned int x_mask;
+    unsigned int y_shift;
+    unsigned int y_mask;
+    unsigned int p_shift;
+    unsigned int c_shift;
+    std::uint32_t stamp_mask;
+
+    /// \brief ATIS 24 bit encoding (CODEC_304x240_24)
+    static vRawLayout codec304x240_24()
+    {
+        vRawLayout l = {1, 0x1FF, 12, 0xFF, 0, 22, vtsHelper::max_stamp};
+        return l;
+    }
+
+    /// \brief ATIS 20 bit encoding (CODEC_304x240_20)
+    static vRawLayout codec304x240_20()
+    {
+        vRawLayout l = {1, 0x1FF, 10, 0xFF, 0, 20, vtsHelper::max_stamp};
+        return l;
+    }
+};
+
+/// \brief an efficient event-based salt and pepper filter. The last stamp of
+/// each pixel is stored in one contiguous, padded int32 plane per
+/// channel/polarity such that the neighbourhood is scanned row by row in
+/// memory order.
 class vNoiseFilter
 {
 private:
 
     int Tsize;
     int Ssize;
+    int width;
+    int height;
+    int stride;
+    int plane_size;
 
-    yarp::sig::ImageOf <yarp::sig::PixelInt> TSleftL;
-    yarp::sig::ImageOf <yarp::sig::PixelInt> TSleftH;
-    yarp::sig::ImageOf <yarp::sig::PixelInt> TSrightL;
-    yarp::sig::ImageOf <yarp::sig::PixelInt> TSrightH;
+    std::vector<std::int32_t> planes;
+    vRawLayout layout;
+
+    /// \brief set the stamp of the cell and search the neighbourhood for
+    /// support. Each row is compared in full (without branches, so it can be
+    /// vectorised) and the search ends at the first row with support.
+    bool support(std::int32_t *cell, std::int32_t ts)
+    {
+        *cell = ts;
+
+        //0 < dt < Tsize in a single unsigned comparison. The stamp difference
+        //is taken modulo the stamp range so wraps need no correction.
+        const std::uint32_t limit = Tsize - 1;
+        const std::uint32_t mask = layout.stamp_mask;
+        const int n = 2 * Ssize + 1;
+
+        const std::int32_t *row = cell - Ssize * stride - Ssize;
+        for(int yi = 0; yi < n; yi++, row += stride) {
+            unsigned int found = 0;
+            for(int xi = 0; xi < n; xi++)
+                found |= ((((std::uint32_t)ts - row[xi]) & mask) - 1) < limit;
+            if(found) return true;
+        }
+
+        return false;
+    }
+
+    std::int32_t *cell(int x, int y, int p, int c)
+    {
+        return planes.data() + (2 * c + p) * plane_size +
+                (y + Ssize) * stride + x + Ssize;
+    }
 
 public:
 
     /// \brief constructor
-    vNoiseFilter() : Tsize(0), Ssize(0) {}
+    vNoiseFilter() : Tsize(0), Ssize(0), width(0), height(0), stride(0),
+        plane_size(0)
+    {
+        layout = vRawLayout::codec304x240_24();
+    }
 
     /// \brief initialise the sensor size and the filter parameters.
     void initialise(double width, double height, int Tsize, unsigned int Ssize)
     {
-        TSleftL.resize(width + 2 * Ssize, height + 2 * Ssize);
-        TSleftH.resize(width + 2 * Ssize, height + 2 * Ssize);
-        TSrightL.resize(width + 2 * Ssize, height + 2 * Ssize);
-        TSrightH.resize(width + 2 * Ssize, height + 2 * Ssize);
-
-        TSleftL.zero();
-        TSleftH.zero();
-        TSrightL.zero();
-        TSrightH.zero();
-
+        this->width = width;
+        this->height = height;
         this->Tsize = Tsize;
         this->Ssize = Ssize;
+
+        stride = width + 2 * Ssize;
+        plane_size = stride * (height + 2 * Ssize);
+        planes.assign(4 * plane_size, 0);
+    }
+
+    /// \brief set the bit layout used by filter() to decode raw events. The
+    /// stamp mask also sets the range at which stamps wrap.
+    void setRawLayout(const vRawLayout &layout)
+    {
+        this->layout = layout;
     }
 
     /// \brief classifies the event as noise or signal
@@ -63,48 +136,240 @@ public:
     bool check(int x, int y, int p, int c, int ts)
     {
         if(!Ssize) return false;
+        if(c < 0 || c > 1 || p < 0 || p > 1) return false;
 
-        yarp::sig::ImageOf<yarp::sig::PixelInt> *active = 0;
-        if(c == 0) {
-            if(p == 0) {
-                active = &TSleftL;
-            } else if(p == 1) {
-                active = &TSleftH;
-            }
-        } else if(c == 1) {
-            if(p == 0) {
-                active = &TSrightL;
-            } else if(p == 1) {
-                active = &TSrightH;
-            }
+        return support(cell(x, y, p, c), ts);
+    }
+
+    /// \brief filters a block of raw [stamp, address] pairs in place. Events
+    /// that are noise, or outside the sensor, are removed and the remaining
+    /// events are packed at the start of the block.
+    /// \returns the number of events kept
+    unsigned int filter(std::int32_t *data, unsigned int n_events)
+    {
+        if(!Ssize) return 0;
+
+        unsigned int k = 0;
+        for(unsigned int i = 0; i < n_events; i++) {
+
+            std::int32_t ts = data[2 * i] & layout.stamp_mask;
+            std::int32_t a = data[2 * i + 1];
+            int x = (a >> layout.x_shift) & layout.x_mask;
+            int y = (a >> layout.y_shift) & layout.y_mask;
+            int p = (a >> layout.p_shift) & 0x01;
+            int c = (a >> layout.c_shift) & 0x01;
+
+            if(x >= width || y >= height) continue;
+            if(!support(cell(x, y, p, c), ts)) continue;
+
+            data[2 * k] = data[2 * i];
+            data[2 * k + 1] = a;
+            k++;
         }
-        if(!active) return false;
 
-        x += Ssize;
-        y += Ssize;
+        return k;
+    }
 
+};
 
-        bool add = false;
-        (*active)(x, y) = ts;
-        for(int xi = x - Ssize; xi <= x + Ssize; xi++) {
-            for(int yi = y - Ssize; yi <= y + Ssize; yi++) {
-                int dt = ts - (*active)(xi, yi);
-                if(dt < 0) {
-                    dt += vtsHelper::max_stamp;
-                    (*active)(xi, yi) -= vtsHelper::max_stamp;
-                }
-                if(dt && dt < Tsize) {
-                    add = true;
-                    break;
+/// \brief runs a vNoiseFilter over raw event blocks on its own thread, such
+/// that the producer only pays for a copy. Filtered blocks are given to
+/// output(). At most max_events are queued, further events are dropped.
+class vNoiseFilterStage : public yarp::os::Thread
+{
+private:
+
+    vNoiseFilter &thefilter;
+    std::vector<std::int32_t> incoming;
+    std::vector<std::int32_t> working;
+    unsigned int n_incoming;
+    unsigned int n_dropped;
+
+    yarp::os::Mutex m;
+    yarp::os::Semaphore signal;
+
+protected:
+
+    /// \brief called on the stage thread with the filtered events
+    virtual void output(const std::int32_t *data, unsigned int n_events) = 0;
+
+public:
+
+    vNoiseFilterStage(vNoiseFilter &thefilter, unsigned int max_events) :
+        thefilter(thefilter), n_incoming(0), n_dropped(0), signal(0)
+    {
+        incoming.resize(2 * max_events);
+        working.resize(2 * max_events);
+    }
+
+    /// \brief copy a block of raw events to be filtered
+    void push(const std::int32_t *data, unsigned int n_events)
+    {
+        m.lock();
+        unsigned int space = incoming.size() / 2 - n_incoming;
+        if(n_events > space) {
+            n_dropped += n_events - space;
+            n_events = space;
+        }
+        std::copy(data, data + 2 * n_events,
+                  incoming.begin() + 2 * n_incoming);
+        n_incoming += n_events;
+        m.unlock();
+        signal.post();
+    }
+
+    /// \brief the number of events dropped because the stage was full
+    unsigned int getDropped()
+    {
+        m.lock();
+        unsigned int n = n_dropped;
+        n_dropped = 0;
+        m.unlock();
+        return n;
+    }
+
+    void run()
+    {
+        while(!isStopping()) {
+
+            signal.wait();
+
+            m.lock();
+            incoming.swap(working);
+            unsigned int n = n_incoming;
+            n_incoming = 0;
+            m.unlock();
+
+            if(!n) continue;
+            n = thefilter.filter(working.data(), n);
+            if(n) output(working.data(), n);
+        }
+    }
+
+    void onStop()
+    {
+        signal.post();
+    }
+
+};
+
+/// \brief a look-up table from the sensor address (channel, y, x) of an event
+/// to its output address, packed as (y << 16 | x). Flips, undistortion,
+/// truncation and masks are folded in when the table is built, such that
+/// all the geometric processing of an event is a single load. Dropped
+/// addresses hold vRemapTable::drop.
+class vRemapTable
+{
+private:
+
+    int width;
+    int height;
+    std::vector<std::uint32_t> table;
+
+    static std::uint32_t pack(int x, int y)
+    {
+        return ((std::uint32_t)y & 0xFFFF) << 16 | ((std::uint32_t)x & 0xFFFF);
+    }
+
+    static int unpackX(std::uint32_t entry)
+    {
+        return (std::int16_t)(entry & 0xFFFF);
+    }
+
+    static int unpackY(std::uint32_t entry)
+    {
+        return (std::int16_t)(entry >> 16);
+    }
+
+public:
+
+    static const std::uint32_t drop = 0xFFFFFFFF;
+
+    /// \brief constructor
+    vRemapTable() : width(0), height(0) {}
+
+    /// \brief an identity table of two channels of the sensor size, with
+    /// the flips applied
+    void initialise(int width, int height, bool flipx = false,
+                    bool flipy = false)
+    {
+        this->width = width;
+        this->height = height;
+        table.resize(2 * width * height);
+        for(int c = 0; c < 2; c++) {
+            for(int y = 0; y < height; y++) {
+                for(int x = 0; x < width; x++) {
+                    table[(c * height + y) * width + x] =
+                            pack(flipx ? width - 1 - x : x,
+                                 flipy ? height - 1 - y : y);
                 }
             }
         }
+    }
 
-        return add;
+    /// \brief compose the table with a map of a channel: the current output
+    /// (x, y) becomes (map[2 * (y * width + x)], map[2 * (y * width + x) + 1]).
+    /// If truncate, addresses mapped outside of the sensor are dropped.
+    void compose(int channel, const std::int32_t *map, bool truncate)
+    {
+        std::uint32_t *entry = table.data() + channel * width * height;
+        for(int i = 0; i < width * height; i++, entry++) {
+            if(*entry == drop) continue;
+            int x = unpackX(*entry), y = unpackY(*entry);
+            if(x < 0 || x >= width || y < 0 || y >= height) {
+                *entry = drop;
+                continue;
+            }
+            const std::int32_t *m = map + 2 * (y * width + x);
+            if(truncate && (m[0] < 0 || m[0] >= width ||
+                            m[1] < 0 || m[1] >= height))
+                *entry = drop;
+            else
+                *entry = pack(m[0], m[1]);
+        }
     }
 
-};
+    /// \brief drop the events of a sensor address (e.g. a hot pixel). The
+    /// entry is a single aligned 32 bit store, so a lookup() running on
+    /// another thread sees either the old or the dropped address.
+    void mask(int channel, int x, int y)
+    {
+        if(!inside(channel, x, y)) return;
+        table[(channel * height + y) * width + x] = drop;
+    }
 
+    /// \brief drop the events whose output address is outside of the region
+    /// x0 <= x <= x1, y0 <= y <= y1
+    void crop(int x0, int y0, int x1, int y1)
+    {
+        for(std::vector<std::uint32_t>::iterator e = table.begin();
+            e != table.end(); e++) {
+            if(*e == drop) continue;
+            int x = unpackX(*e), y = unpackY(*e);
+            if(x < x0 || x > x1 || y < y0 || y > y1)
+                *e = drop;
+        }
+    }
+
+    /// \brief true if the sensor address is in the table
+    bool inside(int channel, int x, int y) const
+    {
+        return (unsigned int)channel < 2 && (unsigned int)x < (unsigned int)width
+                && (unsigned int)y < (unsigned int)height;
+    }
+
+    /// \brief the output address of an event, or false if it is dropped. The
+    /// sensor address must be inside() the table.
+    bool lookup(int channel, int &x, int &y) const
+    {
+        std::uint32_t entry = table[(channel * height + y) * width + x];
+        if(entry == drop) return false;
+        x = unpackX(entry);
+        y = unpackY(entry);
+        return true;
+    }
+
+};
 
 }
 
@@ -0,0 +1,109 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VHOTPIXELS__
+#define __VHOTPIXELS__
+
+#include <yarp/os/all.h>
+#include "iCub/eventdriven/vFilters.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ev {
+
+/// \brief detects pixels that fire persistently faster than the rest of the
+/// sensor and masks them. The events are counted by count() at O(1) per
+/// event. Every period the counts are handed to a side thread that compares
+/// each pixel to the mean rate of the sensor: a pixel over the threshold for
+/// a number of periods in a row is hot. Hot pixels are dropped in a
+/// vRemapTable by the next update() and saved to a file, one "channel x y"
+/// line each, such that they are masked from the start of the next run with
+/// the same sensor.
+class vHotPixels : public yarp::os::Thread
+{
+private:
+
+    //parameters
+    int width;
+    int height;
+    double period;
+    double factor;
+    double min_rate;
+    unsigned int persistence;
+    std::string file;
+
+    //owned by the thread calling count() and update()
+    std::vector<std::uint32_t> counts;
+    unsigned int n_masked;
+    double last_handover;
+
+    //owned by the analysis thread
+    std::vector<std::uint32_t> analysing;
+    std::vector<std::uint8_t> streak;
+    std::vector<std::uint8_t> hot;
+    double elapsed;
+
+    //exchanged under the mutex
+    yarp::os::Mutex m;
+    yarp::os::Semaphore wake;
+    std::vector<int> found;
+    bool busy;
+
+    bool load();
+    bool save();
+
+public:
+
+    vHotPixels();
+
+    /// \brief set the sensor size (two channels) and the detection
+    /// parameters, and mask the pixels saved in the file (if any)
+    /// \param period seconds of counts analysed together
+    /// \param factor a pixel is over the threshold at factor times the mean
+    /// rate of the sensor...
+    /// \param min_rate ...and at least min_rate events per second
+    /// \param persistence periods in a row over the threshold to be hot
+    /// \param file the hot pixels of the sensor ("" to not save them)
+    void initialise(int width, int height, double period = 2.0,
+                    double factor = 20.0, double min_rate = 20.0,
+                    unsigned int persistence = 3,
+                    const std::string &file = "");
+
+    /// \brief count the event. The address must be inside the sensor.
+    inline void count(int channel, int x, int y)
+    {
+        counts[(channel * height + y) * width + x]++;
+    }
+
+    /// \brief mask the hot pixels found (and loaded) in the table and, each
+    /// period, hand the counts over to be analysed. Called by the thread
+    /// calling count().
+    void update(double now, vRemapTable &table);
+
+    /// \brief the number of pixels masked
+    unsigned int masked() { return n_masked; }
+
+    void run();
+    void onStop();
+
+};
+
+}
+
+#endif
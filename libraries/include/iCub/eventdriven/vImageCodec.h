@@ -0,0 +1,122 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VIMAGECODEC__
+#define __VIMAGECODEC__
+
+#include <yarp/os/all.h>
+#include <string>
+#include <vector>
+
+namespace ev {
+
+/// \brief a compressed BGR image, sent as a Bottle:
+/// (format width height {data})
+class vEncodedImage : public yarp::os::Portable
+{
+public:
+
+    std::string format;
+    int width;
+    int height;
+    std::vector<unsigned char> data;
+
+    vEncodedImage() : width(0), height(0) {}
+
+    bool read(yarp::os::ConnectionReader &connection);
+    bool write(yarp::os::ConnectionWriter &connection) const;
+
+};
+
+/// \brief compress a BGR image that is mostly a single background colour
+/// (e.g. an event frame) as runs of background and runs of coloured pixels
+void encodeSparse(const unsigned char *bgr, int width, int height, int step,
+                  std::vector<unsigned char> &out,
+                  unsigned char background = 255);
+
+/// \brief decompress a sparse image into a BGR image of width*height pixels
+/// \returns false if the data is corrupt
+bool decodeSparse(const std::vector<unsigned char> &in, int width,
+                  int height, int step, unsigned char *bgr);
+
+/// \brief a function compressing a BGR image in a given format (e.g. jpg or
+/// png with OpenCV) for formats the library does not provide
+typedef bool (*vImageCodec)(const unsigned char *bgr, int width, int height,
+                            int step, const std::string &format, int quality,
+                            std::vector<unsigned char> &out);
+
+/// \brief compresses images on its own thread and sends them on a port.
+/// Only the newest image waits to be compressed: an image given while the
+/// previous one is compressed replaces it, so the caller never waits.
+class vImageEncoder : public yarp::os::Thread
+{
+private:
+
+    yarp::os::Port port;
+    std::string format;
+    int quality;
+    vImageCodec codec;
+
+    yarp::os::Mutex m;
+    yarp::os::Semaphore wake;
+    std::vector<unsigned char> pending;
+    std::vector<unsigned char> working;
+    int width;
+    int height;
+    bool has_pending;
+    yarp::os::Stamp stamp;
+    unsigned int n_dropped;
+
+    vEncodedImage encoded;
+
+public:
+
+    vImageEncoder();
+
+    /// \brief open the output port. The format is "sparse", or any format
+    /// the codec compresses (quality is passed to the codec)
+    bool open(const std::string &name, const std::string &format,
+              int quality = 90, vImageCodec codec = 0);
+    void close();
+
+    /// \brief true if anyone is reading the compressed images
+    bool isConnected();
+
+    /// \brief copy a BGR image (step bytes per row) to be compressed
+    void send(const unsigned char *bgr, int width, int height, int step,
+              const yarp::os::Stamp &stamp);
+
+    /// \brief the number of images replaced before being compressed
+    unsigned int dropped() { return n_dropped; }
+
+    void run();
+    void onStop();
+
+};
+
+/// \brief decompress an image into a BGR image of data.width*data.height
+/// pixels (step bytes per row). Formats other than sparse use the codec
+/// (e.g. cv::imdecode).
+typedef bool (*vImageDecodec)(const vEncodedImage &encoded, unsigned char *bgr,
+                              int step);
+bool decodeImage(const vEncodedImage &encoded, unsigned char *bgr, int step,
+                 vImageDecodec codec = 0);
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VIMAGECODECCV__
+#define __VIMAGECODECCV__
+
+//the OpenCV codecs of vImageEncoder and decodeImage. The library does not
+//depend on OpenCV, so this header is not included by all.h: modules linking
+//OpenCV include it themselves.
+
+#include "iCub/eventdriven/vImageCodec.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace ev {
+
+/// \brief compress a BGR image with OpenCV (jpg or png), as the vImageCodec
+/// of a vImageEncoder. The quality (0-100) sets the jpg quality or the png
+/// compression.
+inline bool cvEncodeImage(const unsigned char *bgr, int width, int height,
+                          int step, const std::string &format, int quality,
+                          std::vector<unsigned char> &out)
+{
+    cv::Mat image(height, width, CV_8UC3, (void *)bgr, step);
+    std::vector<int> params;
+    if(format == "jpg" || format == "jpeg") {
+        params.push_back(cv::IMWRITE_JPEG_QUALITY);
+        params.push_back(quality);
+    } else if(format == "png") {
+        //quality 0-100 to compression 9-0
+        params.push_back(cv::IMWRITE_PNG_COMPRESSION);
+        params.push_back(std::max(0, std::min(9, 9 - quality / 11)));
+    }
+    return cv::imencode("." + format, image, out, params);
+}
+
+/// \brief decompress a jpg or png image with OpenCV, as the vImageDecodec of
+/// decodeImage
+/// \returns false if the image is not of the size given in the encoding
+inline bool cvDecodeImage(const vEncodedImage &encoded, unsigned char *bgr,
+                          int step)
+{
+    cv::Mat image = cv::imdecode(encoded.data, cv::IMREAD_COLOR);
+    if(image.cols != encoded.width || image.rows != encoded.height)
+        return false;
+    cv::Mat output(encoded.height, encoded.width, CV_8UC3, bgr, step);
+    image.copyTo(output);
+    return true;
+}
+
+}
+
+#endif
@@ -0,0 +1,190 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VLOG__
+#define __VLOG__
+
+#include <yarp/os/all.h>
+#include "iCub/eventdriven/vtsHelper.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ev {
+
+/// \brief the binary event log layout. A log is:
+/// [vLogFileHeader] [vLogChunkHeader data]... [vLogIndexEntry]... [vLogFooter]
+/// where each data block is the raw int32 block of the vPort wire format,
+/// padded to 8 bytes. The sparse index and footer are written on close; a log
+/// without them (e.g. after a crash) is read by scanning the chunk headers.
+struct vLogFileHeader
+{
+    char magic[8];              //"EVLOG\0\0\0"
+    std::uint32_t version;
+    std::uint32_t timer_bits;   //stamps wrap at 2^timer_bits
+    double tsscaler;            //seconds per stamp tick
+    std::uint64_t reserved;
+};
+
+/// \brief the header preceeding each block of events
+struct vLogChunkHeader
+{
+    std::uint32_t magic;        //vLogChunkHeader::chunk_magic
+    std::uint32_t n_ints;       //number of int32 in the block (no padding)
+    char tag[8];                //event-type, NUL padded
+    std::uint32_t first_stamp;  //stamp of the first event (as on the wire)
+    std::uint32_t last_stamp;   //stamp of the last event (as on the wire)
+    std::uint32_t wraps;        //wraps counted before the first event
+    std::int32_t envelope_count;
+    std::uint64_t first_time;   //unwrapped stamp of the first event
+    std::uint64_t last_time;    //unwrapped stamp of the last event
+    double envelope_time;
+
+    static const std::uint32_t chunk_magic = 0x48435645; //"EVCH"
+};
+
+/// \brief one entry of the sparse time index
+struct vLogIndexEntry
+{
+    std::uint64_t time;         //unwrapped stamp of the first event
+    std::uint64_t offset;       //file offset of the chunk header
+};
+
+/// \brief the last bytes of a closed log
+struct vLogFooter
+{
+    std::uint64_t n_entries;
+    std::uint64_t index_offset;
+    std::uint64_t last_chunk;   //file offset of the last chunk header
+    char magic[8];              //"EVINDEX\0"
+};
+
+/// \brief a chunk of events in a mapped log. The pointers are valid while
+/// the vLogReader is open.
+struct vLogChunk
+{
+    const vLogChunkHeader *header;
+    const std::int32_t *data;
+
+    std::string tag() const;
+    yarp::os::Stamp envelope() const;
+};
+
+/// \brief appends blocks of raw events to a binary log. Only a single
+/// system call is made per block, so the writer can keep up with a grabber.
+class vLogWriter
+{
+private:
+
+    int fd;
+    bool valid; //the log was opened, and close() can write the index
+    std::uint64_t offset;
+    std::uint64_t last_chunk;
+    double index_period;
+    std::uint64_t next_index_time;
+    std::vector<vLogIndexEntry> index;
+    vtsHelper unwrapper;
+
+    bool resume(const std::string &path);
+
+    /// \brief close the file without writing to it (e.g. on a failed open)
+    void abandon();
+
+public:
+
+    vLogWriter();
+    ~vLogWriter();
+
+    /// \brief open a log. If append is set and the log already exists, new
+    /// chunks are added after the existing ones (the index is re-read).
+    bool open(const std::string &path, bool append = false);
+
+    /// \brief add an index entry at most every period seconds of event time
+    void setIndexPeriod(double period);
+
+    /// \brief append a block of encoded events (as on the vPort wire)
+    bool write(const std::string &tag, const std::int32_t *data,
+               unsigned int n_ints, const yarp::os::Stamp &envelope);
+
+    /// \brief write the index and close the log
+    bool close();
+
+    bool isOpen() { return fd >= 0; }
+
+};
+
+/// \brief memory maps a binary log. Chunks are accessed without copying and
+/// seek() finds a time in O(log n) using the sparse index.
+class vLogReader
+{
+private:
+
+    const char *map;
+    std::uint64_t map_size;
+    std::uint64_t data_end;
+    std::uint64_t last_chunk;
+    std::uint64_t cursor;
+    std::vector<vLogIndexEntry> index;
+
+    bool validChunk(std::uint64_t pos) const;
+    void buildIndex();
+
+    friend class vLogWriter;
+
+public:
+
+    vLogReader();
+    ~vLogReader();
+
+    /// \brief map a log and read (or re-build) its index
+    bool open(const std::string &path);
+    void close();
+
+    /// \brief get the chunk at the cursor and advance it
+    /// \returns false at the end of the log
+    bool next(vLogChunk &chunk);
+
+    /// \brief move the cursor to the first chunk containing events at, or
+    /// after, the unwrapped stamp
+    bool seek(std::uint64_t time);
+
+    /// \brief move the cursor to the start of the log
+    void rewind();
+
+    /// \brief the unwrapped stamp of the first and last events in the log
+    std::uint64_t firstTime() const;
+    std::uint64_t lastTime() const;
+
+    bool isOpen() { return map != 0; }
+
+};
+
+/// \brief convert a yarpdatadumper data.log into a binary event log
+bool convertDataLog(const std::string &textlog, const std::string &binlog);
+
+/// \brief true if the file is a binary event log
+bool isBinaryLog(const std::string &file);
+
+/// \brief get a binary event log for a file. A yarpdatadumper data.log is
+/// converted (once) to data.log.evlog alongside it.
+/// \returns the binary log path, or an empty string on failure
+std::string findBinaryLog(const std::string &file);
+
+}
+
+#endif
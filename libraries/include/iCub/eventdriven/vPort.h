@@ -23,6 +23,7 @@
 #include <yarp/os/all.h>
 #include "iCub/eventdriven/vCodec.h"
 #include "iCub/eventdriven/vtsHelper.h"
+#include "iCub/eventdriven/vTrace.h"
 
 using namespace yarp::os;
 
@@ -271,6 +272,20 @@ protected:
 
     vGenPortInterface internal_storage;
     Port port;
+    vTrace out_trace;
+
+    /// \brief use the trace as the envelope, recording the time it was sent.
+    /// An untraced packet is sent with a plain Stamp.
+    bool setEnvelope(const vTrace &trace)
+    {
+        if(!trace.isTraced()) {
+            Stamp envelope = trace.stamp;
+            return port.setEnvelope(envelope);
+        }
+        out_trace = trace;
+        out_trace.sent(Time::now());
+        return port.setEnvelope(out_trace);
+    }
 
 public:
 
@@ -300,6 +315,39 @@ public:
 
     }
 
+    /// \brief send a block of already encoded events (of the type set with
+    /// setWriteType) without copying it
+    bool write(const std::int32_t *data, unsigned int n_ints, Stamp envelope)
+    {
+        internal_storage.setExternalData((const char *)data,
+                                         n_ints * sizeof(std::int32_t));
+        if(!port.setEnvelope(envelope))
+            return false;
+        if(!port.write(internal_storage))
+            return false;
+        return true;
+    }
+
+    /// \brief send a vQueue continuing the trace of the packet it came from
+    bool write(const vQueue &q, const vTrace &trace)
+    {
+        internal_storage.setInternalData(q);
+        if(!setEnvelope(trace))
+            return false;
+        return port.write(internal_storage);
+    }
+
+    /// \brief send a block of encoded events continuing (or starting) a trace
+    bool write(const std::int32_t *data, unsigned int n_ints,
+               const vTrace &trace)
+    {
+        internal_storage.setExternalData((const char *)data,
+                                         n_ints * sizeof(std::int32_t));
+        if(!setEnvelope(trace))
+            return false;
+        return port.write(internal_storage);
+    }
+
     int getOutputCount() {
         return port.getOutputCount();
     }
@@ -317,6 +365,7 @@ protected:
 public:
     using vGenWritePort::open;
     using vGenWritePort::close;
+    using vGenWritePort::getOutputCount;
 
     bool write(const std::deque<T> &q, Stamp envelope)
     {
@@ -329,6 +378,15 @@ public:
 
     }
 
+    /// \brief send a queue continuing the trace of the packet it came from
+    bool write(const std::deque<T> &q, const vTrace &trace)
+    {
+        internal_storage.setInternalData(q);
+        if(!setEnvelope(trace))
+            return false;
+        return port.write(internal_storage);
+    }
+
 };
 
 /// \brief an asynchronous reading port that accepts vBottles and decodes them
@@ -340,8 +398,9 @@ protected:
     Port port;
 
     std::deque< vQueue* > qq;
-    std::deque<yarp::os::Stamp> sq;
+    std::deque<vTrace> sq;
     vQueue *working_queue;
+    std::string name;
 
     yarp::os::Mutex m;
     yarp::os::Semaphore dataavailable;
@@ -386,6 +445,7 @@ public:
             yError() << "Could not open vGenReadPort input port: " << name;
             return false;
         }
+        this->name = name;
         start();
         return true;
     }
@@ -411,8 +471,9 @@ public:
                 break;
             }
 
-            yarp::os::Stamp yarp_stamp;
-            port.getEnvelope(yarp_stamp);
+            vTrace trace;
+            port.getEnvelope(trace);
+            trace.received(name, Time::now());
 
             if(qlimit && qq.size() >= qlimit) {
                 delete next_queue;
@@ -422,7 +483,7 @@ public:
             m.lock();
 
             qq.push_back(next_queue);
-            sq.push_back(yarp_stamp);
+            sq.push_back(trace);
 
             delay_nv += qq.back()->size();
             int dt = qq.back()->back()->stamp - qq.back()->front()->stamp;
@@ -458,7 +519,7 @@ public:
         dataavailable.wait();
 
         if(qq.size()) {
-            yarpstamp = sq.front();
+            yarpstamp = sq.front().stamp;
             working_queue = qq.front();
         }  else {
             working_queue =  0;
@@ -468,6 +529,15 @@ public:
 
     }
 
+    /// \brief ask for a pointer to the next vQueue and the trace of the packet
+    /// it arrived in. Blocks if no data is ready.
+    const vQueue* read(vTrace &trace)
+    {
+        const vQueue *q = read(trace.stamp);
+        if(q) trace = sq.front();
+        return q;
+    }
+
     /// \brief set the maximum number of qs that can be stored in the buffer.
     /// A value of 0 keeps all qs.
     void setQLimit(unsigned int number_of_qs)
@@ -564,8 +634,9 @@ public:
                 break;
             }
 
-            yarp::os::Stamp yarp_stamp;
-            port.getEnvelope(yarp_stamp);
+            vTrace trace;
+            port.getEnvelope(trace);
+            trace.received(name, Time::now());
 
             if(qlimit && qq.size() >= qlimit) {
                 delete next_queue;
@@ -575,7 +646,7 @@ public:
             m.lock();
 
             qq.push_back(next_queue);
-            sq.push_back(yarp_stamp);
+            sq.push_back(trace);
 
             delay_nv += qq.back()->size();
             int dt = qq.back()->back().stamp - qq.back()->front().stamp;
@@ -615,7 +686,7 @@ public:
         dataavailable.wait();
 
         if(qq.size()) {
-            yarpstamp = sq.front();
+            yarpstamp = sq.front().stamp;
             working_queue = qq.front();
         }  else {
             working_queue =  0;
@@ -624,6 +695,15 @@ public:
 
     }
 
+    /// \brief ask for a pointer to the next vector and the trace of the
+    /// packet it arrived in. Blocks if no data is ready.
+    const std::vector<T>* read(vTrace &trace)
+    {
+        const std::vector<T> *q = read(trace.stamp);
+        if(q) trace = sq.front();
+        return q;
+    }
+
     using vGenReadPort::setQLimit;
     using vGenReadPort::releaseDataLock;
     using vGenReadPort::queryunprocessed;
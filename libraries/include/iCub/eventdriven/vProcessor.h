@@ -0,0 +1,43 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VPROCESSOR__
+#define __VPROCESSOR__
+
+#include "iCub/eventdriven/vCodec.h"
+
+namespace ev {
+
+/// \brief the port-free core of a processing module. A module wraps its
+/// vProcessor with ports and threads, while offline tools (ev-offline) call
+/// process() directly on recorded data.
+class vProcessor
+{
+public:
+
+    virtual ~vProcessor() {}
+
+    /// \brief process a batch of events in temporal order. Any resulting
+    /// events are appended to out.
+    virtual void process(const vQueue &in, vQueue &out) = 0;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VPYRAMID__
+#define __VPYRAMID__
+
+#include "iCub/eventdriven/vCodec.h"
+#include <deque>
+#include <vector>
+
+namespace ev {
+
+/// \brief downsamples the address events to 1/2, 1/4 ... 1/2^levels of the
+/// sensor resolution. The address of an event at level l is (x >> l, y >> l)
+/// and each cell (channel, polarity, y, x) of a level suppresses the events
+/// falling into it, either:
+/// - REFRACTORY: an event is kept if the cell has not fired for a period
+/// - INTEGRATE: the cell counts events, leaking one event each leak period,
+/// and fires (resetting the count) when the count reaches the threshold
+/// All levels are produced from a single pass over the input.
+class vPyramid
+{
+public:
+
+    enum suppression { REFRACTORY, INTEGRATE };
+
+private:
+
+    struct cell {
+        unsigned int stamp;
+        float potential; //the count, or 1 if a REFRACTORY cell has fired
+    };
+
+    struct level {
+        int shift;
+        int width;
+        int height;
+        std::vector<cell> cells;
+    };
+
+    int width;
+    int height;
+    std::vector<level> pyramid;
+
+    suppression mode;
+    int refractory;
+    float threshold;
+    float leak;
+
+    /// \brief update the cells of each level the event falls into
+    /// \returns the levels that keep the event (bit l - 1 for level l)
+    inline unsigned int fire(const AE &v)
+    {
+        typedef stampTraits<AE> st;
+        unsigned int kept = 0;
+        if((int)v.x >= width || (int)v.y >= height) return kept;
+
+        for(unsigned int l = 0; l < pyramid.size(); l++) {
+            level &lv = pyramid[l];
+            cell &c = lv.cells[(((v.channel << 1) | v.polarity) * lv.height +
+                    (v.y >> lv.shift)) * lv.width + (v.x >> lv.shift)];
+            int dt = st::delta(v.stamp, c.stamp);
+            if(mode == REFRACTORY) {
+                if(c.potential && dt < refractory) continue;
+                c.potential = 1.0f;
+                c.stamp = v.stamp;
+                kept |= 1 << l;
+            } else {
+                float p = c.potential - dt * leak;
+                p = (p > 0.0f ? p : 0.0f) + 1.0f;
+                if(p >= threshold) {
+                    p = 0.0f;
+                    kept |= 1 << l;
+                }
+                c.potential = p;
+                c.stamp = v.stamp;
+            }
+        }
+        return kept;
+    }
+
+public:
+
+    /// \brief constructor
+    vPyramid();
+
+    /// \brief set the sensor size (two channels) and the number of levels
+    /// (1/2 to 1/2^levels). All cells are cleared.
+    void initialise(int width, int height, unsigned int levels = 3);
+
+    /// \brief keep an event if its cell has not fired for period seconds
+    void setRefractory(double period);
+
+    /// \brief keep one event in every threshold events of a cell, with the
+    /// count of the cell reduced by one event every leak seconds
+    void setIntegrate(double threshold, double leak);
+
+    /// \brief the number of levels
+    unsigned int levels() { return pyramid.size(); }
+
+    /// \brief the resolution of a level (1 is half the sensor)
+    resolution levelSize(unsigned int l);
+
+    /// \brief append the events kept by each level to out[l - 1], with the
+    /// addresses of the level
+    void process(const std::vector<AE> &in, std::vector< std::deque<AE> > &out);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VSTATS__
+#define __VSTATS__
+
+#include <yarp/os/all.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace ev {
+
+/// \brief a lock-free log-linear histogram of durations. Each power of two
+/// is split into 16 linear buckets (< 6.25% error) from 1 ns to 2^41 ns
+/// (~36.6 minutes, the last power of two starting at ~18.3 minutes). Longer
+/// durations are counted in the last bucket.
+/// Any thread can record() while a single reader periodically drain()s.
+class vHistogram
+{
+public:
+
+    static const unsigned int sub_bits = 4;
+    static const unsigned int sub_buckets = 1 << sub_bits;
+    static const unsigned int n_buckets = 38 * sub_buckets;
+
+    /// \brief the content of the histogram since the previous drain
+    struct snapshot {
+        std::vector<std::uint64_t> counts;
+        std::uint64_t count;
+        std::uint64_t max_ns;
+        double sum_ns;
+
+        /// \brief the duration (in seconds) below which fraction p of the
+        /// samples lie (upper bound of the bucket)
+        double percentile(double p) const;
+        double max() const { return max_ns * 1e-9; }
+        double mean() const { return count ? sum_ns * 1e-9 / count : 0.0; }
+    };
+
+private:
+
+    std::atomic<std::uint64_t> counts[n_buckets];
+    std::atomic<std::uint64_t> max_ns;
+    std::atomic<std::uint64_t> sum_ns;
+
+public:
+
+    vHistogram();
+
+    static unsigned int bucket(std::uint64_t ns)
+    {
+        if(ns < sub_buckets) return ns;
+        unsigned int e = 63 - __builtin_clzll(ns) - sub_bits;
+        unsigned int i = (e + 1) * sub_buckets + ((ns >> e) & (sub_buckets - 1));
+        return i < n_buckets ? i : n_buckets - 1;
+    }
+
+    static std::uint64_t upperBound(unsigned int i)
+    {
+        if(i < sub_buckets) return i + 1;
+        unsigned int e = i / sub_buckets - 1;
+        return ((std::uint64_t)(sub_buckets + i % sub_buckets) + 1) << e;
+    }
+
+    /// \brief record a duration in nanoseconds
+    void recordNs(std::uint64_t ns)
+    {
+        counts[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        sum_ns.fetch_add(ns, std::memory_order_relaxed);
+        std::uint64_t m = max_ns.load(std::memory_order_relaxed);
+        while(ns > m && !max_ns.compare_exchange_weak(m, ns,
+                                                      std::memory_order_relaxed));
+    }
+
+    /// \brief record a duration in seconds (e.g. a yarp::os::Time difference)
+    void record(double seconds)
+    {
+        recordNs(seconds > 0 ? (std::uint64_t)(seconds * 1e9) : 0);
+    }
+
+    /// \brief read and reset the histogram
+    snapshot drain();
+
+};
+
+/// \brief a lock-free monotonic counter (e.g. events, packets, drops)
+class vCounter
+{
+private:
+
+    std::atomic<std::uint64_t> value;
+
+public:
+
+    vCounter() : value(0) {}
+    void add(std::uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    std::uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+};
+
+/// \brief a lock-free instantaneous value (e.g. a queue depth)
+class vGauge
+{
+private:
+
+    std::atomic<std::int64_t> value;
+
+public:
+
+    vGauge() : value(0) {}
+    void set(std::int64_t v) { value.store(v, std::memory_order_relaxed); }
+    std::int64_t get() const { return value.load(std::memory_order_relaxed); }
+
+};
+
+/// \brief records the lifetime of the scope into a histogram
+class vScopedTimer
+{
+private:
+
+    vHistogram &histogram;
+    std::chrono::steady_clock::time_point start;
+
+public:
+
+    vScopedTimer(vHistogram &histogram) : histogram(histogram),
+        start(std::chrono::steady_clock::now()) {}
+    ~vScopedTimer()
+    {
+        histogram.recordNs(std::chrono::duration_cast<std::chrono::nanoseconds>
+                           (std::chrono::steady_clock::now() - start).count());
+    }
+
+};
+
+/// \brief the instrumentation of a module. Histograms, counters and gauges
+/// are created by name during set-up, and are then updated lock-free from
+/// any thread. The statistics are published periodically on a stats port as
+/// a list of groups, one per metric:
+/// (name (p50 s) (p99 s) (max s) (count n)) for histograms,
+/// (name (total n) (rate n/s)) for counters and (name (value v)) for gauges.
+class vStats : public yarp::os::RateThread
+{
+private:
+
+    template <typename T> struct metric {
+        std::string name;
+        T value;
+        std::uint64_t previous;
+    };
+
+    //deques so the addresses of the metrics never change
+    std::deque< metric<vHistogram> > histograms;
+    std::deque< metric<vCounter> > counters;
+    std::deque< metric<vGauge> > gauges;
+
+    yarp::os::BufferedPort<yarp::os::Bottle> port;
+    double ptime;
+
+public:
+
+    /// \brief publish every period seconds
+    vStats(double period = 1.0);
+
+    vHistogram & histogram(const std::string &name);
+    vCounter & counter(const std::string &name);
+    vGauge & gauge(const std::string &name);
+
+    /// \brief open the stats port (e.g. /<module>/stats:o) and start
+    /// publishing
+    bool open(const std::string &portname);
+    void close();
+
+    /// \brief fill a Bottle with the statistics since the last call
+    void fill(yarp::os::Bottle &b);
+    void run();
+
+};
+
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include <iCub/eventdriven/vWindow_adv.h>
 #include <iCub/eventdriven/vFilters.h>
 #include <iCub/eventdriven/vPort.h>
+#include <iCub/eventdriven/vClock.h>
 #include <deque>
 #include <string>
 #include <map>
@@ -341,10 +342,30 @@ private:
     double cputimeR;
     int cpudelayR;
 
+    //if set, the delay is measured against the device clock
+    vClockModel *clock;
+
+    void updateDelay(int &cpudelay, double &cputime, double cpunow,
+                     double gain)
+    {
+        if(clock && clock->isValid())
+            cpudelay = -clock->age(vstamp) * vtsHelper::vtsscaler;
+        else
+            cpudelay -= (cpunow - cputime) * vtsHelper::vtsscaler * gain;
+        cputime = cpunow;
+
+        if(cpudelay < 0) cpudelay = 0;
+        if(cpudelay > maxcpudelay) {
+            yWarning() << "CPU delay hit maximum";
+            cpudelay = maxcpudelay;
+        }
+    }
+
 public:
 
     hSurfThread()
     {
+        clock = 0;
         vstamp = 0;
         cpudelayL = cpudelayR = 0;
         cputimeL = cputimeR = yarp::os::Time::now();
@@ -358,6 +379,14 @@ public:
         surfaceright.initialise(height, width);
     }
 
+    /// \brief measure how far the surface is ahead of the current time
+    /// with a device clock model (e.g. from a vClockReader) instead of
+    /// estimating it from the rate events arrive
+    void setClock(vClockModel *clock)
+    {
+        this->clock = clock;
+    }
+
     bool open(std::string portname)
     {
         if(!allocatorCallback.open(portname))
@@ -432,27 +461,13 @@ public:
 
         if(channel == 0) {
 
-            cpudelayL -= (cpunow - cputimeL) * vtsHelper::vtsscaler * 1.1;
-            cputimeL = cpunow;
-
-            if(cpudelayL < 0) cpudelayL = 0;
-            if(cpudelayL > maxcpudelay) {
-                yWarning() << "CPU delay hit maximum";
-                cpudelayL = maxcpudelay;
-            }
+            updateDelay(cpudelayL, cputimeL, cpunow, 1.1);
 
             surfaceleft.getSurfaceN(q, cpudelayL, numEvts, r);
         }
         else {
 
-            cpudelayR -= (cpunow - cputimeR) * vtsHelper::vtsscaler * 1.1;
-            cputimeR = cpunow;
-
-            if(cpudelayR < 0) cpudelayR = 0;
-            if(cpudelayR > maxcpudelay) {
-                yWarning() << "CPU delay hit maximum";
-                cpudelayR = maxcpudelay;
-            }
+            updateDelay(cpudelayR, cputimeR, cpunow, 1.1);
 
             surfaceright.getSurfaceN(q, cpudelayR, numEvts, r);
         }
@@ -474,26 +489,12 @@ public:
 
         if(channel == 0) {
 
-            cpudelayL -= (cpunow - cputimeL) * vtsHelper::vtsscaler * 1.01;
-            cputimeL = cpunow;
-
-            if(cpudelayL < 0) cpudelayL = 0;
-            if(cpudelayL > maxcpudelay) {
-                yWarning() << "CPU delay hit maximum";
-                cpudelayL = maxcpudelay;
-            }
+            updateDelay(cpudelayL, cputimeL, cpunow, 1.01);
 
             q = surfaceleft.getSurface(cpudelayL, querySize, r, x, y);
         } else {
 
-            cpudelayR -= (cpunow - cputimeR) * vtsHelper::vtsscaler * 1.01;
-            cputimeR = cpunow;
-
-            if(cpudelayR < 0) cpudelayR = 0;
-            if(cpudelayR > maxcpudelay) {
-                yWarning() << "CPU delay hit maximum";
-                cpudelayR = maxcpudelay;
-            }
+            updateDelay(cpudelayR, cputimeR, cpunow, 1.01);
 
             q = surfaceright.getSurface(cpudelayR, querySize, r, x, y);
         }
@@ -513,27 +514,13 @@ public:
 
         if(channel == 0) {
 
-            cpudelayL -= (cpunow - cputimeL) * vtsHelper::vtsscaler * 1.01;
-            cputimeL = cpunow;
-
-            if(cpudelayL < 0) cpudelayL = 0;
-            if(cpudelayL > maxcpudelay) {
-                yWarning() << "CPU delay hit maximum";
-                cpudelayL = maxcpudelay;
-            }
+            updateDelay(cpudelayL, cputimeL, cpunow, 1.01);
 
             q = surfaceleft.getSurface(cpudelayL, querySize);
         }
         else {
 
-            cpudelayR -= (cpunow - cputimeR) * vtsHelper::vtsscaler * 1.01;
-            cputimeR = cpunow;
-
-            if(cpudelayR < 0) cpudelayR = 0;
-            if(cpudelayR > maxcpudelay) {
-                yWarning() << "CPU delay hit maximum";
-                cpudelayR = maxcpudelay;
-            }
+            updateDelay(cpudelayR, cputimeR, cpunow, 1.01);
 
             q = surfaceright.getSurface(cpudelayR, querySize);
         }
@@ -0,0 +1,76 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VTRACE__
+#define __VTRACE__
+
+#include <yarp/os/all.h>
+#include <string>
+#include <vector>
+
+namespace ev {
+
+/// \brief a packet envelope that traces the packet through the pipeline. It
+/// starts with the count and time of a yarp::os::Stamp, followed by the
+/// device time of the newest event, the wall-time the packet left the
+/// grabber, and a (name received sent) record for each module it passed:
+/// count time device_time source_time [name received sent]...
+/// A packet that is not traced is sent as a plain Stamp, and a plain Stamp
+/// is read as an untraced vTrace, so traced and untraced modules can be
+/// connected freely.
+class vTrace : public yarp::os::Portable
+{
+public:
+
+    struct hop {
+        std::string name;
+        double received;
+        double sent;
+    };
+
+    yarp::os::Stamp stamp;
+    double device_time;     //seconds (unwrapped sensor clock)
+    double source_time;     //seconds (wall-clock), 0 if not traced
+    std::vector<hop> hops;
+
+    vTrace() : device_time(0), source_time(0) {}
+
+    /// \brief true if the packet carries a trace record
+    bool isTraced() const { return source_time > 0; }
+
+    /// \brief start a trace at the source of the events (e.g. a grabber)
+    void begin(const yarp::os::Stamp &stamp, double device_time);
+
+    /// \brief record a module receiving the packet
+    void received(const std::string &name, double time);
+
+    /// \brief record the packet leaving the module that last received it
+    void sent(double time);
+
+    bool read(yarp::os::ConnectionReader &connection);
+    bool write(yarp::os::ConnectionWriter &connection) const;
+
+    /// \brief convert to/from the Bottle sent on the wire
+    void toBottle(yarp::os::Bottle &b) const;
+    bool fromBottle(const yarp::os::Bottle &b);
+
+};
+
+}
+
+#endif
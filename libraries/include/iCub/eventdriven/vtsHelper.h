@@ -53,6 +53,16 @@ public:
         return currentTime();
     }
 
+    /// \brief unwrap a timestamp of a stream that is not strictly ordered
+    /// (e.g. interleaved channels). Only a backwards jump of more than half
+    /// the counter is counted as a wrap.
+    unsigned long int unwrapUnordered(int timestamp) {
+        if(last_stamp - timestamp > (int)(max_stamp / 2))
+            n_wraps++;
+        last_stamp = timestamp;
+        return currentTime();
+    }
+
     /// \brief DEPRECATED - access to max_stamp member variable is public
     static long int maxStamp() { return max_stamp; }
     /// \brief DEPRECATED - access to timestamp conversion member variables is
@@ -60,6 +70,13 @@ public:
     static double tstosecs() { return tsscaler; }
     /// \brief ask for the current unwrapped time, without updating the time.
     unsigned long int currentTime() { return last_stamp + ((unsigned long int)max_stamp*n_wraps); }
+    /// \brief the number of wraps counted so far
+    unsigned int wraps() const { return n_wraps; }
+    /// \brief continue unwrapping from a known state (e.g. an existing log)
+    void resume(int last_stamp, unsigned int n_wraps) {
+        this->last_stamp = last_stamp;
+        this->n_wraps = n_wraps;
+    }
 
 };
 
@@ -83,6 +100,30 @@ public:
 
 };
 
+/// \brief timestamp arithmetic for an event-type. By default events carry the
+/// wrapping TIMER_BITS stamp, and differences must be corrected for the
+/// counter overflow. Event-types with unwrapped stamps specialise this class
+/// (see AddressEvent64) so that templated consumers need no wrap checks.
+/// The vFramer AE/AE64 drawers are templated on it; vSurface2, vNoiseFilter,
+/// vFlow and the particle filter still use wrapped AE stamps.
+template <typename V> struct stampTraits
+{
+    typedef unsigned int type;
+    typedef int delta_type;
+
+    static type get(const V &v) { return v.stamp; }
+    static delta_type delta(type later, type earlier) {
+        delta_type dt = later - earlier;
+        if(dt < 0) dt += vtsHelper::max_stamp;
+        return dt;
+    }
+    /// \brief the stamp, in this type, of a TIMER_BITS (wrapped) stamp
+    /// close to the reference
+    static type fromWrapped(type, unsigned int stamp) {
+        return stamp;
+    }
+};
+
 /// \brief an efficient structure for storing sensor resolution
 struct resolution {
     unsigned int width:10;
@@ -0,0 +1,96 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vCodec.h"
+#include "iCub/eventdriven/vtsHelper.h"
+
+namespace ev {
+
+const std::string AddressEvent64::tag = "AE64";
+
+AddressEvent64::AddressEvent64() : AddressEvent(), ustamp(0) {}
+
+AddressEvent64::AddressEvent64(const vEvent &v) : AddressEvent(v)
+{
+    const AddressEvent64 * v2 = dynamic_cast<const AddressEvent64 *>(&v);
+    if(v2)
+        ustamp = v2->ustamp;
+    else
+        ustamp = stamp;
+}
+
+AddressEvent64::AddressEvent64(const AddressEvent64 &v) : AddressEvent(v)
+{
+    ustamp = v.ustamp;
+}
+
+event<> AddressEvent64::clone()
+{
+    return std::make_shared<AddressEvent64>(*this);
+}
+
+void AddressEvent64::setUnwrappedStamp(std::uint64_t ustamp)
+{
+    this->ustamp = ustamp;
+    stamp = ustamp % vtsHelper::max_stamp;
+}
+
+void AddressEvent64::encode(yarp::os::Bottle &b) const
+{
+    AddressEvent::encode(b);
+    b.addInt((ustamp - stamp) / vtsHelper::max_stamp);
+}
+
+void AddressEvent64::encode(std::vector<std::int32_t> &b, unsigned int &pos) const
+{
+    AddressEvent::encode(b, pos);
+    b[pos++] = (ustamp - stamp) / vtsHelper::max_stamp;
+}
+
+void AddressEvent64::decode(int *&data)
+{
+    AddressEvent::decode(data);
+    ustamp = stamp + (std::uint64_t)vtsHelper::max_stamp * (unsigned int)*data;
+    data++;
+}
+
+bool AddressEvent64::decode(const yarp::os::Bottle &packet, size_t &pos)
+{
+    if (AddressEvent::decode(packet, pos) && pos + 1 <= packet.size())
+    {
+        ustamp = stamp + (std::uint64_t)vtsHelper::max_stamp *
+                (unsigned int)packet.get(pos).asInt();
+        pos+=1;
+        return true;
+    }
+    return false;
+}
+
+yarp::os::Property AddressEvent64::getContent() const
+{
+    yarp::os::Property prop = AddressEvent::getContent();
+    prop.put("ustamp", (double)ustamp);
+    return prop;
+}
+
+std::string AddressEvent64::getType() const
+{
+    return AddressEvent64::tag;
+}
+
+}
@@ -0,0 +1,233 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vClock.h"
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+namespace ev {
+
+vClockModel::vClockModel(unsigned int window, double spacing)
+{
+    this->window = window;
+    this->spacing = spacing;
+    reset();
+}
+
+void vClockModel::reset()
+{
+    m.lock();
+    samples.clear();
+    unwrapper = vtsHelper();
+    has_pending = false;
+    since_fit = 0;
+    valid = false;
+    device_ref = 0.0;
+    host_ref = 0.0;
+    rate = 1.0;
+    spread = 0.0;
+    m.unlock();
+}
+
+void vClockModel::add(unsigned int stamp, double host_time)
+{
+    m.lock();
+    double device_time = unwrapper(stamp) * vtsHelper::tsscaler;
+    m.unlock();
+    addUnwrapped(device_time, host_time);
+}
+
+void vClockModel::addUnwrapped(double device_time, double host_time)
+{
+    m.lock();
+
+    //a sample far from the model means the device (or the log) restarted
+    if(valid && std::fabs(host_time - (host_ref + rate *
+                                       (device_time - device_ref))) > 1.0) {
+        samples.clear();
+        has_pending = false;
+        valid = false;
+    }
+
+    //keep only the least delayed sample of each spacing period
+    sample s = {device_time, host_time};
+    if(!has_pending) {
+        pending = s;
+        has_pending = true;
+    } else if(device_time - pending.device < spacing) {
+        if(host_time - device_time < pending.host - pending.device)
+            pending = s;
+    } else {
+        samples.push_back(pending);
+        if(samples.size() > window)
+            samples.pop_front();
+        pending = s;
+        if(++since_fit >= 10 || !valid)
+            fit();
+    }
+
+    m.unlock();
+}
+
+void vClockModel::fit()
+{
+    since_fit = 0;
+    if(samples.size() < 10) return;
+
+    //relative to the first sample to keep the precision
+    double x0 = samples.front().device;
+    double y0 = samples.front().host;
+    std::vector<double> x, y;
+    x.reserve(samples.size()); y.reserve(samples.size());
+    for(unsigned int i = 0; i < samples.size(); i++) {
+        x.push_back(samples[i].device - x0);
+        y.push_back(samples[i].host - y0);
+    }
+
+    std::vector<bool> use(x.size(), true);
+    std::vector<double> r(x.size());
+    double a = 0.0, b = 1.0;
+    for(int iteration = 0; iteration < 3; iteration++) {
+
+        //least squares over the samples in use
+        double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+        for(unsigned int i = 0; i < x.size(); i++) {
+            if(!use[i]) continue;
+            n++; sx += x[i]; sy += y[i];
+            sxx += x[i] * x[i]; sxy += x[i] * y[i];
+        }
+        double den = n * sxx - sx * sx;
+        if(n < 2 || den <= 0.0) return;
+        b = (n * sxy - sx * sy) / den;
+        a = (sy - b * sx) / n;
+
+        //delays are only ever added, so keep the lower half of the residuals
+        for(unsigned int i = 0; i < x.size(); i++)
+            r[i] = y[i] - (a + b * x[i]);
+        std::vector<double> sorted(r);
+        std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2,
+                         sorted.end());
+        double median = sorted[sorted.size() / 2];
+        for(unsigned int i = 0; i < x.size(); i++)
+            use[i] = r[i] <= median;
+    }
+
+    //place the line on the least delayed sample
+    double rmin = *std::min_element(r.begin(), r.end());
+    a += rmin;
+    std::vector<double> sorted(r);
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2,
+                     sorted.end());
+    spread = sorted[sorted.size() / 2] - rmin;
+
+    //reference the model at the newest sample
+    rate = b;
+    device_ref = samples.back().device;
+    host_ref = y0 + a + b * (device_ref - x0);
+    valid = true;
+}
+
+bool vClockModel::isValid()
+{
+    m.lock();
+    bool v = valid;
+    m.unlock();
+    return v;
+}
+
+double vClockModel::toHost(double device_time)
+{
+    m.lock();
+    double h = host_ref + rate * (device_time - device_ref);
+    m.unlock();
+    return h;
+}
+
+double vClockModel::toDevice(double host_time)
+{
+    m.lock();
+    double d = device_ref + (host_time - host_ref) / rate;
+    m.unlock();
+    return d;
+}
+
+unsigned int vClockModel::deviceStamp(double host_time)
+{
+    double ticks = toDevice(host_time) * vtsHelper::vtsscaler;
+    if(ticks < 0) ticks = 0;
+    return (unsigned int)std::fmod(ticks, (double)vtsHelper::max_stamp);
+}
+
+double vClockModel::age(unsigned int stamp)
+{
+    int dt = (int)deviceStamp(yarp::os::Time::now()) - (int)stamp;
+    if(dt > (int)(vtsHelper::max_stamp / 2)) dt -= vtsHelper::max_stamp;
+    else if(dt < -(int)(vtsHelper::max_stamp / 2)) dt += vtsHelper::max_stamp;
+    return dt * vtsHelper::tsscaler;
+}
+
+double vClockModel::drift()
+{
+    m.lock();
+    double d = rate - 1.0;
+    m.unlock();
+    return d;
+}
+
+double vClockModel::offset()
+{
+    m.lock();
+    double o = host_ref - device_ref;
+    m.unlock();
+    return o;
+}
+
+double vClockModel::jitter()
+{
+    m.lock();
+    double j = spread;
+    m.unlock();
+    return j;
+}
+
+void vClockModel::toBottle(yarp::os::Bottle &b)
+{
+    m.lock();
+    b.clear();
+    b.addDouble(device_ref);
+    b.addDouble(host_ref);
+    b.addDouble(rate);
+    b.addDouble(spread);
+    m.unlock();
+}
+
+bool vClockModel::fromBottle(const yarp::os::Bottle &b)
+{
+    if(b.size() < 4 || b.get(2).asDouble() <= 0.0) return false;
+    m.lock();
+    device_ref = b.get(0).asDouble();
+    host_ref = b.get(1).asDouble();
+    rate = b.get(2).asDouble();
+    spread = b.get(3).asDouble();
+    valid = true;
+    m.unlock();
+    return true;
+}
+
+}
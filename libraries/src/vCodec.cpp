@@ -34,6 +34,8 @@ event<> createEvent(const std::string &type)
         return make_event<FlowEvent>();
     if(type == GaussianAE::tag)
         return make_event<GaussianAE>();
+    if(type == AddressEvent64::tag)
+        return make_event<AE64>();
     return event<>(nullptr);
 
 }
@@ -50,6 +52,8 @@ unsigned int packetSize(const std::string &type)
         return 4;
     if(type == GaussianAE::tag)
         return 6;
+    if(type == AddressEvent64::tag)
+        return 3;
     return 0;
 
 
@@ -0,0 +1,282 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vEventGenerator.h"
+#include "iCub/eventdriven/vtsHelper.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ev {
+
+static const unsigned int perimeter_steps = 256;
+
+vEventGenerator::vEventGenerator()
+{
+    width = 304;
+    height = 240;
+    codec = codec_304x240_24;
+    channels = left;
+    rate = 1000000.0;
+    burst_period = 0;
+    burst_length = 0;
+    burst_gain = 1.0;
+    update_period = 0.0001 * vtsHelper::vtsscaler;
+
+    time = 0;
+    next_update = 0;
+    rng = 88172645463325252ULL;
+
+    //unit vectors around a circle, so the perimeter is sampled without trig
+    unit_x.resize(perimeter_steps);
+    unit_y.resize(perimeter_steps);
+    for(unsigned int i = 0; i < perimeter_steps; i++) {
+        unit_x[i] = std::cos(2.0 * M_PI * i / perimeter_steps);
+        unit_y[i] = std::sin(2.0 * M_PI * i / perimeter_steps);
+    }
+}
+
+void vEventGenerator::setResolution(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+}
+
+void vEventGenerator::setBursts(double period, double length, double gain)
+{
+    burst_period = period;
+    burst_length = length;
+    burst_gain = gain;
+}
+
+void vEventGenerator::addPattern(patternType type, double weight,
+                                 double speed, double size, double angle)
+{
+    pattern pt;
+    pt.type = type;
+    pt.weight = weight;
+    pt.speed = speed;
+    pt.size = std::max(size, 1.0);
+    pt.angle = angle;
+    pt.x = width / 2.0; pt.y = height / 2.0;
+    pt.vx = 1.0; pt.vy = 0.0;
+    pt.first = hot_pixels.size();
+
+    //hot pixels are fixed at random locations (size is their number)
+    if(type == hotpixel) {
+        for(int i = 0; i < (int)pt.size; i++)
+            hot_pixels.push_back(random(width) | (random(height) << 12) |
+                                 (random(2) << 24));
+    }
+
+    patterns.push_back(pt);
+
+    //the pattern of each event is selected by comparing a random number to
+    //the cumulative weights
+    double total = 0;
+    for(unsigned int i = 0; i < patterns.size(); i++)
+        total += patterns[i].weight;
+    thresholds.resize(patterns.size());
+    double cumulative = 0;
+    for(unsigned int i = 0; i < patterns.size(); i++) {
+        cumulative += patterns[i].weight;
+        thresholds[i] = (std::uint32_t)(4294967295.0 * cumulative / total);
+    }
+    thresholds.back() = 0xFFFFFFFF;
+
+    updatePatterns();
+}
+
+void vEventGenerator::clearPatterns()
+{
+    patterns.clear();
+    thresholds.clear();
+    hot_pixels.clear();
+}
+
+double vEventGenerator::currentRate() const
+{
+    if(burst_period <= 0)
+        return rate;
+    double phase = std::fmod(time * vtsHelper::tsscaler, burst_period);
+    return phase < burst_length ? rate * burst_gain : rate;
+}
+
+std::int32_t vEventGenerator::encode(int x, int y, int p, int c) const
+{
+    switch(codec) {
+    case codec_128x128:
+        return ((c&0x01)<<15)|((x&0x7f)<<8)|(((127-y)&0x7f)<<1)|(p&0x01);
+    case codec_304x240_20:
+        return ((c&0x01)<<20)|((y&0x0FF)<<10)|((x&0x1FF)<<1)|(p&0x01);
+    default:
+        return ((c&0x01)<<22)|((y&0x0FF)<<12)|((x&0x1FF)<<1)|(p&0x01);
+    }
+}
+
+void vEventGenerator::updatePatterns()
+{
+    //positions are updated at a fixed period of event time, not per event
+    double t = time * vtsHelper::tsscaler;
+
+    for(unsigned int i = 0; i < patterns.size(); i++) {
+        pattern &pt = patterns[i];
+        switch(pt.type) {
+        case edge: {
+            //the edge sweeps along its normal, wrapping around the sensor
+            double nx = std::cos(pt.angle), ny = std::sin(pt.angle);
+            double span = std::fabs(width * nx) + std::fabs(height * ny);
+            double d = std::fmod(pt.speed * t, span) - span / 2.0;
+            pt.x = width / 2.0 + d * nx;
+            pt.y = height / 2.0 + d * ny;
+            pt.vx = nx; pt.vy = ny;
+            break; }
+        case circle: {
+            //the circle orbits the centre of the sensor
+            double orbit = std::max(std::min(width, height) / 2.0 - pt.size, 1.0);
+            double phase = pt.speed * t / orbit;
+            pt.x = width / 2.0 + orbit * std::cos(phase);
+            pt.y = height / 2.0 + orbit * std::sin(phase);
+            pt.vx = -std::sin(phase); pt.vy = std::cos(phase);
+            break; }
+        case corner: {
+            //the vertex moves along the diagonal, wrapping around the sensor
+            double s = pt.speed * t;
+            pt.x = std::fmod(s, (double)width);
+            pt.y = std::fmod(s * height / width, (double)height);
+            break; }
+        default:
+            break;
+        }
+    }
+}
+
+bool vEventGenerator::sample(const pattern &pt, int &x, int &y, int &p)
+{
+    switch(pt.type) {
+    case edge: {
+        //a random point along the edge
+        double v = (random() / 2147483648.0 - 1.0) * (width + height) / 2.0;
+        x = pt.x - v * pt.vy;
+        y = pt.y + v * pt.vx;
+        p = 1;
+        break; }
+    case circle: {
+        unsigned int k = random(perimeter_steps);
+        x = pt.x + pt.size * unit_x[k];
+        y = pt.y + pt.size * unit_y[k];
+        p = unit_x[k] * pt.vx + unit_y[k] * pt.vy > 0;
+        break; }
+    case corner: {
+        //a random point on one of the two trailing arms
+        int v = random((int)pt.size);
+        if(random(2)) {
+            x = pt.x - v; y = pt.y;
+        } else {
+            x = pt.x; y = pt.y - v;
+        }
+        p = 1;
+        break; }
+    case noise:
+        x = random(width);
+        y = random(height);
+        p = random(2);
+        break;
+    case hotpixel: {
+        std::int32_t hp = hot_pixels[pt.first + random((int)pt.size)];
+        x = hp & 0xFFF;
+        y = (hp >> 12) & 0xFFF;
+        p = (hp >> 24) & 0x01;
+        break; }
+    }
+
+    return x >= 0 && x < width && y >= 0 && y < height;
+}
+
+unsigned int vEventGenerator::generate(std::int32_t *data, unsigned int n_events)
+{
+    if(patterns.empty()) addPattern(noise, 1.0);
+
+    double dt = vtsHelper::vtsscaler / currentRate();
+    double next_rate = burst_period > 0 ? time + update_period : -1;
+
+    std::int32_t *d = data;
+    for(unsigned int i = 0; i < n_events; i++) {
+
+        time += dt;
+        if(time >= next_update) {
+            updatePatterns();
+            next_update = time + update_period;
+        }
+        if(next_rate >= 0 && time >= next_rate) {
+            dt = vtsHelper::vtsscaler / currentRate();
+            next_rate = time + update_period;
+        }
+
+        //select the pattern, falling back to noise if it is off the sensor
+        std::uint32_t r = random();
+        unsigned int j = 0;
+        while(r > thresholds[j]) j++;
+
+        int x, y, p;
+        bool valid = false;
+        for(int k = 0; k < 4 && !valid; k++)
+            valid = sample(patterns[j], x, y, p);
+        if(!valid) {
+            x = random(width); y = random(height); p = random(2);
+        }
+
+        int c = channels == split ? random(2) : channels;
+
+        *(d++) = (std::uint64_t)time & vtsHelper::max_stamp;
+        *(d++) = encode(x, y, p, c);
+    }
+
+    return d - data;
+}
+
+bool vEventGenerator::parseCodec(const std::string &name, vAddressCodec &codec)
+{
+    if(name == "128x128") codec = codec_128x128;
+    else if(name == "304x240_20") codec = codec_304x240_20;
+    else if(name == "304x240_24") codec = codec_304x240_24;
+    else return false;
+    return true;
+}
+
+bool vEventGenerator::parsePattern(const std::string &name, patternType &type)
+{
+    if(name == "edge") type = edge;
+    else if(name == "circle") type = circle;
+    else if(name == "corner") type = corner;
+    else if(name == "noise") type = noise;
+    else if(name == "hotpixel") type = hotpixel;
+    else return false;
+    return true;
+}
+
+bool vEventGenerator::parseChannels(const std::string &name, channelMode &mode)
+{
+    if(name == "left") mode = left;
+    else if(name == "right") mode = right;
+    else if(name == "split") mode = split;
+    else return false;
+    return true;
+}
+
+}
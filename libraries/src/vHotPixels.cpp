@@ -0,0 +1,180 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vHotPixels.h"
+#include <algorithm>
+#include <fstream>
+
+namespace ev {
+
+vHotPixels::vHotPixels() : wake(0)
+{
+    width = height = 0;
+    period = 2.0;
+    factor = 20.0;
+    min_rate = 20.0;
+    persistence = 3;
+    n_masked = 0;
+    last_handover = 0;
+    elapsed = 0;
+    busy = false;
+}
+
+void vHotPixels::initialise(int width, int height, double period,
+                            double factor, double min_rate,
+                            unsigned int persistence, const std::string &file)
+{
+    this->width = width;
+    this->height = height;
+    this->period = period;
+    this->factor = factor;
+    this->min_rate = min_rate;
+    this->persistence = std::max(std::min(persistence, 255u), 1u);
+    this->file = file;
+
+    int n = 2 * width * height;
+    counts.assign(n, 0);
+    analysing.assign(n, 0);
+    streak.assign(n, 0);
+    hot.assign(n, 0);
+    n_masked = 0;
+    last_handover = 0;
+
+    found.clear();
+    if(!file.empty() && load())
+        yInfo() << "Masking" << found.size() << "hot pixels from" << file;
+}
+
+bool vHotPixels::load()
+{
+    std::ifstream in(file.c_str());
+    if(!in.is_open())
+        return false;
+
+    int c, x, y;
+    while(in >> c >> x >> y) {
+        if(c < 0 || c > 1 || x < 0 || x >= width || y < 0 || y >= height)
+            continue;
+        int i = (c * height + y) * width + x;
+        if(hot[i]) continue;
+        hot[i] = 1;
+        found.push_back(i);
+    }
+    return true;
+}
+
+bool vHotPixels::save()
+{
+    std::ofstream out(file.c_str());
+    if(!out.is_open()) {
+        yWarning() << "Could not save the hot pixels to" << file;
+        return false;
+    }
+
+    for(int c = 0; c < 2; c++) {
+        for(int y = 0; y < height; y++) {
+            for(int x = 0; x < width; x++) {
+                if(hot[(c * height + y) * width + x])
+                    out << c << " " << x << " " << y << std::endl;
+            }
+        }
+    }
+    return true;
+}
+
+void vHotPixels::update(double now, vRemapTable &table)
+{
+    if(!last_handover) last_handover = now;
+
+    m.lock();
+    for(unsigned int i = 0; i < found.size(); i++) {
+        int c = found[i] / (width * height);
+        int y = (found[i] / width) % height;
+        int x = found[i] % width;
+        table.mask(c, x, y);
+    }
+    n_masked += found.size();
+    found.clear();
+    bool handover = !busy && now - last_handover >= period;
+    if(handover) {
+        counts.swap(analysing);
+        elapsed = now - last_handover;
+        busy = true;
+    }
+    m.unlock();
+
+    if(handover) {
+        last_handover = now;
+        wake.post();
+    }
+}
+
+void vHotPixels::run()
+{
+    std::vector<int> newly_hot;
+
+    while(true) {
+
+        wake.wait();
+        if(isStopping()) break;
+
+        //the threshold is relative to the mean rate of the unmasked pixels
+        //(a masked pixel counts no events and would lower the mean)
+        double total = 0;
+        unsigned int n_unmasked = 0;
+        for(unsigned int i = 0; i < analysing.size(); i++) {
+            if(hot[i]) continue;
+            total += analysing[i];
+            n_unmasked++;
+        }
+        double mean = n_unmasked ? total / n_unmasked : 0.0;
+        double threshold = std::max(factor * mean, min_rate * elapsed);
+
+        newly_hot.clear();
+        for(unsigned int i = 0; i < analysing.size(); i++) {
+            if(analysing[i] > threshold) {
+                if(streak[i] < persistence) streak[i]++;
+                if(streak[i] == persistence && !hot[i]) {
+                    hot[i] = 1;
+                    newly_hot.push_back(i);
+                }
+            } else {
+                streak[i] = 0;
+            }
+        }
+        std::fill(analysing.begin(), analysing.end(), 0);
+
+        if(newly_hot.size()) {
+            yInfo() << "Masking" << newly_hot.size() << "new hot pixels";
+            if(!file.empty())
+                save();
+        }
+
+        m.lock();
+        found.insert(found.end(), newly_hot.begin(), newly_hot.end());
+        busy = false;
+        m.unlock();
+    }
+}
+
+void vHotPixels::onStop()
+{
+    wake.post();
+}
+
+}
@@ -0,0 +1,262 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vImageCodec.h"
+#include <cstring>
+
+namespace ev {
+
+/******************************************************************************/
+//vEncodedImage
+/******************************************************************************/
+bool vEncodedImage::read(yarp::os::ConnectionReader &connection)
+{
+    if(connection.expectInt() != BOTTLE_TAG_LIST) return false;
+    if(connection.expectInt() != 4) return false;
+
+    if(connection.expectInt() != BOTTLE_TAG_STRING) return false;
+    format.resize(connection.expectInt());
+    connection.expectBlock((char *)format.data(), format.size());
+    format = format.c_str(); //without a terminating NUL
+
+    if(connection.expectInt() != BOTTLE_TAG_INT) return false;
+    width = connection.expectInt();
+    if(connection.expectInt() != BOTTLE_TAG_INT) return false;
+    height = connection.expectInt();
+
+    if(connection.expectInt() != BOTTLE_TAG_BLOB) return false;
+    data.resize(connection.expectInt());
+    return connection.expectBlock((char *)data.data(), data.size());
+}
+
+bool vEncodedImage::write(yarp::os::ConnectionWriter &connection) const
+{
+    connection.appendInt(BOTTLE_TAG_LIST);
+    connection.appendInt(4);
+    connection.appendInt(BOTTLE_TAG_STRING);
+    connection.appendInt(format.size());
+    connection.appendBlock(format.data(), format.size());
+    connection.appendInt(BOTTLE_TAG_INT);
+    connection.appendInt(width);
+    connection.appendInt(BOTTLE_TAG_INT);
+    connection.appendInt(height);
+    connection.appendInt(BOTTLE_TAG_BLOB);
+    connection.appendInt(data.size());
+    connection.appendBlock((const char *)data.data(), data.size());
+
+    return !connection.isError();
+}
+
+/******************************************************************************/
+//sparse codec
+/******************************************************************************/
+static void putCount(std::vector<unsigned char> &out, unsigned int n)
+{
+    while(n >= 0x80) {
+        out.push_back((n & 0x7F) | 0x80);
+        n >>= 7;
+    }
+    out.push_back(n);
+}
+
+static bool getCount(const std::vector<unsigned char> &in, unsigned int &pos,
+                     unsigned int &n)
+{
+    n = 0;
+    for(int shift = 0; pos < in.size() && shift < 32; shift += 7) {
+        unsigned char b = in[pos++];
+        n |= (unsigned int)(b & 0x7F) << shift;
+        if(!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+void encodeSparse(const unsigned char *bgr, int width, int height, int step,
+                  std::vector<unsigned char> &out, unsigned char background)
+{
+    //[background] then pairs of runs: [n background][n coloured][BGR...]
+    out.clear();
+    out.push_back(background);
+
+    unsigned int skip = 0;
+    std::vector<unsigned char> coloured;
+    for(int y = 0; y < height; y++) {
+        const unsigned char *row = bgr + y * step;
+        for(int x = 0; x < width; x++) {
+            const unsigned char *p = row + 3 * x;
+            bool is_background = p[0] == background && p[1] == background &&
+                    p[2] == background;
+            if(is_background) {
+                if(coloured.size()) {
+                    putCount(out, coloured.size() / 3);
+                    out.insert(out.end(), coloured.begin(), coloured.end());
+                    coloured.clear();
+                }
+                skip++;
+            } else {
+                if(skip || coloured.empty()) {
+                    if(!coloured.empty()) {
+                        putCount(out, coloured.size() / 3);
+                        out.insert(out.end(), coloured.begin(), coloured.end());
+                        coloured.clear();
+                    }
+                    putCount(out, skip);
+                    skip = 0;
+                }
+                coloured.insert(coloured.end(), p, p + 3);
+            }
+        }
+    }
+    if(coloured.size()) {
+        putCount(out, coloured.size() / 3);
+        out.insert(out.end(), coloured.begin(), coloured.end());
+    }
+}
+
+bool decodeSparse(const std::vector<unsigned char> &in, int width,
+                  int height, int step, unsigned char *bgr)
+{
+    if(in.empty()) return false;
+    for(int y = 0; y < height; y++)
+        memset(bgr + y * step, in[0], 3 * width);
+
+    unsigned int pos = 1;
+    unsigned int pixel = 0;
+    unsigned int n_pixels = width * height;
+    while(pos < in.size()) {
+        unsigned int skip, n;
+        if(!getCount(in, pos, skip) || !getCount(in, pos, n))
+            return false;
+        pixel += skip;
+        if(pixel + n > n_pixels || pos + 3 * n > in.size())
+            return false;
+        for(unsigned int i = 0; i < n; i++, pixel++, pos += 3)
+            memcpy(bgr + (pixel / width) * step + 3 * (pixel % width),
+                   in.data() + pos, 3);
+    }
+    return true;
+}
+
+bool decodeImage(const vEncodedImage &encoded, unsigned char *bgr, int step,
+                 vImageDecodec codec)
+{
+    if(encoded.format == "sparse")
+        return decodeSparse(encoded.data, encoded.width, encoded.height,
+                            step, bgr);
+    if(codec)
+        return codec(encoded, bgr, step);
+    return false;
+}
+
+/******************************************************************************/
+//vImageEncoder
+/******************************************************************************/
+vImageEncoder::vImageEncoder() : wake(0)
+{
+    quality = 90;
+    codec = 0;
+    width = height = 0;
+    has_pending = false;
+    n_dropped = 0;
+}
+
+bool vImageEncoder::open(const std::string &name, const std::string &format,
+                         int quality, vImageCodec codec)
+{
+    if(format != "sparse" && !codec) {
+        yError() << "No codec for" << format << "images";
+        return false;
+    }
+    this->format = format;
+    this->quality = quality;
+    this->codec = codec;
+    encoded.format = format;
+
+    if(!port.open(name))
+        return false;
+    return start();
+}
+
+void vImageEncoder::close()
+{
+    stop();
+    port.close();
+}
+
+void vImageEncoder::onStop()
+{
+    wake.post();
+}
+
+bool vImageEncoder::isConnected()
+{
+    return port.getOutputCount() > 0;
+}
+
+void vImageEncoder::send(const unsigned char *bgr, int width, int height,
+                         int step, const yarp::os::Stamp &stamp)
+{
+    m.lock();
+    if(has_pending) n_dropped++;
+    pending.resize(3 * width * height);
+    for(int y = 0; y < height; y++)
+        memcpy(pending.data() + 3 * width * y, bgr + step * y, 3 * width);
+    this->width = width;
+    this->height = height;
+    this->stamp = stamp;
+    bool post = !has_pending;
+    has_pending = true;
+    m.unlock();
+
+    if(post) wake.post();
+}
+
+void vImageEncoder::run()
+{
+    while(true) {
+
+        wake.wait();
+        if(isStopping()) break;
+
+        m.lock();
+        pending.swap(working);
+        encoded.width = width;
+        encoded.height = height;
+        yarp::os::Stamp envelope = stamp;
+        has_pending = false;
+        m.unlock();
+
+        bool ok = true;
+        if(format == "sparse")
+            encodeSparse(working.data(), encoded.width, encoded.height,
+                         3 * encoded.width, encoded.data);
+        else
+            ok = codec(working.data(), encoded.width, encoded.height,
+                       3 * encoded.width, format, quality, encoded.data);
+        if(!ok) {
+            yWarning() << "Could not compress image as" << format;
+            continue;
+        }
+
+        if(envelope.isValid())
+            port.setEnvelope(envelope);
+        port.write(encoded);
+    }
+}
+
+}
@@ -0,0 +1,509 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vLog.h"
+#include "iCub/eventdriven/vCodec.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+namespace ev {
+
+static const char file_magic[8] = {'E', 'V', 'L', 'O', 'G', 0, 0, 0};
+static const char index_magic[8] = {'E', 'V', 'I', 'N', 'D', 'E', 'X', 0};
+static const std::uint32_t log_version = 1;
+
+static std::uint64_t padded(std::uint32_t n_ints)
+{
+    return (sizeof(std::int32_t) * n_ints + 7) & ~(std::uint64_t)7;
+}
+
+/******************************************************************************/
+//vLogChunk
+/******************************************************************************/
+std::string vLogChunk::tag() const
+{
+    return std::string(header->tag, strnlen(header->tag, sizeof(header->tag)));
+}
+
+yarp::os::Stamp vLogChunk::envelope() const
+{
+    return yarp::os::Stamp(header->envelope_count, header->envelope_time);
+}
+
+/******************************************************************************/
+//vLogWriter
+/******************************************************************************/
+vLogWriter::vLogWriter() : fd(-1), valid(false), offset(0), last_chunk(0),
+    index_period(0.01), next_index_time(0)
+{
+}
+
+vLogWriter::~vLogWriter()
+{
+    close();
+}
+
+void vLogWriter::setIndexPeriod(double period)
+{
+    index_period = period;
+}
+
+bool vLogWriter::open(const std::string &path, bool append)
+{
+    close();
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | (append ? 0 : O_TRUNC), 0644);
+    if(fd < 0) {
+        yError() << "Could not open event log for writing:" << path;
+        return false;
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    if(append && st.st_size > 0)
+        return resume(path);
+
+    vLogFileHeader fh;
+    memset(&fh, 0, sizeof(fh));
+    memcpy(fh.magic, file_magic, sizeof(fh.magic));
+    fh.version = log_version;
+    fh.timer_bits = 0;
+    while(fh.timer_bits < 32 && (vtsHelper::max_stamp >> fh.timer_bits))
+        fh.timer_bits++;
+    fh.tsscaler = vtsHelper::tsscaler;
+
+    if(::write(fd, &fh, sizeof(fh)) != sizeof(fh)) {
+        yError() << "Could not write event log header";
+        abandon();
+        return false;
+    }
+
+    offset = sizeof(fh);
+    last_chunk = 0;
+    next_index_time = 0;
+    index.clear();
+    unwrapper = vtsHelper();
+
+    valid = true;
+    return true;
+}
+
+void vLogWriter::abandon()
+{
+    if(fd >= 0)
+        ::close(fd);
+    fd = -1;
+    valid = false;
+    index.clear();
+}
+
+bool vLogWriter::resume(const std::string &path)
+{
+    //use a reader to find the chunks and index already in the log
+    vLogReader existing;
+    if(!existing.open(path)) {
+        yError() << "Not an event log (or its index was lost):" << path;
+        abandon();
+        return false;
+    }
+
+    index = existing.index;
+    offset = existing.data_end;
+    last_chunk = existing.last_chunk;
+    next_index_time = 0;
+    unwrapper = vtsHelper();
+    if(!index.empty()) {
+        const vLogChunkHeader *ch =
+                (const vLogChunkHeader *)(existing.map + last_chunk);
+        unwrapper.resume(ch->last_stamp,
+                         (ch->last_time - ch->last_stamp) / vtsHelper::max_stamp);
+        next_index_time = index.back().time +
+                index_period * vtsHelper::vtsscaler;
+    }
+
+    //remove the old index so an unclosed log is still read correctly
+    if(ftruncate(fd, offset) != 0) {
+        yError() << "Could not append to event log:" << path;
+        abandon();
+        return false;
+    }
+
+    valid = true;
+    return true;
+}
+
+bool vLogWriter::write(const std::string &tag, const std::int32_t *data,
+                       unsigned int n_ints, const yarp::os::Stamp &envelope)
+{
+    if(fd < 0) return false;
+
+    unsigned int event_size = packetSize(tag);
+    if(!event_size || n_ints < event_size || tag.size() > 8) {
+        yError() << "Cannot log" << n_ints << "ints of" << tag;
+        return false;
+    }
+
+    vLogChunkHeader ch;
+    memset(&ch, 0, sizeof(ch));
+    ch.magic = vLogChunkHeader::chunk_magic;
+    ch.n_ints = n_ints - n_ints % event_size;
+    memcpy(ch.tag, tag.data(), tag.size());
+    ch.first_stamp = data[0] & vtsHelper::max_stamp;
+    ch.last_stamp = data[ch.n_ints - event_size] & vtsHelper::max_stamp;
+    ch.first_time = unwrapper(ch.first_stamp);
+    ch.wraps = unwrapper.wraps();
+    ch.last_time = unwrapper(ch.last_stamp);
+    ch.envelope_count = envelope.getCount();
+    ch.envelope_time = envelope.getTime();
+
+    //header, data and padding in a single call
+    static const char zeros[8] = {0};
+    std::uint64_t data_bytes = sizeof(std::int32_t) * ch.n_ints;
+    struct iovec iov[3];
+    iov[0].iov_base = &ch;
+    iov[0].iov_len = sizeof(ch);
+    iov[1].iov_base = (void *)data;
+    iov[1].iov_len = data_bytes;
+    iov[2].iov_base = (void *)zeros;
+    iov[2].iov_len = padded(ch.n_ints) - data_bytes;
+
+    std::uint64_t total = sizeof(ch) + padded(ch.n_ints);
+    if(pwritev(fd, iov, 3, offset) != (ssize_t)total) {
+        yError() << "Could not write to event log";
+        return false;
+    }
+
+    if(index.empty() || ch.first_time >= next_index_time) {
+        vLogIndexEntry entry = {ch.first_time, offset};
+        index.push_back(entry);
+        next_index_time = ch.first_time + index_period * vtsHelper::vtsscaler;
+    }
+
+    last_chunk = offset;
+    offset += total;
+    return true;
+}
+
+bool vLogWriter::close()
+{
+    if(fd < 0) return true;
+
+    //nothing is written to a file that was not opened as a log
+    if(!valid) {
+        abandon();
+        return true;
+    }
+
+    vLogFooter footer;
+    memset(&footer, 0, sizeof(footer));
+    footer.n_entries = index.size();
+    footer.index_offset = offset;
+    footer.last_chunk = last_chunk;
+    memcpy(footer.magic, index_magic, sizeof(footer.magic));
+
+    std::uint64_t index_bytes = index.size() * sizeof(vLogIndexEntry);
+    bool success =
+        pwrite(fd, index.data(), index_bytes, offset) == (ssize_t)index_bytes &&
+        pwrite(fd, &footer, sizeof(footer), offset + index_bytes) ==
+            sizeof(footer) &&
+        ftruncate(fd, offset + index_bytes + sizeof(footer)) == 0;
+    if(!success)
+        yError() << "Could not write the event log index";
+
+    abandon();
+    return success;
+}
+
+/******************************************************************************/
+//vLogReader
+/******************************************************************************/
+vLogReader::vLogReader() : map(0), map_size(0), data_end(0), last_chunk(0),
+    cursor(0)
+{
+}
+
+vLogReader::~vLogReader()
+{
+    close();
+}
+
+bool vLogReader::open(const std::string &path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        yError() << "Could not open event log:" << path;
+        return false;
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    map_size = st.st_size;
+    if(map_size < sizeof(vLogFileHeader)) {
+        yError() << "Not an event log:" << path;
+        ::close(fd);
+        return false;
+    }
+
+    void *m = mmap(0, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(m == MAP_FAILED) {
+        yError() << "Could not map event log:" << path;
+        return false;
+    }
+    map = (const char *)m;
+    madvise(m, map_size, MADV_SEQUENTIAL);
+
+    const vLogFileHeader *fh = (const vLogFileHeader *)map;
+    if(memcmp(fh->magic, file_magic, sizeof(fh->magic)) ||
+            fh->version != log_version) {
+        yError() << "Not an event log (or unknown version):" << path;
+        close();
+        return false;
+    }
+    if(fh->tsscaler != vtsHelper::tsscaler ||
+            ((std::uint64_t)1 << fh->timer_bits) - 1 != vtsHelper::max_stamp)
+        yWarning() << "Event log recorded with a different clock:" << path;
+
+    //read the index if the log was closed, otherwise scan the chunks
+    const vLogFooter *footer = 0;
+    if(map_size >= sizeof(vLogFileHeader) + sizeof(vLogFooter))
+        footer = (const vLogFooter *)(map + map_size - sizeof(vLogFooter));
+
+    if(footer && !memcmp(footer->magic, index_magic, sizeof(footer->magic)) &&
+            footer->index_offset + footer->n_entries * sizeof(vLogIndexEntry)
+            + sizeof(vLogFooter) == map_size) {
+        const vLogIndexEntry *entries =
+                (const vLogIndexEntry *)(map + footer->index_offset);
+        index.assign(entries, entries + footer->n_entries);
+        data_end = footer->index_offset;
+        last_chunk = footer->last_chunk;
+    } else {
+        yWarning() << "Event log was not closed, rebuilding index:" << path;
+        buildIndex();
+    }
+
+    rewind();
+    return true;
+}
+
+void vLogReader::close()
+{
+    if(map)
+        munmap((void *)map, map_size);
+    map = 0;
+    map_size = 0;
+    data_end = 0;
+    last_chunk = 0;
+    cursor = 0;
+    index.clear();
+}
+
+bool vLogReader::validChunk(std::uint64_t pos) const
+{
+    if(pos + sizeof(vLogChunkHeader) > data_end) return false;
+    const vLogChunkHeader *ch = (const vLogChunkHeader *)(map + pos);
+    return ch->magic == vLogChunkHeader::chunk_magic &&
+            pos + sizeof(vLogChunkHeader) + padded(ch->n_ints) <= data_end;
+}
+
+void vLogReader::buildIndex()
+{
+    //every complete chunk is indexed. A partially written last chunk is
+    //ignored.
+    index.clear();
+    data_end = map_size;
+    std::uint64_t pos = sizeof(vLogFileHeader);
+    while(validChunk(pos)) {
+        const vLogChunkHeader *ch = (const vLogChunkHeader *)(map + pos);
+        vLogIndexEntry entry = {ch->first_time, pos};
+        index.push_back(entry);
+        last_chunk = pos;
+        pos += sizeof(vLogChunkHeader) + padded(ch->n_ints);
+    }
+    data_end = pos;
+}
+
+bool vLogReader::next(vLogChunk &chunk)
+{
+    if(!map || !validChunk(cursor)) return false;
+
+    chunk.header = (const vLogChunkHeader *)(map + cursor);
+    chunk.data = (const std::int32_t *)(map + cursor + sizeof(vLogChunkHeader));
+    cursor += sizeof(vLogChunkHeader) + padded(chunk.header->n_ints);
+    return true;
+}
+
+bool vLogReader::seek(std::uint64_t time)
+{
+    if(!map || index.empty()) return false;
+
+    //the last indexed chunk starting at, or before, the time
+    std::vector<vLogIndexEntry>::const_iterator it =
+            std::upper_bound(index.begin(), index.end(), time,
+                             [](std::uint64_t t, const vLogIndexEntry &e) {
+        return t < e.time;
+    });
+    if(it != index.begin()) it--;
+
+    //then step over the chunks that end before the time
+    cursor = it->offset;
+    while(validChunk(cursor)) {
+        const vLogChunkHeader *ch = (const vLogChunkHeader *)(map + cursor);
+        if(ch->last_time >= time) return true;
+        cursor += sizeof(vLogChunkHeader) + padded(ch->n_ints);
+    }
+
+    return false;
+}
+
+void vLogReader::rewind()
+{
+    cursor = sizeof(vLogFileHeader);
+}
+
+std::uint64_t vLogReader::firstTime() const
+{
+    if(index.empty()) return 0;
+    return index.front().time;
+}
+
+std::uint64_t vLogReader::lastTime() const
+{
+    if(index.empty()) return 0;
+    return ((const vLogChunkHeader *)(map + last_chunk))->last_time;
+}
+
+/******************************************************************************/
+//yarpdatadumper logs
+/******************************************************************************/
+bool convertDataLog(const std::string &textlog, const std::string &binlog)
+{
+    FILE *f = fopen(textlog.c_str(), "r");
+    if(!f) {
+        yError() << "Could not open" << textlog;
+        return false;
+    }
+
+    vLogWriter writer;
+    if(!writer.open(binlog)) {
+        fclose(f);
+        return false;
+    }
+
+    yInfo() << "Converting" << textlog << "to" << binlog;
+
+    //each line is: seq time [envelope_count envelope_time] TAG (ints) ...
+    char *line = 0;
+    size_t capacity = 0;
+    std::vector<std::int32_t> data;
+    unsigned long int n_events = 0;
+    while(getline(&line, &capacity, f) > 0) {
+
+        char *p = line, *end;
+        double nums[4];
+        int n = 0;
+        while(n < 4) {
+            nums[n] = strtod(p, &end);
+            if(end == p) break;
+            p = end; n++;
+        }
+        if(n < 2) continue;
+
+        yarp::os::Stamp envelope((int)nums[0], nums[1]);
+        if(n == 3) envelope = yarp::os::Stamp((int)nums[0], nums[2]);
+        if(n == 4) envelope = yarp::os::Stamp((int)nums[2], nums[3]);
+
+        //a vBottle can hold a list of ints for more than one event-type
+        while(true) {
+            while(isspace(*p)) p++;
+            char *tag_start = p;
+            while(*p && !isspace(*p) && *p != '(') p++;
+            std::string tag(tag_start, p);
+            if(tag.empty()) break;
+            while(isspace(*p)) p++;
+            if(*p != '(') break;
+            p++;
+
+            data.clear();
+            while(true) {
+                long int v = strtol(p, &end, 10);
+                if(end == p) break;
+                data.push_back((std::int32_t)v);
+                p = end;
+            }
+            while(*p && *p != ')') p++;
+            if(*p == ')') p++;
+
+            unsigned int event_size = packetSize(tag);
+            if(!event_size || data.size() < event_size) continue;
+            writer.write(tag, data.data(), data.size(), envelope);
+            n_events += data.size() / event_size;
+        }
+    }
+
+    free(line);
+    fclose(f);
+    yInfo() << "Converted" << n_events << "events";
+    return writer.close();
+}
+
+bool isBinaryLog(const std::string &file)
+{
+    char magic[8] = {0};
+    FILE *f = fopen(file.c_str(), "rb");
+    if(!f) return false;
+    bool binary = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+            !memcmp(magic, file_magic, sizeof(magic));
+    fclose(f);
+    return binary;
+}
+
+std::string findBinaryLog(const std::string &file)
+{
+    if(isBinaryLog(file))
+        return file;
+
+    //the binary log is kept alongside the text log, and re-converted if the
+    //text log is newer
+    std::string binlog = file + ".evlog";
+    struct stat text_st, bin_st;
+    if(stat(file.c_str(), &text_st)) {
+        yError() << "Could not find" << file;
+        return "";
+    }
+    if(stat(binlog.c_str(), &bin_st) || bin_st.st_mtime < text_st.st_mtime ||
+            !isBinaryLog(binlog)) {
+        if(!convertDataLog(file, binlog))
+            return "";
+    }
+
+    return binlog;
+}
+
+}
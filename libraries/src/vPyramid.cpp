@@ -0,0 +1,88 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vPyramid.h"
+
+namespace ev {
+
+vPyramid::vPyramid()
+{
+    width = height = 0;
+    mode = REFRACTORY;
+    refractory = 0;
+    threshold = 1.0f;
+    leak = 0.0f;
+}
+
+void vPyramid::initialise(int width, int height, unsigned int levels)
+{
+    this->width = width;
+    this->height = height;
+
+    //the bits of fire() limit the number of levels
+    if(levels > 16) levels = 16;
+    pyramid.resize(levels);
+    for(unsigned int l = 0; l < levels; l++) {
+        level &lv = pyramid[l];
+        lv.shift = l + 1;
+        lv.width = ((width - 1) >> lv.shift) + 1;
+        lv.height = ((height - 1) >> lv.shift) + 1;
+        cell empty = {0, 0.0f};
+        lv.cells.assign(4 * lv.width * lv.height, empty);
+    }
+}
+
+void vPyramid::setRefractory(double period)
+{
+    mode = REFRACTORY;
+    refractory = period * vtsHelper::vtsscaler;
+}
+
+void vPyramid::setIntegrate(double threshold, double leak)
+{
+    mode = INTEGRATE;
+    this->threshold = threshold < 1.0 ? 1.0f : threshold;
+    this->leak = leak > 0.0 ? 1.0 / (leak * vtsHelper::vtsscaler) : 0.0f;
+}
+
+resolution vPyramid::levelSize(unsigned int l)
+{
+    resolution res = {0, 0};
+    if(l < 1 || l > pyramid.size()) return res;
+    res.width = pyramid[l - 1].width;
+    res.height = pyramid[l - 1].height;
+    return res;
+}
+
+void vPyramid::process(const std::vector<AE> &in,
+                       std::vector< std::deque<AE> > &out)
+{
+    out.resize(pyramid.size());
+    for(std::vector<AE>::const_iterator vi = in.begin(); vi != in.end(); vi++) {
+        unsigned int kept = fire(*vi);
+        for(unsigned int l = 0; kept; l++, kept >>= 1) {
+            if(!(kept & 1)) continue;
+            out[l].push_back(*vi);
+            AE &v = out[l].back();
+            v.x >>= pyramid[l].shift;
+            v.y >>= pyramid[l].shift;
+        }
+    }
+}
+
+}
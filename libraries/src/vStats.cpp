@@ -0,0 +1,157 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vStats.h"
+
+namespace ev {
+
+/******************************************************************************/
+//vHistogram
+/******************************************************************************/
+vHistogram::vHistogram() : max_ns(0), sum_ns(0)
+{
+    for(unsigned int i = 0; i < n_buckets; i++)
+        counts[i].store(0);
+}
+
+vHistogram::snapshot vHistogram::drain()
+{
+    snapshot s;
+    s.counts.resize(n_buckets);
+    s.count = 0;
+    for(unsigned int i = 0; i < n_buckets; i++) {
+        s.counts[i] = counts[i].exchange(0, std::memory_order_relaxed);
+        s.count += s.counts[i];
+    }
+    s.max_ns = max_ns.exchange(0, std::memory_order_relaxed);
+    s.sum_ns = sum_ns.exchange(0, std::memory_order_relaxed);
+    return s;
+}
+
+double vHistogram::snapshot::percentile(double p) const
+{
+    if(!count) return 0.0;
+    std::uint64_t target = (std::uint64_t)(p * count);
+    if(target >= count) target = count - 1;
+
+    std::uint64_t seen = 0;
+    for(unsigned int i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if(seen > target) {
+            //the bucket bound can overshoot the largest sample
+            std::uint64_t ns = upperBound(i);
+            return (ns < max_ns ? ns : max_ns) * 1e-9;
+        }
+    }
+    return max();
+}
+
+/******************************************************************************/
+//vStats
+/******************************************************************************/
+vStats::vStats(double period) : RateThread(period * 1000.0), ptime(0)
+{
+}
+
+vHistogram & vStats::histogram(const std::string &name)
+{
+    histograms.emplace_back();
+    histograms.back().name = name;
+    histograms.back().previous = 0;
+    return histograms.back().value;
+}
+
+vCounter & vStats::counter(const std::string &name)
+{
+    counters.emplace_back();
+    counters.back().name = name;
+    counters.back().previous = 0;
+    return counters.back().value;
+}
+
+vGauge & vStats::gauge(const std::string &name)
+{
+    gauges.emplace_back();
+    gauges.back().name = name;
+    gauges.back().previous = 0;
+    return gauges.back().value;
+}
+
+bool vStats::open(const std::string &portname)
+{
+    if(!port.open(portname))
+        return false;
+    ptime = yarp::os::Time::now();
+    return start();
+}
+
+void vStats::close()
+{
+    stop();
+    port.close();
+}
+
+void vStats::fill(yarp::os::Bottle &b)
+{
+    double ctime = yarp::os::Time::now();
+    double dt = ctime - ptime;
+    ptime = ctime;
+
+    for(unsigned int i = 0; i < histograms.size(); i++) {
+        vHistogram::snapshot s = histograms[i].value.drain();
+        yarp::os::Bottle &group = b.addList();
+        group.addString(histograms[i].name);
+        yarp::os::Bottle &p50 = group.addList();
+        p50.addString("p50"); p50.addDouble(s.percentile(0.5));
+        yarp::os::Bottle &p99 = group.addList();
+        p99.addString("p99"); p99.addDouble(s.percentile(0.99));
+        yarp::os::Bottle &max = group.addList();
+        max.addString("max"); max.addDouble(s.max());
+        yarp::os::Bottle &count = group.addList();
+        count.addString("count"); count.addInt(s.count);
+    }
+
+    for(unsigned int i = 0; i < counters.size(); i++) {
+        std::uint64_t total = counters[i].value.get();
+        yarp::os::Bottle &group = b.addList();
+        group.addString(counters[i].name);
+        yarp::os::Bottle &t = group.addList();
+        t.addString("total"); t.addDouble(total);
+        yarp::os::Bottle &r = group.addList();
+        r.addString("rate");
+        r.addDouble(dt > 0 ? (total - counters[i].previous) / dt : 0.0);
+        counters[i].previous = total;
+    }
+
+    for(unsigned int i = 0; i < gauges.size(); i++) {
+        yarp::os::Bottle &group = b.addList();
+        group.addString(gauges[i].name);
+        yarp::os::Bottle &v = group.addList();
+        v.addString("value"); v.addInt(gauges[i].value.get());
+    }
+}
+
+void vStats::run()
+{
+    yarp::os::Bottle &b = port.prepare();
+    b.clear();
+    fill(b);
+    port.write();
+}
+
+}
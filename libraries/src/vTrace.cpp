@@ -0,0 +1,101 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "iCub/eventdriven/vTrace.h"
+
+namespace ev {
+
+void vTrace::begin(const yarp::os::Stamp &stamp, double device_time)
+{
+    this->stamp = stamp;
+    this->device_time = device_time;
+    source_time = yarp::os::Time::now();
+    hops.clear();
+}
+
+void vTrace::received(const std::string &name, double time)
+{
+    if(!isTraced()) return;
+    hop h;
+    h.name = name;
+    h.received = time;
+    h.sent = 0;
+    hops.push_back(h);
+}
+
+void vTrace::sent(double time)
+{
+    if(!isTraced() || hops.empty()) return;
+    hops.back().sent = time;
+}
+
+void vTrace::toBottle(yarp::os::Bottle &b) const
+{
+    b.clear();
+    b.addInt(stamp.getCount());
+    b.addDouble(stamp.getTime());
+    if(!isTraced()) return;
+
+    b.addDouble(device_time);
+    b.addDouble(source_time);
+    for(size_t i = 0; i < hops.size(); i++) {
+        b.addString(hops[i].name);
+        b.addDouble(hops[i].received);
+        b.addDouble(hops[i].sent);
+    }
+}
+
+bool vTrace::fromBottle(const yarp::os::Bottle &b)
+{
+    hops.clear();
+    device_time = source_time = 0;
+    int n = b.size();
+    if(n < 2)
+        return false;
+    stamp = yarp::os::Stamp(b.get(0).asInt(), b.get(1).asDouble());
+    if(n < 4)
+        return true;
+
+    device_time = b.get(2).asDouble();
+    source_time = b.get(3).asDouble();
+    for(int i = 4; i + 2 < n; i += 3) {
+        hop h;
+        h.name = b.get(i).asString();
+        h.received = b.get(i + 1).asDouble();
+        h.sent = b.get(i + 2).asDouble();
+        hops.push_back(h);
+    }
+    return true;
+}
+
+bool vTrace::read(yarp::os::ConnectionReader &connection)
+{
+    yarp::os::Bottle b;
+    if(!b.read(connection))
+        return false;
+    return fromBottle(b);
+}
+
+bool vTrace::write(yarp::os::ConnectionWriter &connection) const
+{
+    yarp::os::Bottle b;
+    toBottle(b);
+    return b.write(connection);
+}
+
+}
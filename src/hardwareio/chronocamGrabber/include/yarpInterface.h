@@ -82,6 +82,31 @@ public:
 
 };
 
+class device2yarp;
+
+/******************************************************************************/
+//filterStage
+/******************************************************************************/
+/// \brief applies the salt and pepper filter on its own thread and sends the
+/// result through the device2yarp output
+class filterStage : public ev::vNoiseFilterStage {
+
+private:
+
+    device2yarp &d2y;
+
+protected:
+
+    void output(const std::int32_t *data, unsigned int n_events);
+
+public:
+
+    filterStage(device2yarp &d2y, ev::vNoiseFilter &thefilter,
+                unsigned int max_events) :
+        vNoiseFilterStage(thefilter, max_events), d2y(d2y) {}
+
+};
+
 /******************************************************************************/
 //device2yarp
 /******************************************************************************/
@@ -97,6 +122,7 @@ private:
     bool applyfilter;
     bool jumpcheck;
     unsigned int chunksize;
+    unsigned int buffersize;
 
     //internal variables
     yarp::os::Port portvBottle;
@@ -107,13 +133,23 @@ private:
     int prevAEs;
     double prevTS;
     yarp::os::Stamp vStamp;
+    ev::vBottleMimic vbottlemimic;
     ev::vNoiseFilter vfilter;
+    filterStage *filter_stage;
+
+    //timing stats
+    ev::vStats stats;
+    ev::vHistogram &send_time;
+    ev::vCounter &events_read;
+    ev::vCounter &events_lost;
+    ev::vCounter &events_dropped;
+    ev::vCounter &events_sent;
 
     //data buffer thread
     vDevReadBuffer deviceReader;
 
     int applysaltandpepperfilter(std::vector<unsigned char> &data, int nBytesRead);
-    void tsjumpcheck(std::vector<unsigned char> &data, int nBytesRead);
+    void tsjumpcheck(const unsigned char *data, int nBytesRead);
 
 
 public:
@@ -123,11 +159,12 @@ public:
                     std::string moduleName = "", bool check = false,
                     unsigned int bufferSize = 800000,
                     unsigned int readSize = 1024, unsigned int chunkSize = 40960);
-    void initialiseFilter(bool applyfilter, int width, int height, int temporalsize, int spatialSize)
-    {
-        this->applyfilter = applyfilter;
-        vfilter.initialise(width, height, temporalsize, spatialSize);
-    }
+    ~device2yarp();
+    void initialiseFilter(bool applyfilter, int width, int height,
+                          int temporalsize, int spatialSize,
+                          bool threaded = false);
+    void sendData(const unsigned char *data, unsigned int nBytesRead,
+                  bool dataError = false);
 
     void checkForTSJumps()
     {
@@ -112,7 +112,9 @@ bool chronocamGrabberModule::configure(yarp::os::ResourceFinder &rf) {
                                      filp.find("width").asInt(),
                                      filp.find("height").asInt(),
                                      filp.find("tsize").asInt(),
-                                     filp.find("ssize").asInt());
+                                     filp.find("ssize").asInt(),
+                                     filp.check("thread") &&
+                                     filp.find("thread").asBool());
         }
 
             if(jumpcheck) {
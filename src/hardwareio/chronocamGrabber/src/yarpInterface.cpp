@@ -193,7 +193,13 @@ void vDevReadBuffer::run()
 	//device2yarp
 	/******************************************************************************/
 
-	device2yarp::device2yarp() {
+	device2yarp::device2yarp() :
+	    send_time(stats.histogram("send")),
+	    events_read(stats.counter("events_read")),
+	    events_lost(stats.counter("events_lost")),
+	    events_dropped(stats.counter("events_dropped")),
+	    events_sent(stats.counter("events_sent"))
+	{
 	    countAEs = 0;
 	    countLoss = 0;
 	    prevAEs = 0;
@@ -201,8 +207,35 @@ void vDevReadBuffer::run()
 	    errorchecking = false;
 	    applyfilter = false;
 	    jumpcheck = false;
+	    filter_stage = 0;
 	}
 
+device2yarp::~device2yarp()
+{
+    delete filter_stage;
+}
+
+void device2yarp::initialiseFilter(bool applyfilter, int width, int height,
+                                   int temporalsize, int spatialSize,
+                                   bool threaded)
+{
+    this->applyfilter = applyfilter;
+    vfilter.initialise(width, height, temporalsize, spatialSize);
+
+    //events are encoded by getEventChunk with 24 bit stamps
+    ev::vRawLayout layout = ev::vRawLayout::codec304x240_20();
+    layout.stamp_mask = 0x00FFFFFF;
+    vfilter.setRawLayout(layout);
+
+    if(applyfilter && threaded && !filter_stage)
+        filter_stage = new filterStage(*this, vfilter, buffersize / 8);
+}
+
+void filterStage::output(const std::int32_t *data, unsigned int n_events)
+{
+    d2y.sendData((const unsigned char *)data, 8 * n_events);
+}
+
 
 bool device2yarp::initialise(Chronocam::I_EventsStream &stream,
                              std::string moduleName, bool check,
@@ -211,6 +244,7 @@ bool device2yarp::initialise(Chronocam::I_EventsStream &stream,
 {
 
     this->chunksize = chunkSize;
+    this->buffersize = bufferSize;
     if(!deviceReader.initialise(stream, bufferSize, readSize))
         return false;
 
@@ -221,6 +255,9 @@ bool device2yarp::initialise(Chronocam::I_EventsStream &stream,
     if(!portEventCount.open(moduleName + "/eventCount:o"))
 	return false;
 
+    if(!stats.open(moduleName + "/stats:o"))
+        return false;
+
     return portvBottle.open(moduleName + "/vBottle:o");
 
 }
@@ -228,13 +265,14 @@ bool device2yarp::initialise(Chronocam::I_EventsStream &stream,
 void device2yarp::afterStart(bool success)
 {
     if(success) deviceReader.start();
+    if(success && filter_stage) filter_stage->start();
 }
 
-void device2yarp::tsjumpcheck(std::vector<unsigned char> &data, int nBytesRead)
+void device2yarp::tsjumpcheck(const unsigned char *data, int nBytesRead)
 {
-    int pTS = *((int *)(data.data() + 0)) & 0x7FFFFFFF;
+    int pTS = *((const int *)(data + 0)) & 0x7FFFFFFF;
     for(int i = 0; i < nBytesRead; i+=8) {
-        int TS =  *((int *)(data.data() + i)) & 0x7FFFFFFF;
+        int TS =  *((const int *)(data + i)) & 0x7FFFFFFF;
         int dt = TS - pTS;
         if(dt < 0) {
             yError() << "stamp jump" << pTS << " " << TS;
@@ -245,33 +283,11 @@ void device2yarp::tsjumpcheck(std::vector<unsigned char> &data, int nBytesRead)
 
 int device2yarp::applysaltandpepperfilter(std::vector<unsigned char> &data, int nBytesRead)
 {
-    int k = 0;
-    for(int i = 0; i < nBytesRead; i+=8) {
-        int *TS =  (int *)(data.data() + i);
-
-        int *AE =  (int *)(data.data() + i + 4);
-
-        int p = (*AE)&0x01;
-        int x = ((*AE)>>1)&0x1FF;
-        int y = ((*AE)>>10)&0xFF;
-        int c = ((*AE)>>20)&0x01;
-        int ts = (*TS) & 0x00FFFFFF;
-
-        if(vfilter.check(x, y, p, c, ts)) {
-            for(int j = i; j < i+8; j++) {
-                data[k++] = data[j];
-            }
-        }
-
-    }
-
-    return k;
-
+    return 8 * vfilter.filter((std::int32_t *)data.data(), nBytesRead / 8);
 }
 
 void  device2yarp::run() {
 
-    ev::vBottleMimic vbottlemimic;
     while(!isStopping()) {
 
         //display an output to let everyone know we are still working.
@@ -290,6 +306,13 @@ void  device2yarp::run() {
         std::vector<unsigned char> &data = deviceReader.getBuffer(nBytesRead, nBytesLost);
         countAEs += nBytesRead / 8;
         countLoss += nBytesLost / 8;
+        events_read.add(nBytesRead / 8);
+        events_lost.add(nBytesLost / 8);
+        if(filter_stage) {
+            unsigned int dropped = filter_stage->getDropped();
+            countLoss += dropped;
+            events_dropped.add(dropped);
+        }
         if (nBytesRead <= 0) continue;
 
         bool dataError = false;
@@ -300,101 +323,117 @@ void  device2yarp::run() {
             std::cout << "BUFFER NOT A MULTIPLE OF 8 BYTES: " <<  nBytesRead << std::endl;
         }
 
+        //the filter stage sends the data itself once filtered
+        if(filter_stage) {
+            filter_stage->push((const std::int32_t *)data.data(),
+                               nBytesRead / 8);
+            continue;
+        }
+
         if(applyfilter)
             nBytesRead = applysaltandpepperfilter(data, nBytesRead);
-            
-	    if(jumpcheck)
-	        tsjumpcheck(data, nBytesRead);
-
-        if(portEventCount.getOutputCount() && nBytesRead) {
-            yarp::os::Bottle &ecb = portEventCount.prepare();
-            ecb.clear();
-            ecb.addInt(nBytesRead / 8);
-            portEventCount.write();
-        }
 
-        //if we don't want or have nothing to send or there is an error finish here.
-        if(!portvBottle.getOutputCount() || nBytesRead < 8)
-            continue;
+        sendData(data.data(), nBytesRead, dataError);
+    }
 
-	//std::cout << *(int*)data.data() << std::endl;
-        //typical ZYNQ behaviour to skip error checking
-        unsigned int i = 0;
-        i = 0;
-        if(!errorchecking && !dataError) {
+}
 
-            while((i+1) * chunksize < nBytesRead) {
+void device2yarp::sendData(const unsigned char *data, unsigned int nBytesRead,
+                           bool dataError)
+{
+    ev::vScopedTimer timer(send_time);
 
-                //ev::vBottleMimic &vbm = portvBottle.prepare();
-                vbottlemimic.setExternalData((const char *)data.data() + i*chunksize, chunksize);
-                vStamp.update();
-                portvBottle.setEnvelope(vStamp);
-                portvBottle.write(vbottlemimic);
-                //portvBottle.write(strict);
-                //portvBottle.waitForWrite();
+    if(jumpcheck)
+        tsjumpcheck(data, nBytesRead);
 
-                i++;
-            }
+    if(portEventCount.getOutputCount() && nBytesRead) {
+        yarp::os::Bottle &ecb = portEventCount.prepare();
+        ecb.clear();
+        ecb.addInt(nBytesRead / 8);
+        portEventCount.write();
+    }
+
+    //if we don't want or have nothing to send or there is an error finish here.
+    if(!portvBottle.getOutputCount() || nBytesRead < 8)
+        return;
+    events_sent.add(nBytesRead / 8);
+
+    //std::cout << *(int*)data << std::endl;
+    //typical ZYNQ behaviour to skip error checking
+    unsigned int i = 0;
+    i = 0;
+    if(!errorchecking && !dataError) {
+
+        while((i+1) * chunksize < nBytesRead) {
 
             //ev::vBottleMimic &vbm = portvBottle.prepare();
-            vbottlemimic.setExternalData((const char *)data.data() + i*chunksize, nBytesRead - i*chunksize);
+            vbottlemimic.setExternalData((const char *)data + i*chunksize, chunksize);
             vStamp.update();
             portvBottle.setEnvelope(vStamp);
             portvBottle.write(vbottlemimic);
             //portvBottle.write(strict);
             //portvBottle.waitForWrite();
 
-            continue;						//return here.
+            i++;
         }
 
-        //or go through data and check for consistency
-        int bstart = 0;
-        int bend = 0;
-
-        while(bend < (int)nBytesRead - 7) {
-
-            //check validity
-            int *TS =  (int *)(data.data() + bend);
-            int *AE =  (int *)(data.data() + bend + 4);
-            bool BITMISMATCH = !(*TS & 0x80000000) || (*AE & 0xFBE00000);
-
-            if(BITMISMATCH) {
-                //send on what we have checked is not mismatched so far
-                if(bend - bstart > 0) {
-                    std::cerr << "BITMISMATCH in yarp2device" << std::endl;
-                    std::cerr << *TS << " " << *AE << std::endl;
-
-                    //ev::vBottleMimic &vbm = portvBottle.prepare();
-                    vbottlemimic.setExternalData((const char *)data.data()+bstart, bend-bstart);
-                    countAEs += (bend - bstart) / 8;
-                    vStamp.update();
-                    portvBottle.setEnvelope(vStamp);
-                    portvBottle.write(vbottlemimic);
-                    //if(strict) portvBottle.writeStrict();
-                    //else portvBottle.write();
-                }
-
-                //then increment by 1 to find the next alignment
-                bend++;
-                bstart = bend;
-            } else {
-                //and then check the next two ints
-                bend += 8;
+        //ev::vBottleMimic &vbm = portvBottle.prepare();
+        vbottlemimic.setExternalData((const char *)data + i*chunksize, nBytesRead - i*chunksize);
+        vStamp.update();
+        portvBottle.setEnvelope(vStamp);
+        portvBottle.write(vbottlemimic);
+        //portvBottle.write(strict);
+        //portvBottle.waitForWrite();
+
+        return;						//return here.
+    }
+
+    //or go through data and check for consistency
+    int bstart = 0;
+    int bend = 0;
+
+    while(bend < (int)nBytesRead - 7) {
+
+        //check validity
+        int *TS =  (int *)(data + bend);
+        int *AE =  (int *)(data + bend + 4);
+        bool BITMISMATCH = !(*TS & 0x80000000) || (*AE & 0xFBE00000);
+
+        if(BITMISMATCH) {
+            //send on what we have checked is not mismatched so far
+            if(bend - bstart > 0) {
+                std::cerr << "BITMISMATCH in yarp2device" << std::endl;
+                std::cerr << *TS << " " << *AE << std::endl;
+
+                //ev::vBottleMimic &vbm = portvBottle.prepare();
+                vbottlemimic.setExternalData((const char *)data+bstart, bend-bstart);
+                countAEs += (bend - bstart) / 8;
+                vStamp.update();
+                portvBottle.setEnvelope(vStamp);
+                portvBottle.write(vbottlemimic);
+                //if(strict) portvBottle.writeStrict();
+                //else portvBottle.write();
             }
-        }
 
-        if(nBytesRead - bstart > 7) {
-            //ev::vBottleMimic &vbm = portvBottle.prepare();
-            vbottlemimic.setExternalData((const char *)data.data()+bstart, 8*((nBytesRead-bstart)/8));
-            countAEs += (nBytesRead - bstart) / 8;
-            vStamp.update();
-            portvBottle.setEnvelope(vStamp);
-            portvBottle.write(vbottlemimic);
-            //if(strict) portvBottle.writeStrict();
-            //else portvBottle.write();
+            //then increment by 1 to find the next alignment
+            bend++;
+            bstart = bend;
+        } else {
+            //and then check the next two ints
+            bend += 8;
         }
     }
 
+    if(nBytesRead - bstart > 7) {
+        //ev::vBottleMimic &vbm = portvBottle.prepare();
+        vbottlemimic.setExternalData((const char *)data+bstart, 8*((nBytesRead-bstart)/8));
+        countAEs += (nBytesRead - bstart) / 8;
+        vStamp.update();
+        portvBottle.setEnvelope(vStamp);
+        portvBottle.write(vbottlemimic);
+        //if(strict) portvBottle.writeStrict();
+        //else portvBottle.write();
+    }
 }
 
 void device2yarp::threadRelease() {
@@ -404,7 +443,9 @@ void device2yarp::threadRelease() {
     std::cout << "Closing device reader (Could be stuck in a read call!)"
               << std::endl;
     deviceReader.stop();
+    if(filter_stage) filter_stage->stop();
 
+    stats.close();
     portvBottle.close();
 
 }
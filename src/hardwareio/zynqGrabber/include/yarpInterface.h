@@ -27,6 +27,8 @@
 #include <iCub/eventdriven/all.h>
 #include <string>
 #include <vector>
+#include <atomic>
+#include <sys/uio.h>
 
 using namespace yarp::os;
 using namespace ev;
@@ -36,6 +38,10 @@ using std::vector;
 /******************************************************************************/
 //vDevReadBuffer
 /******************************************************************************/
+/// \brief reads the device into a single-producer single-consumer ring. The
+/// consumer is given a pointer into the ring (no copy) and releases the bytes
+/// once sent. If the device is a regular file (e.g. a raw dump) the file
+/// itself is mapped and used as the ring, and no reads are performed.
 class vDevReadBuffer : public yarp::os::Thread {
 
 private:
@@ -44,28 +50,34 @@ private:
     unsigned int read_size;
     unsigned int buffer_size;
 
-
     //internal variables/storage
     int fd;
-    unsigned int read_count;
-    unsigned int loss_count;
-    std::vector<unsigned char> buffer1;
-    std::vector<unsigned char> buffer2;
+    unsigned char *ring;
+    unsigned int ring_bytes;
+    bool file_mapped;
+    std::atomic<unsigned int> head;
+    std::atomic<unsigned int> tail;
+    std::atomic<unsigned int> loss_count;
     std::vector<unsigned char> discard_buffer;
 
-    std::vector<unsigned char> *read_buffer;
-    std::vector<unsigned char> *access_buffer;
-
-    yarp::os::Semaphore safety;
     yarp::os::Semaphore signal;
-    bool bufferedreadwaiting;
+
+    /// \brief read up to n bytes (a multiple of 8) of whole events. An event
+    /// split over two reads is completed before returning.
+    int readEvents(unsigned char *dst, unsigned int n);
+    int fill();
 
 public:
 
     vDevReadBuffer(int fd, unsigned int read_size, unsigned int buffer_size);
-    std::vector<unsigned char>& getBuffer(unsigned int &nBytesRead,
-                                          unsigned int &nBytesLost);
+    ~vDevReadBuffer();
+    const unsigned char* getData(unsigned int &nBytesRead,
+                                 unsigned int &nBytesLost,
+                                 unsigned int nBytesHeld = 0,
+                                 double timeout = -1);
+    void releaseData(unsigned int nBytes);
     virtual void run();
+    virtual void onStop();
 
 };
 
@@ -79,11 +91,20 @@ private:
     //data buffer thread
     vDevReadBuffer *device_reader;
     yarp::os::Port output_port;
+    yarp::os::BufferedPort<yarp::os::Bottle> clock_port;
+    vGenPortInterface external_storage;
 
     //parameters
     unsigned int packet_size;
+    unsigned int packet_time;
+    double packet_deadline;
+    bool device_stamp;
     bool direct_read;
+    bool trace;
     Stamp yarp_stamp;
+    vTrace packet_trace;
+    vtsHelper unwrapper;
+    vClockModel clock;
 
     int countAEs;
     int countLoss;
@@ -91,13 +112,32 @@ private:
     int prevAEs;
     double prevTS;
 
+    //timing stats
+    vHistogram *send_time;
+    vCounter *events_read;
+    vCounter *events_lost;
+    vCounter *packets_sent;
+    vGauge *ring_bytes;
+
+    void sendPacket(const unsigned char *data, unsigned int n_bytes);
+    unsigned int packetise(const unsigned char *data, unsigned int n_bytes,
+                           bool flush);
+
 public:
 
     device2yarp();
     bool open(string module_name, int fd, unsigned int read_size,
               bool direct_read, unsigned int packet_size,
               unsigned int internal_storage_size);
+    void setPacketLimits(unsigned int packet_time, double packet_deadline,
+                         bool device_stamp);
+    /// \brief start a vTrace in the envelope of each packet
+    void setTrace(bool value = true);
     void setDirectRead(bool value = true);
+    /// \brief register the statistics. Must be called before starting.
+    void setStats(vStats &stats);
+    /// \brief the device to host clock model fitted from the sent packets
+    vClockModel & getClock() { return clock; }
 
     void run();
     void onStop();
@@ -106,6 +146,27 @@ public:
 
 };
 
+/******************************************************************************/
+//vRawInterface
+/******************************************************************************/
+/// \brief reads a packet in the vPortInterface wire format into a contiguous
+/// block of int32 without decoding the events. Only AE packets are accepted.
+class vRawInterface : public yarp::os::Portable {
+
+public:
+
+    std::vector<std::int32_t> data;
+    unsigned int nints;
+
+    vRawInterface() : nints(0) {}
+
+    bool read(yarp::os::ConnectionReader& connection);
+
+    /// \brief does nothing as this is a read-only interface
+    bool write(yarp::os::ConnectionWriter& connection) const { return false; }
+
+};
+
 /******************************************************************************/
 //yarp2device
 /******************************************************************************/
@@ -115,15 +176,32 @@ protected:
 
     int fd;
     bool valid;
-    BufferedPort<Bottle> input_port;
-    vector<int> data_copy;
-
-    unsigned int total_events;
+    BufferedPort<vRawInterface> input_port;
+    vector<void *> handles;
+    vector<struct iovec> iov;
+
+    //throughput counters
+    unsigned long int total_events;
+    unsigned long int total_packets;
+    unsigned long int total_writes;
+    unsigned long int prev_events;
+    double prev_ts;
+
+    //timing stats
+    vHistogram *write_time;
+    vCounter *events_written;
+    vCounter *packets_received;
+    vGauge *queue;
+
+    void maskAddresses(vRawInterface &packet);
+    bool writeBatch();
 
 public:
 
     yarp2device();
     bool open(string module_name, int fd);
+    /// \brief register the statistics. Must be called before starting.
+    void setStats(vStats &stats);
     void run();
     void onStop();
 
@@ -140,6 +218,8 @@ private:
     int fd;
     device2yarp D2Y;
     yarp2device Y2D;
+    vStats stats;
+    string module_name;
 
     int pool_size;
     bool read_thread_open;
@@ -153,7 +233,11 @@ public:
                          bool loopback = false);
     bool openReadPort(string module_name, bool direct_read,
                       unsigned int packet_size,
-                      unsigned int maximum_internal_memory);
+                      unsigned int maximum_internal_memory,
+                      unsigned int packet_time = 0,
+                      double packet_deadline = 0,
+                      bool device_stamp = false,
+                      bool trace = false);
     bool openWritePort(string module_name);
     void start();
     void stop();
@@ -21,9 +21,12 @@
 #include "deviceRegisters.h"
 
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
 
 /******************************************************************************/
 //vDevReadBuffer
@@ -33,104 +36,174 @@ vDevReadBuffer::vDevReadBuffer(int fd, unsigned int read_size, unsigned int buff
 {
     //parameters
     this->fd = fd;
-    this->buffer_size = buffer_size;
-    this->read_size = read_size;
+    this->buffer_size = buffer_size - buffer_size % 8;
+    this->read_size = std::max(read_size - read_size % 8, 8u);
 
-    buffer1.resize(buffer_size);
-    buffer2.resize(buffer_size);
-    discard_buffer.resize(read_size);
-
-    read_buffer = &buffer1;
-    access_buffer = &buffer2;
-
-    read_count = 0;
+    head = 0;
+    tail = 0;
     loss_count = 0;
+    discard_buffer.resize(this->read_size);
+
+    //a regular file is mapped directly and used as the (full) ring
+    struct stat fd_stat;
+    file_mapped = false;
+    if(fstat(fd, &fd_stat) == 0 && S_ISREG(fd_stat.st_mode) && fd_stat.st_size) {
+        ring_bytes = fd_stat.st_size;
+        void *m = mmap(0, ring_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(m != MAP_FAILED) {
+            ring = (unsigned char *)m;
+            file_mapped = true;
+            this->buffer_size = ring_bytes - ring_bytes % 8;
+            head = this->buffer_size;
+            yInfo() << "mapped file of" << this->buffer_size << "bytes";
+            return;
+        }
+    }
 
-    bufferedreadwaiting = false;
+    //otherwise the ring is anonymous page-aligned memory
+    ring_bytes = this->buffer_size;
+    void *m = mmap(0, ring_bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(m == MAP_FAILED) {
+        perror("Could not allocate ring buffer: ");
+        ring = 0;
+        ring_bytes = this->buffer_size = 0;
+    } else {
+        ring = (unsigned char *)m;
+    }
 
-    yInfo() << "buffer size: " << buffer1.size();
+    yInfo() << "buffer size: " << this->buffer_size;
 
 }
 
-
-void vDevReadBuffer::run()
+vDevReadBuffer::~vDevReadBuffer()
 {
+    if(ring)
+        munmap(ring, ring_bytes);
+}
 
-    signal.check();
-
-    while(!isStopping()) {
-
-        safety.wait();
-
-        int r = 0;
-        if(read_count < buffer_size) {
-            //we read and fill up the buffer
-            r = read(fd, read_buffer->data() + read_count,
-                     std::min(buffer_size - read_count, read_size));
-            if(r > 0) read_count += r;
-        } else {
-            //we have reached maximum software buffer - read from the HW but
-            //just discard the result.
-            r = read(fd, discard_buffer.data(), read_size);
-            if(r > 0) loss_count += r;
+int vDevReadBuffer::readEvents(unsigned char *dst, unsigned int n)
+{
+    int r = read(fd, dst, n);
+    if(r <= 0) return r;
+
+    //the ring (and the stream) must stay aligned to whole events
+    while(r % 8) {
+        int c = read(fd, dst + r, 8 - r % 8);
+        if(c > 0) {
+            r += c;
+        } else if((c < 0 && errno != EAGAIN) || !c || isStopping()) {
+            loss_count += r % 8;
+            return r - r % 8;
         }
-        //std::cout<< " bytes read "<< r <<std::endl;
+    }
 
-        if(r < 0 && errno != EAGAIN) {
-            perror("Error reading events: ");
-        }
+    return r;
+}
 
-        safety.post();
-        if(bufferedreadwaiting) {
-            //the other thread is read to read
-            signal.wait(); //wait for it to do the read
+int vDevReadBuffer::fill()
+{
+    unsigned int h = head.load(std::memory_order_relaxed);
+    unsigned int t = tail.load(std::memory_order_acquire);
+
+    //contiguous free space. 8 bytes are kept free so a full ring is not
+    //confused with an empty one
+    unsigned int space;
+    if(h >= t)
+        space = buffer_size - h - (t ? 0 : 8);
+    else
+        space = t - h - 8;
+
+    int r = 0;
+    if(space >= 8 && buffer_size) {
+        r = readEvents(ring + h, std::min(space, read_size) & ~7u);
+        if(r > 0) {
+            h += r;
+            if(h >= buffer_size) h = 0;
+            head.store(h, std::memory_order_release);
+            signal.post();
         }
+    } else {
+        //we have reached maximum software buffer - read from the HW but
+        //just discard the result.
+        r = readEvents(discard_buffer.data(), read_size);
+        if(r > 0) loss_count += r;
+    }
 
+    if(r < 0 && errno != EAGAIN) {
+        perror("Error reading events: ");
     }
 
+    return r;
+}
+
+void vDevReadBuffer::run()
+{
+    if(file_mapped) return;
 
+    while(!isStopping()) {
+        fill();
+    }
 }
 
+void vDevReadBuffer::onStop()
+{
+    //release a consumer waiting for data
+    signal.post();
+}
 
-std::vector<unsigned char>& vDevReadBuffer::getBuffer(unsigned int &nBytesRead, unsigned int &nBytesLost)
+const unsigned char* vDevReadBuffer::getData(unsigned int &nBytesRead,
+                                             unsigned int &nBytesLost,
+                                             unsigned int nBytesHeld,
+                                             double timeout)
 {
+    nBytesRead = 0;
+    nBytesLost = 0;
 
-    if(!this->isRunning()) {
+    if(!file_mapped && !this->isRunning()) {
         //direct read
-        nBytesLost = 0;
-        int r = read(fd, read_buffer->data(), read_size);
-        if(r > 0) nBytesRead = r;
-        if(r < 0 && errno != EAGAIN) {
-            perror("Error reading events: ");
-        }
-        return *read_buffer;
+        fill();
     } else {
-
-        //safely copy the data into the accessBuffer and reset the readCount
-        bufferedreadwaiting = true;
-        safety.wait();
-        bufferedreadwaiting = false;
-
-        //switch the buffer the read into
-        std::vector<unsigned char> *temp;
-        temp = read_buffer;
-        read_buffer = access_buffer;
-        access_buffer = temp;
-
-        //reset the filling position
-        nBytesRead = read_count;
-        nBytesLost = loss_count;
-        read_count = 0;
-        loss_count = 0;
-
-        //send the correct signals to restart the grabbing thread
-        safety.post();
-        signal.check();
-        signal.post(); //tell the other thread we are done
-
-        return *access_buffer;
+        //wait for data beyond the nBytesHeld the caller has not released.
+        //if the ring has wrapped the held data cannot grow so return.
+        double deadline = yarp::os::Time::now() + timeout;
+        while(this->isRunning()) {
+            unsigned int h = head.load(std::memory_order_acquire);
+            unsigned int t = tail.load(std::memory_order_relaxed);
+            if(h < t || h - t > nBytesHeld)
+                break;
+            if(timeout < 0) {
+                signal.wait();
+            } else {
+                double remaining = deadline - yarp::os::Time::now();
+                if(remaining <= 0) break;
+                signal.waitWithTimeout(remaining);
+            }
+        }
     }
 
+    unsigned int t = tail.load(std::memory_order_relaxed);
+    unsigned int h = head.load(std::memory_order_acquire);
+
+    //only the contiguous section is given, the remainder (after the ring
+    //wraps) is given on the next call
+    if(h >= t)
+        nBytesRead = h - t;
+    else
+        nBytesRead = buffer_size - t;
+    nBytesLost = loss_count.exchange(0);
+
+    if(file_mapped && !nBytesRead)
+        yarp::os::Time::delay(0.1);
+
+    return ring + t;
+}
+
+void vDevReadBuffer::releaseData(unsigned int nBytes)
+{
+    unsigned int t = tail.load(std::memory_order_relaxed) + nBytes;
+    if(t >= buffer_size && !file_mapped) t = 0;
+    tail.store(t, std::memory_order_release);
 }
 
 /******************************************************************************/
@@ -144,6 +217,25 @@ device2yarp::device2yarp()
     prevAEs = 0;
     device_reader = 0;
     direct_read = false;
+    packet_time = 0;
+    packet_deadline = 0;
+    device_stamp = false;
+    trace = false;
+
+    send_time = 0;
+    events_read = 0;
+    events_lost = 0;
+    packets_sent = 0;
+    ring_bytes = 0;
+}
+
+void device2yarp::setStats(vStats &stats)
+{
+    send_time = &stats.histogram("send");
+    events_read = &stats.counter("events_read");
+    events_lost = &stats.counter("events_lost");
+    packets_sent = &stats.counter("packets_sent");
+    ring_bytes = &stats.gauge("ring_bytes");
 }
 
 bool device2yarp::open(string module_name, int fd, unsigned int read_size,
@@ -158,9 +250,92 @@ bool device2yarp::open(string module_name, int fd, unsigned int read_size,
     this->direct_read = direct_read;
     this->packet_size = packet_size;
 
+    if(!clock_port.open(module_name + "/clock:o"))
+        yWarning() << "Could not open clock port";
+
     return output_port.open(module_name + "/AE:o");
 }
 
+void device2yarp::setPacketLimits(unsigned int packet_time,
+                                  double packet_deadline, bool device_stamp)
+{
+    this->packet_time = packet_time;
+    this->packet_deadline = packet_deadline;
+    this->device_stamp = device_stamp;
+}
+
+void device2yarp::setTrace(bool value)
+{
+    trace = value;
+}
+
+void device2yarp::sendPacket(const unsigned char *data, unsigned int n_bytes)
+{
+    external_storage.setExternalData((const char *)data, n_bytes);
+
+    //the (unwrapped) device time of the last event
+    int last_stamp = *(const int *)(data + n_bytes - 8) & vtsHelper::max_stamp;
+    double device_time = 0;
+    if(device_stamp || trace)
+        device_time = unwrapper(last_stamp) * vtsHelper::tsscaler;
+    clock.add(last_stamp, yarp::os::Time::now());
+
+    if(device_stamp)
+        yarp_stamp = Stamp(yarp_stamp.getCount() + 1, device_time);
+    else
+        yarp_stamp.update();
+
+    vScopedTimer timer(*send_time);
+    if(trace) {
+        packet_trace.begin(yarp_stamp, device_time);
+        output_port.setEnvelope(packet_trace);
+    } else {
+        output_port.setEnvelope(yarp_stamp);
+    }
+    output_port.write(external_storage);
+    packets_sent->add();
+}
+
+unsigned int device2yarp::packetise(const unsigned char *data,
+                                    unsigned int n_bytes, bool flush)
+{
+    //packets are cut at whichever comes first: packet_size bytes, or
+    //packet_time of event time. The remainder is only sent if flush is set,
+    //otherwise it is held to be completed by the next read.
+    const int *words = (const int *)data;
+    unsigned int n_events = n_bytes / 8;
+    unsigned int max_events = std::max(packet_size / 8, 1u);
+    unsigned int start = 0;
+    int first_stamp = words[0] & vtsHelper::max_stamp;
+
+    for(unsigned int i = 0; i < n_events; i++) {
+
+        if(packet_time) {
+            int stamp = words[2 * i] & vtsHelper::max_stamp;
+            if(i > start && (unsigned int)stampTraits<AE>::delta(stamp,
+                                             first_stamp) > packet_time) {
+                sendPacket(data + 8 * start, 8 * (i - start));
+                start = i;
+                first_stamp = stamp;
+            }
+        }
+
+        if(i + 1 - start >= max_events) {
+            sendPacket(data + 8 * start, 8 * (i + 1 - start));
+            start = i + 1;
+            if(start < n_events)
+                first_stamp = words[2 * start] & vtsHelper::max_stamp;
+        }
+    }
+
+    if(flush && start < n_events) {
+        sendPacket(data + 8 * start, 8 * (n_events - start));
+        start = n_events;
+    }
+
+    return 8 * start;
+}
+
 void device2yarp::afterStart(bool success)
 {
     if(success && !direct_read)
@@ -169,9 +344,15 @@ void device2yarp::afterStart(bool success)
 
 void  device2yarp::run() {
 
-    vGenPortInterface external_storage;
     external_storage.setHeader(AE::tag);
     yInfo() << "packet size: " << packet_size;
+    if(packet_time)
+        yInfo() << "packet time: " << packet_time * vtsHelper::tsscaler << "s";
+    if(packet_deadline > 0)
+        yInfo() << "packet deadline: " << packet_deadline << "s";
+
+    unsigned int nBytesHeld = 0;
+    double held_since = 0;
 
     while(!isStopping()) {
 
@@ -191,33 +372,49 @@ void  device2yarp::run() {
             }
             prevTS += update_period;
             prevAEs = countAEs;
+
+            if(clock.isValid() && clock_port.getOutputCount()) {
+                clock.toBottle(clock_port.prepare());
+                clock_port.write();
+            }
         }
 
+        //wait for new data, or until the held data reaches its deadline
+        double timeout = -1;
+        if(nBytesHeld)
+            timeout = std::max(0.0, held_since + packet_deadline -
+                               yarp::os::Time::now());
+
         //get the data from the device read thread
         unsigned int nBytesRead, nBytesLost;
-        std::vector<unsigned char> &data = device_reader->getBuffer(nBytesRead, nBytesLost);
-        countAEs += nBytesRead / 8;
+        const unsigned char *data = device_reader->getData(nBytesRead,
+                                                           nBytesLost,
+                                                           nBytesHeld,
+                                                           timeout);
+        countAEs += (nBytesRead - std::min(nBytesRead, nBytesHeld)) / 8;
         countLoss += nBytesLost / 8;
-        if (!output_port.getOutputCount() || nBytesRead <= 8) continue;
-
-        unsigned int i = 0;
-        while((i+1) * packet_size < nBytesRead) {
+        events_read->add((nBytesRead - std::min(nBytesRead, nBytesHeld)) / 8);
+        events_lost->add(nBytesLost / 8);
+        ring_bytes->set(nBytesRead);
+        //only whole events are released
+        if (!output_port.getOutputCount() || nBytesRead < 8) {
+            device_reader->releaseData(nBytesRead & ~7u);
+            nBytesHeld = 0;
+            continue;
+        }
 
-            external_storage.setExternalData((const char *)data.data() +
-                                             i * packet_size, packet_size);
-            yarp_stamp.update();
-            output_port.setEnvelope(yarp_stamp);
-            output_port.write(external_storage);
+        //without a deadline nothing is held. The held data is also sent if
+        //it could not grow (the deadline passed or the ring wrapped).
+        bool flush = packet_deadline <= 0 || nBytesRead <= nBytesHeld ||
+                yarp::os::Time::now() - held_since >= packet_deadline;
 
-            i++;
-        }
+        unsigned int nBytesSent = packetise(data, nBytesRead, flush);
 
-        external_storage.setExternalData((const char *)data.data() +
-                                         i * packet_size,
-                                         nBytesRead - i * packet_size);
-        yarp_stamp.update();
-        output_port.setEnvelope(yarp_stamp);
-        output_port.write(external_storage);
+        //the sent data has been written to the port and the ring can be reused
+        device_reader->releaseData(nBytesSent);
+        if(!nBytesHeld || nBytesSent)
+            held_since = yarp::os::Time::now();
+        nBytesHeld = nBytesRead - nBytesSent;
     }
 
 }
@@ -226,6 +423,7 @@ void device2yarp::onStop()
 {
     device_reader->stop();
     output_port.close();
+    clock_port.close();
 }
 
 void device2yarp::threadRelease()
@@ -237,15 +435,73 @@ void device2yarp::threadRelease()
 /******************************************************************************/
 //yarp2device
 /******************************************************************************/
+bool vRawInterface::read(yarp::os::ConnectionReader& connection)
+{
+    nints = 0;
+
+    //META DATA OF BOTTLE
+    if(connection.expectInt() != BOTTLE_TAG_LIST) //a list
+        return false;
+    if(connection.expectInt() != 2) //of two internal bottles
+        return false;
+
+    //DATA OF FIRST INTERNAL BOTTLE (type of event)
+    if(connection.expectInt() != BOTTLE_TAG_STRING)
+        return false;
+    int str_len = connection.expectInt();
+    std::string vtype;
+    vtype.resize(str_len);
+    connection.expectBlock((char *)vtype.data(), str_len);
+    if(vtype != AE::tag) {
+        yWarning() << "yarp2device only accepts" << AE::tag << "packets";
+        return false;
+    }
+
+    //DATA OF SECOND INTERNAL BOTTLE (data of events)
+    if(connection.expectInt() != (BOTTLE_TAG_LIST|BOTTLE_TAG_INT))
+        return false;
+    unsigned int ndata = (unsigned int)connection.expectInt(); //in integers!!
+
+    if(ndata > data.size())
+        data.resize(ndata);
+    if(!connection.expectBlock((char *)data.data(),
+                               sizeof(std::int32_t) * ndata)) {
+        yError() << "Could not read datablock";
+        return false;
+    }
+
+    nints = ndata - ndata % 2;
+    return true;
+}
+
 yarp2device::yarp2device()
 {
     fd = -1;
     total_events = 0;
+    total_packets = 0;
+    total_writes = 0;
+    prev_events = 0;
+    prev_ts = 0;
+
+    write_time = 0;
+    events_written = 0;
+    packets_received = 0;
+    queue = 0;
+}
+
+void yarp2device::setStats(vStats &stats)
+{
+    write_time = &stats.histogram("write");
+    events_written = &stats.counter("events_written");
+    packets_received = &stats.counter("packets_received");
+    queue = &stats.gauge("queue");
 }
 
 bool yarp2device::open(std::string module_name, int fd)
 {
     this->fd = fd;
+    input_port.setStrict();
+    prev_ts = yarp::os::Time::now();
     return input_port.open(module_name + "/AE:i");
 }
 
@@ -255,46 +511,100 @@ void yarp2device::onStop()
     input_port.close();
 }
 
-void yarp2device::run()
+void yarp2device::maskAddresses(vRawInterface &packet)
 {
+    //each event is a 64 bit word [stamp, address]. The stamp is not sent to
+    //the device (as before) and only the lower 20 bits of the address are
+    //kept. A single AND per event is vectorised by the compiler.
+    const std::uint64_t mask = (std::uint64_t)0x000FFFFF << 32;
+    std::uint64_t *events = (std::uint64_t *)packet.data.data();
+    unsigned int n = packet.nints / 2;
+    for(unsigned int i = 0; i < n; i++)
+        events[i] &= mask;
+}
 
-    while(true) {
+bool yarp2device::writeBatch()
+{
+    //write all packets with a single system call, continuing from where
+    //the device stopped if only a partial write was made.
+    struct iovec *v = iov.data();
+    int n = iov.size();
+    while(n) {
 
-        Bottle *yarp_bottle = input_port.read(true); //blocking read
-        if(!yarp_bottle) return; //when interrupt is called returns null
+        ssize_t ret = writev(fd, v, n);
 
-        Bottle *data_bottle = yarp_bottle->get(1).asList();
-        size_t data_size = data_bottle->size();
-        if(data_size > data_copy.size())
-            data_copy.resize(data_size, 0);
+        if(ret < 0) {
+            if(errno == EAGAIN) continue;
+            perror("Error writing to device: ");
+            return false;
+        }
+        total_writes++;
+        total_events += ret / (2 * sizeof(int));
+        events_written->add(ret / (2 * sizeof(int)));
 
-        //copy to internal data (needed to modify the contents)
-        //we can remove data_copy and just use data_bottle when the
-        //mask is done in the FPGA
-        for(size_t i = 1; i < data_size; i += 2) {
-            data_copy[i] = data_bottle->get(i).asInt() & 0x000FFFFF;
+        while(n && (size_t)ret >= v->iov_len) {
+            ret -= v->iov_len;
+            v++; n--;
+        }
+        if(n) {
+            v->iov_base = (char *)v->iov_base + ret;
+            v->iov_len -= ret;
         }
+    }
 
-        //move to bytes space
-        char * buffer = (char *)data_copy.data();
-        size_t bytes_to_write = data_size * sizeof(int);
-        size_t written = 0;
-        while(written < bytes_to_write) {
+    return true;
+}
+
+void yarp2device::run()
+{
 
-            int ret = write(fd, buffer + written, bytes_to_write - written);
+    while(true) {
 
-            if(ret > 0) { //success!
-                written += ret;
-            } else if(ret < 0 && errno != EAGAIN) { //error!
-                perror("Error writing to device: ");
-                return;
+        vRawInterface *packet = input_port.read(true); //blocking read
+        if(!packet) return; //when interrupt is called returns null
+
+        //take all packets already queued on the port and write them together
+        handles.clear();
+        iov.clear();
+        while(packet) {
+
+            handles.push_back(input_port.acquire());
+            total_packets++;
+            packets_received->add();
+            if(packet->nints) {
+                maskAddresses(*packet);
+                struct iovec v;
+                v.iov_base = packet->data.data();
+                v.iov_len = packet->nints * sizeof(std::int32_t);
+                iov.push_back(v);
             }
+
+            packet = nullptr;
+            if(iov.size() < IOV_MAX && input_port.getPendingReads())
+                packet = input_port.read(false);
         }
 
-        total_events += written / (2.0 * sizeof(int));
+        queue->set(input_port.getPendingReads());
+        double tstart = yarp::os::Time::now();
+        bool success = writeBatch();
+        write_time->record(yarp::os::Time::now() - tstart);
 
-    }
+        for(unsigned int i = 0; i < handles.size(); i++)
+            input_port.release(handles[i]);
 
+        if(!success) return;
+
+        double update_period = yarp::os::Time::now() - prev_ts;
+        if(update_period > 1.0) {
+            yInfo() << "Event writer running happily. kV/s = " <<
+                (int)((total_events - prev_events) / (1000.0 * update_period))
+                    << "packets =" << total_packets
+                    << "writes =" << total_writes;
+            prev_ts += update_period;
+            prev_events = total_events;
+        }
+
+    }
 
 }
 
@@ -332,6 +642,15 @@ bool hpuInterface::configureDevice(string device_name, bool spinnaker, bool loop
         }
     }
 
+    //a raw dump (file) or pipe can be used in place of the device for testing
+    struct stat fd_stat;
+    if(fstat(fd, &fd_stat) == 0 &&
+            (S_ISREG(fd_stat.st_mode) || S_ISFIFO(fd_stat.st_mode))) {
+        yWarning() << device_name << "is a file/pipe. Skipping HPU configuration";
+        pool_size = 4096;
+        return true;
+    }
+
     //READ IP configuration
     hpu_regs.reg_offset = ID_REG;
     hpu_regs.rw = 0;
@@ -478,12 +797,19 @@ bool hpuInterface::configureDevice(string device_name, bool spinnaker, bool loop
 
 bool hpuInterface::openReadPort(string module_name, bool direct_read,
                                 unsigned int packet_size,
-                                unsigned int maximum_internal_memory)
+                                unsigned int maximum_internal_memory,
+                                unsigned int packet_time,
+                                double packet_deadline, bool device_stamp,
+                                bool trace)
 {
     if(fd < 0 || !D2Y.open(module_name, fd, pool_size, direct_read, packet_size,
                            maximum_internal_memory))
         return false;
+    D2Y.setPacketLimits(packet_time, packet_deadline, device_stamp);
+    D2Y.setTrace(trace);
+    D2Y.setStats(stats);
 
+    this->module_name = module_name;
     read_thread_open = true;
     return true;
 }
@@ -492,7 +818,9 @@ bool hpuInterface::openWritePort(string module_name)
 {
     if(fd < 0 || !Y2D.open(module_name, fd))
         return false;
+    Y2D.setStats(stats);
 
+    this->module_name = module_name;
     write_thread_open = true;
     return true;
 }
@@ -500,6 +828,9 @@ bool hpuInterface::openWritePort(string module_name)
 
 void hpuInterface::start()
 {
+    if((read_thread_open || write_thread_open) &&
+            !stats.open(module_name + "/stats:o"))
+        yWarning() << "Could not open stats port";
     if(read_thread_open)
         D2Y.start();
     if(write_thread_open)
@@ -516,5 +847,6 @@ void hpuInterface::stop()
         Y2D.stop();
         write_thread_open = false;
     }
+    stats.close();
 
 }
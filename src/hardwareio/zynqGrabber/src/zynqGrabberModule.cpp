@@ -199,10 +199,21 @@ bool zynqGrabberModule::configure(yarp::os::ResourceFinder &rf) {
         int buffer_size  = 8 * rf.check("buffer_size", yarp::os::Value("5120000")).asInt();
         bool direct_read = rf.check("direct_read") &&
                 rf.check("direct_read", yarp::os::Value(true)).asBool();
+        //packets are also cut after packet_time (us) of event time, and
+        //partial packets are sent after packet_deadline (ms) of wall time
+        int packet_time = rf.check("packet_time", yarp::os::Value(0)).asInt() *
+                0.000001 * vtsHelper::vtsscaler;
+        double packet_deadline = 0.001 *
+                rf.check("packet_deadline", yarp::os::Value(0)).asDouble();
+        bool device_stamp = rf.check("device_stamp") &&
+                rf.check("device_stamp", yarp::os::Value(true)).asBool();
+        bool trace = rf.check("trace") &&
+                rf.check("trace", yarp::os::Value(true)).asBool();
 
         if(read_flag)
             if(!hpu.openReadPort(moduleName, direct_read, packet_size,
-                                 buffer_size))
+                                 buffer_size, packet_time, packet_deadline,
+                                 device_stamp, trace))
                 return false;
 
         if(write_flag)
@@ -25,6 +25,7 @@
 #include <yarp/sig/all.h>
 # include <yarp/math/Math.h>
 #include <iCub/eventdriven/all.h>
+#include <iCub/eventdriven/vImageCodecCV.h>
 #include <opencv2/opencv.hpp>
 
 class EventPort : public yarp::os::BufferedPort<ev::vBottle> {
@@ -106,6 +107,9 @@ private :
     yarp::os::BufferedPort<yarp::sig::ImageOf<yarp::sig::PixelBgr > > leftImagePortOut;
     yarp::os::BufferedPort<yarp::sig::ImageOf<yarp::sig::PixelBgr > > rightImagePortOut;
     yarp::os::BufferedPort<ev::vBottle> vPortOut;
+    ev::vImageEncoder leftEncoder;
+    ev::vImageEncoder rightEncoder;
+    bool compress{ false };
     ImageCollector leftImageCollector;
     ImageCollector rightImageCollector;
     EventCollector eventCollector;
@@ -122,6 +122,10 @@ bool DualCamTransformModule::updateModule() {
         ev::vQueue vLeftQueue = eventCollector.getEventsFromChannel(0);
         transform( leftCanvas, vLeftQueue, leftH, leftXOffset, leftYOffset );
         leftImagePortOut.write();
+        if(compress && leftEncoder.isConnected())
+            leftEncoder.send(leftCanvas.getRawImage(), leftCanvas.width(),
+                             leftCanvas.height(), leftCanvas.getRowSize(),
+                             yarp::os::Stamp());
     }
 
     if (rightImageCollector.isImageReady()){
@@ -140,6 +144,10 @@ bool DualCamTransformModule::updateModule() {
         ev::vQueue vRightQueue = eventCollector.getEventsFromChannel(1);
         transform( rightCanvas, vRightQueue, rightH, rightXOffset, rightYOffset );
         rightImagePortOut.write();
+        if(compress && rightEncoder.isConnected())
+            rightEncoder.send(rightCanvas.getRawImage(), rightCanvas.width(),
+                              rightCanvas.height(), rightCanvas.getRowSize(),
+                              yarp::os::Stamp());
     }
 
     return true;
@@ -412,6 +420,17 @@ bool DualCamTransformModule::configure( yarp::os::ResourceFinder &rf ) {
     leftImagePortOut.open(getName("/left/img:o"));
     rightImagePortOut.open(getName("/right/img:o"));
     vPortOut.open(getName("/vBottle:o"));
+
+    //also publish compressed images (jpg, png or sparse)
+    std::string format = rf.check("compress", yarp::os::Value("")).asString();
+    int quality = rf.check("quality", yarp::os::Value(90)).asInt();
+    compress = !format.empty();
+    if(compress && (!leftEncoder.open(getName("/left/compressed:o"), format,
+                                      quality, cvEncodeImage) ||
+                    !rightEncoder.open(getName("/right/compressed:o"), format,
+                                       quality, cvEncodeImage)))
+        return false;
+
     eventCollector.start();
     leftImageCollector.start();
     rightImageCollector.start();
@@ -453,6 +472,10 @@ bool DualCamTransformModule::interruptModule() {
 }
 
 bool DualCamTransformModule::close() {
+    if(compress) {
+        leftEncoder.close();
+        rightEncoder.close();
+    }
     leftImagePortOut.close();
     leftImageCollector.close();
     vLeftImageCollector.close();
@@ -0,0 +1,74 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// \defgroup Modules Modules
+// \defgroup evOffline evOffline
+// \ingroup Modules
+// \brief runs chains of processing cores over a recorded dataset
+
+#ifndef __EVOFFLINE__
+#define __EVOFFLINE__
+
+#include <yarp/os/all.h>
+#include <iCub/eventdriven/all.h>
+#include <string>
+#include <vector>
+
+/// \brief a processing core in the chain and its throughput statistics
+struct offlineStage
+{
+    std::string name;
+    ev::vProcessor *processor;
+    unsigned long int events_in;
+    unsigned long int events_out;
+    double seconds;
+};
+
+/// \brief reads a binary log (converting a data.log if needed), decodes each
+/// recorded packet and passes it through the chain of processing cores, the
+/// output of each stage being the input of the next. No ports are opened so
+/// the measured rates are those of the algorithms alone.
+class evOffline
+{
+private:
+
+    ev::vLogReader reader;
+    std::vector<offlineStage> stages;
+
+    //decoding statistics
+    unsigned long int packets;
+    unsigned long int events_decoded;
+    double decode_seconds;
+    double total_seconds;
+
+    ev::vProcessor * createProcessor(const std::string &name,
+                                     yarp::os::ResourceFinder &rf,
+                                     int width, int height);
+
+public:
+
+    evOffline();
+    ~evOffline();
+
+    bool configure(yarp::os::ResourceFinder &rf);
+    bool run();
+    void report();
+
+};
+
+#endif
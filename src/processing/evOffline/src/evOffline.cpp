@@ -0,0 +1,259 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "evOffline.h"
+#include "vFlowProcessor.h"
+#include "vHarrisProcessor.h"
+#include "vClusterProcessor.h"
+#include "vCircleProcessor.h"
+#include "vParticleProcessor.h"
+#include <cstdio>
+
+using namespace ev;
+using yarp::os::Value;
+
+int main(int argc, char * argv[])
+{
+    /* no yarp network is needed to process a dataset offline */
+    yarp::os::Network::init();
+
+    /* prepare and configure the resource finder */
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose();
+    rf.setDefaultContext( "eventdriven" );
+    rf.setDefaultConfigFile( "evOffline.ini" );
+    rf.configure( argc, argv );
+
+    evOffline offline;
+    if(!offline.configure(rf) || !offline.run())
+        return 1;
+    offline.report();
+
+    return 0;
+}
+
+/******************************************************************************/
+//evOffline
+/******************************************************************************/
+evOffline::evOffline()
+{
+    packets = 0;
+    events_decoded = 0;
+    decode_seconds = 0;
+    total_seconds = 0;
+}
+
+evOffline::~evOffline()
+{
+    for(unsigned int i = 0; i < stages.size(); i++)
+        delete stages[i].processor;
+}
+
+/******************************************************************************/
+vProcessor * evOffline::createProcessor(const std::string &name,
+                                        yarp::os::ResourceFinder &rf,
+                                        int width, int height)
+{
+    //the parameters of each stage are in a group of the same name, with the
+    //same defaults as the online modules
+    yarp::os::Bottle &p = rf.findGroup(name);
+
+    if(name == "vFlow") {
+        return new vFlowProcessor(height, width,
+                                  p.check("filterSize", Value(3)).asInt(),
+                                  p.check("minEvtsThresh", Value(5)).asInt());
+    }
+
+    if(name == "vCorner") {
+        return new vHarrisProcessor(height, width,
+                                    p.check("tempsize", Value(0.1)).asDouble(),
+                                    p.check("qsize", Value(36)).asInt(),
+                                    p.check("filterSize", Value(5)).asInt(),
+                                    p.check("spatial", Value(5)).asInt(),
+                                    p.check("sigma", Value(1.0)).asDouble(),
+                                    p.check("thresh", Value(8.0)).asDouble());
+    }
+
+    if(name == "vCluster") {
+        vClusterProcessor *cluster = new vClusterProcessor;
+        cluster->setAllParameters(p.check("alphaShape", Value(0.01)).asDouble(),
+                                  p.check("alphaPos", Value(0.1)).asDouble(),
+                                  p.check("tAct", Value(20)).asDouble(),
+                                  p.check("tInact", Value(10)).asDouble(),
+                                  p.check("tFree", Value(5)).asDouble(),
+                                  p.check("tClusRefr", Value(2)).asDouble(),
+                                  p.check("sigX", Value(5)).asDouble(),
+                                  p.check("sigY", Value(5)).asDouble(),
+                                  p.check("sigXY", Value(0)).asDouble(),
+                                  p.check("fixedShape", Value(false)).asBool(),
+                                  p.check("regRate", Value(50)).asInt(),
+                                  p.check("maxDist", Value(10)).asDouble(),
+                                  p.check("decay", Value(10000)).asDouble(),
+                                  p.check("clusterLimit", Value(-1)).asDouble());
+        return cluster;
+    }
+
+    if(name == "vCircle") {
+        bool usedirected = p.check("arc");
+        int arc = p.check("arc", Value(1)).asInt();
+        if(!arc) usedirected = false;
+
+        vCircleProcessor *circle = new vCircleProcessor;
+        circle->initialise(p.check("inlierThreshold", Value(30)).asDouble() / 100.0,
+                           p.check("qType", Value("edge")).asString(),
+                           p.check("radmin", Value(10)).asInt(),
+                           p.check("radmax", Value(35)).asInt(),
+                           usedirected, p.check("parallel"), width, height,
+                           arc, p.check("fifo", Value(1000.0)).asDouble());
+        circle->setSingleQ(p.check("everyevent") &&
+                           p.check("everyevent", Value(true)).asBool());
+        return circle;
+    }
+
+    if(name == "vParticleFilter") {
+        vParticleProcessor *particles = new vParticleProcessor;
+        particles->setObservationParameters(
+                    p.check("obsthresh", Value(20.0)).asDouble(),
+                    p.check("obsinlier", Value(1.5)).asDouble(),
+                    p.check("obsoutlier", Value(3.0)).asDouble());
+        yarp::os::Bottle *seed = p.find("seed").asList();
+        if(seed && seed->size() == 3)
+            particles->setSeed(seed->get(0).asDouble(), seed->get(1).asDouble(),
+                               seed->get(2).asDouble());
+        particles->initialise(width, height,
+                              p.check("rParticles", Value(100)).asInt(),
+                              p.check("rate", Value(1000)).asInt(),
+                              p.check("randoms", Value(0.0)).asDouble(),
+                              p.check("adaptive") &&
+                              p.check("adaptive", Value(true)).asBool(),
+                              p.check("variance", Value(0.5)).asDouble(),
+                              p.check("camera", Value(1)).asInt());
+        return particles;
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
+bool evOffline::configure(yarp::os::ResourceFinder &rf)
+{
+    std::string file = rf.check("file", Value("data.log")).asString();
+    int height = rf.check("height", Value(240)).asInt();
+    int width = rf.check("width", Value(304)).asInt();
+
+    std::string binlog = findBinaryLog(file);
+    if(binlog.empty() || !reader.open(binlog)) {
+        yError() << "Could not open" << file;
+        return false;
+    }
+
+    //the chain of processing stages, in order
+    yarp::os::Bottle *chain = rf.find("chain").asList();
+    if(!chain || !chain->size()) {
+        yError() << "Provide the processing chain, e.g. --chain \"(vFlow)\"";
+        return false;
+    }
+
+    for(int i = 0; i < chain->size(); i++) {
+        offlineStage stage;
+        stage.name = chain->get(i).asString();
+        stage.processor = createProcessor(stage.name, rf, width, height);
+        if(!stage.processor) {
+            yError() << "Unknown processing stage:" << stage.name;
+            return false;
+        }
+        stage.events_in = 0;
+        stage.events_out = 0;
+        stage.seconds = 0;
+        stages.push_back(stage);
+    }
+
+    return true;
+}
+
+/******************************************************************************/
+bool evOffline::run()
+{
+    vLogChunk chunk;
+    vQueue q, qout;
+
+    double tstart = yarp::os::Time::now();
+    while(reader.next(chunk)) {
+
+        //only address events are input to the chain
+        std::string tag = chunk.tag();
+        if(tag != AddressEvent::tag) continue;
+
+        int event_size = packetSize(tag);
+        event<> v = createEvent(tag);
+        if(!event_size || v == nullptr) continue;
+
+        //decode
+        double tic = yarp::os::Time::now();
+        q.clear();
+        int *data = (int *)chunk.data;
+        unsigned int n_events = chunk.header->n_ints / event_size;
+        for(unsigned int i = 0; i < n_events; i++) {
+            v->decode(data);
+            q.push_back(v->clone());
+        }
+        decode_seconds += yarp::os::Time::now() - tic;
+        events_decoded += n_events;
+        packets++;
+
+        //process, the output of each stage being the input to the next
+        for(unsigned int i = 0; i < stages.size(); i++) {
+            if(q.empty()) break;
+            qout.clear();
+
+            tic = yarp::os::Time::now();
+            stages[i].processor->process(q, qout);
+            stages[i].seconds += yarp::os::Time::now() - tic;
+
+            stages[i].events_in += q.size();
+            stages[i].events_out += qout.size();
+            q.swap(qout);
+        }
+    }
+    total_seconds = yarp::os::Time::now() - tstart;
+
+    if(!packets) {
+        yError() << "No" << AddressEvent::tag << "events in the log";
+        return false;
+    }
+
+    return true;
+}
+
+/******************************************************************************/
+void evOffline::report()
+{
+    std::printf("%-16s %12s %12s %10s %14s\n", "stage", "events in",
+                "events out", "seconds", "events/s");
+    std::printf("%-16s %12lu %12lu %10.3f %14.0f\n", "decode", events_decoded,
+                events_decoded, decode_seconds,
+                decode_seconds > 0 ? events_decoded / decode_seconds : 0.0);
+    for(unsigned int i = 0; i < stages.size(); i++) {
+        const offlineStage &s = stages[i];
+        std::printf("%-16s %12lu %12lu %10.3f %14.0f\n", s.name.c_str(),
+                    s.events_in, s.events_out, s.seconds,
+                    s.seconds > 0 ? s.events_in / s.seconds : 0.0);
+    }
+    std::printf("%lu packets processed in %.3f seconds\n", packets,
+                total_seconds);
+}
@@ -28,7 +28,7 @@
 #include <yarp/os/all.h>
 #include <iCub/eventdriven/all.h>
 
-#include "vCircleObserver.h"
+#include "vCircleProcessor.h"
 
 /*////////////////////////////////////////////////////////////////////////////*/
 //VCIRCLEREADER
@@ -50,22 +50,17 @@ private:
     yarp::os::Stamp pstamp;
     int pstampcounter;
 
-    bool singleq;
     double tsoffset;
 
 
 public:
 
-    vCircleMultiSize * cObserverL;
-    vCircleMultiSize * cObserverR;
-    double inlierThreshold;
+    vCircleProcessor processor;
     bool hough;
     double timecounter;
 
     vCircleReader();
 
-    void setSingleQ(bool singleq = true) { this->singleq = singleq; }
-
     bool    open(const std::string &name, bool strictness = false);
     void    close();
     void    interrupt();
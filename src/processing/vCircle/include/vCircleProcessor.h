@@ -0,0 +1,64 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VCIRCLEPROCESSOR__
+#define __VCIRCLEPROCESSOR__
+
+#include <iCub/eventdriven/all.h>
+#include "vCircleObserver.h"
+
+/// \brief detects circles in the left and right cameras with the Hough
+/// transform and outputs a GaussianAE (sigx = radius) for each detection
+class vCircleProcessor : public ev::vProcessor
+{
+private:
+
+    bool singleq;
+
+public:
+
+    vCircleMultiSize * cObserverL;
+    vCircleMultiSize * cObserverR;
+    double inlierThreshold;
+
+    vCircleProcessor();
+    ~vCircleProcessor();
+
+    void initialise(double inlierThreshold, std::string qType, int radmin,
+                    int radmax, bool directed, bool parallel, int width,
+                    int height, int arc, double fifolength);
+    void setSingleQ(bool singleq = true) { this->singleq = singleq; }
+    bool getSingleQ() { return singleq; }
+
+    /// \brief add a single event to the observer of its channel, returning
+    /// the best score (and circle) after the update
+    double update(const ev::event<> &v, int &x, int &y, int &r);
+    /// \brief add a queue of events to both observers
+    void update(ev::vQueue &q);
+    /// \brief get the best circle of a channel, appending a GaussianAE to
+    /// out if the score is above the inlierThreshold
+    double observe(int channel, unsigned int stamp, int &x, int &y, int &r,
+                   ev::vQueue &out);
+
+    /// \brief adds AddressEvents to the observers and outputs the circles
+    /// detected at the end of the batch
+    void process(const ev::vQueue &in, ev::vQueue &out);
+
+};
+
+#endif
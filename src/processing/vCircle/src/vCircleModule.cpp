@@ -72,20 +72,11 @@ bool vCircleModule::configure(yarp::os::ResourceFinder &rf)
 //    double measNoiseRad = rf.check("measNoiseRad",
 //                                   yarp::os::Value(5)).asDouble();
 
-    //data for experiments
-    circleReader.cObserverL =
-            new vCircleMultiSize(inlierThreshold, qType, radmin, radmax,
-                                 usedirected, parallel, width, height, arc, fifolength);
-    circleReader.cObserverL->setChannel(0);
-
-    circleReader.cObserverR =
-            new vCircleMultiSize(inlierThreshold, qType, radmin, radmax,
-                                 usedirected, parallel, width, height, arc, fifolength);
-    circleReader.cObserverR->setChannel(1);
-
     //initialise the dection and tracking
-    circleReader.inlierThreshold = inlierThreshold;
-    circleReader.setSingleQ(singleq);
+    circleReader.processor.initialise(inlierThreshold, qType, radmin, radmax,
+                                      usedirected, parallel, width, height,
+                                      arc, fifolength);
+    circleReader.processor.setSingleQ(singleq);
 
     //open the ports
     if(!circleReader.open(moduleName, strict)) {
@@ -128,12 +119,10 @@ double vCircleModule::getPeriod()
 /******************************************************************************/
 vCircleReader::vCircleReader()
 {
-    inlierThreshold = 5;
     hough = false;
     timecounter = 0;
     strictness = false;
     pstampcounter = -1;
-    singleq = false;
     tsoffset = 0;
 }
 
@@ -243,26 +232,17 @@ void vCircleReader::onRead(ev::vBottle &inBot)
     // processing & data dumping if required
     // ///////////////////
 
-    if(singleq) {
+    if(processor.getSingleQ()) {
         double bestScore;
         int bestx, besty, bestr;
-        ev::vQueue singleQ; singleQ.push_back(q.front());
         for(unsigned int i = 0; i < q.size(); i++) {
-            //singleQ.push_back(q[i]);
-            singleQ[0] = q[i];
-            if(q[i]->getChannel() == 0) {
-                cObserverL->addQueue(singleQ);
-                bestScore = cObserverL->getObs(bestx, besty, bestr);
-            } else {
-                cObserverR->addQueue(singleQ);
-                bestScore = cObserverR->getObs(bestx, besty, bestr);
-            }
+            bestScore = processor.update(q[i], bestx, besty, bestr);
             //save the results
             if(dumpOut.getOutputCount()) {
                 yarp::os::Bottle &dumper = dumpOut.prepare();
                 dumper.clear();
                 dumper.addDouble(yarp::os::Time::now() - tsoffset);
-                dumper.addInt(singleQ[0]->stamp);
+                dumper.addInt(q[i]->stamp);
                 dumper.addInt(q[i]->getChannel());
                 dumper.addInt(bestx);
                 dumper.addInt(besty);
@@ -271,51 +251,24 @@ void vCircleReader::onRead(ev::vBottle &inBot)
                 dumpOut.setEnvelope(st);
                 dumpOut.writeStrict();
             }
-            singleQ[0] = q.front();
-            //singleQ.clear();
         }
     } else {
-        cObserverL->addQueue(q);
-        cObserverR->addQueue(q);
+        processor.update(q);
     }
 
     // ///////////////////
     // send the results through in vBottle
     // ///////////////////
+    ev::vQueue circles;
     int bestxL, bestyL, bestrL;
-    double bestScoreL = cObserverL->getObs(bestxL, bestyL, bestrL);
-
-    if(bestScoreL > inlierThreshold) {
-
-        //std::cout << bestx << " " << besty << " " << bestr << std::endl;
-        auto circevent = ev::make_event<ev::GaussianAE>();
-
-        circevent->stamp = q.back()->stamp;
-        circevent->setChannel(0);
-        circevent->x = bestxL;
-        circevent->y = bestyL;
-        circevent->sigx = bestrL;
-        circevent->sigy = 1;
-        outBottle.addEvent(circevent);
-
-    }
-
+    double bestScoreL = processor.observe(0, q.back()->stamp, bestxL, bestyL,
+                                          bestrL, circles);
     int bestxR, bestyR, bestrR;
-    double bestScoreR = cObserverR->getObs(bestxR, bestyR, bestrR);
+    double bestScoreR = processor.observe(1, q.back()->stamp, bestxR, bestyR,
+                                          bestrR, circles);
 
-    if(bestScoreR > inlierThreshold) {
-
-        //std::cout << bestx << " " << besty << " " << bestr << std::endl;
-        auto circevent = ev::make_event<ev::GaussianAE>();
-        circevent->stamp = q.back()->stamp;
-        circevent->setChannel(1);
-        circevent->x = bestxR;
-        circevent->y = bestyR;
-        circevent->sigx = bestrR;
-        circevent->sigy = 1;
-        outBottle.addEvent(circevent);
-
-    }
+    for(ev::vQueue::iterator ci = circles.begin(); ci != circles.end(); ci++)
+        outBottle.addEvent(*ci);
 
     //send on our event bottle
     if(strictness) outPort.writeStrict();
@@ -326,7 +279,7 @@ void vCircleReader::onRead(ev::vBottle &inBot)
     // ///////////////////
 
     //save the results
-    if(!singleq && dumpOut.getOutputCount()) {
+    if(!processor.getSingleQ() && dumpOut.getOutputCount()) {
 
         double offsetts = yarp::os::Time::now() - tsoffset;
 
@@ -370,8 +323,8 @@ void vCircleReader::onRead(ev::vBottle &inBot)
     if(houghOut.getOutputCount() && (dstamp > 0.03333 || dstamp < 0)) {
         pstamp = st;
         yarp::sig::ImageOf< yarp::sig::PixelBgr> &image = houghOut.prepare();
-        image = cObserverR->makeDebugImage();
-        if(bestScoreR > inlierThreshold) {
+        image = processor.cObserverR->makeDebugImage();
+        if(bestScoreR > processor.inlierThreshold) {
             drawcircle(image, bestxR, bestyR, bestrR);
         }
         houghOut.setEnvelope(st);
@@ -0,0 +1,116 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vCircleProcessor.h"
+
+/******************************************************************************/
+vCircleProcessor::vCircleProcessor()
+{
+    cObserverL = 0;
+    cObserverR = 0;
+    inlierThreshold = 5;
+    singleq = false;
+}
+
+/******************************************************************************/
+vCircleProcessor::~vCircleProcessor()
+{
+    if(cObserverL) delete cObserverL;
+    if(cObserverR) delete cObserverR;
+}
+
+/******************************************************************************/
+void vCircleProcessor::initialise(double inlierThreshold, std::string qType,
+                                  int radmin, int radmax, bool directed,
+                                  bool parallel, int width, int height,
+                                  int arc, double fifolength)
+{
+    cObserverL = new vCircleMultiSize(inlierThreshold, qType, radmin, radmax,
+                                      directed, parallel, width, height, arc,
+                                      fifolength);
+    cObserverL->setChannel(0);
+
+    cObserverR = new vCircleMultiSize(inlierThreshold, qType, radmin, radmax,
+                                      directed, parallel, width, height, arc,
+                                      fifolength);
+    cObserverR->setChannel(1);
+
+    this->inlierThreshold = inlierThreshold;
+}
+
+/******************************************************************************/
+double vCircleProcessor::update(const ev::event<> &v, int &x, int &y, int &r)
+{
+    ev::vQueue singleQ(1, v);
+    if(v->getChannel() == 0) {
+        cObserverL->addQueue(singleQ);
+        return cObserverL->getObs(x, y, r);
+    } else {
+        cObserverR->addQueue(singleQ);
+        return cObserverR->getObs(x, y, r);
+    }
+}
+
+/******************************************************************************/
+void vCircleProcessor::update(ev::vQueue &q)
+{
+    cObserverL->addQueue(q);
+    cObserverR->addQueue(q);
+}
+
+/******************************************************************************/
+double vCircleProcessor::observe(int channel, unsigned int stamp, int &x,
+                                 int &y, int &r, ev::vQueue &out)
+{
+    vCircleMultiSize *observer = channel ? cObserverR : cObserverL;
+    double score = observer->getObs(x, y, r);
+
+    if(score > inlierThreshold) {
+        auto circevent = ev::make_event<ev::GaussianAE>();
+        circevent->stamp = stamp;
+        circevent->setChannel(channel);
+        circevent->x = x;
+        circevent->y = y;
+        circevent->sigx = r;
+        circevent->sigy = 1;
+        out.push_back(circevent);
+    }
+
+    return score;
+}
+
+/******************************************************************************/
+void vCircleProcessor::process(const ev::vQueue &in, ev::vQueue &out)
+{
+    ev::vQueue q = in;
+    ev::qsort(q, true);
+    if(q.empty()) return;
+
+    int x, y, r;
+    if(singleq) {
+        for(unsigned int i = 0; i < q.size(); i++)
+            update(q[i], x, y, r);
+    } else {
+        update(q);
+    }
+
+    observe(0, q.back()->stamp, x, y, r, out);
+    observe(1, q.back()->stamp, x, y, r, out);
+}
+
+//empty line to make gcc happy
@@ -23,7 +23,7 @@
 #include <yarp/os/all.h>
 #include <iCub/eventdriven/all.h>
 
-#include "trackerPool.h"
+#include "vClusterProcessor.h"
 
 #include <ctime>
 #include <string>
@@ -37,9 +37,8 @@ class EventBottleManager : public yarp::os::BufferedPort<ev::vBottle>
 
         yarp::os::BufferedPort<ev::vBottle>     outPort;            //output port for the eventBottle with the new events computed by the module
 
-        //create trackers, left and right
-        TrackerPool tracker_pool_left;
-        TrackerPool tracker_pool_right;
+        //the port-free cluster tracking
+        vClusterProcessor processor;
 
     public:
 
@@ -0,0 +1,51 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *           chiara.bartolozzi@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VCLUSTERPROCESSOR__
+#define __VCLUSTERPROCESSOR__
+
+#include <iCub/eventdriven/all.h>
+#include "trackerPool.h"
+
+/// \brief tracks clusters of events in the left and right cameras and
+/// outputs a GaussianAE each time a cluster emits an event
+class vClusterProcessor : public ev::vProcessor
+{
+private:
+
+    //create trackers, left and right
+    TrackerPool tracker_pool_left;
+    TrackerPool tracker_pool_right;
+
+public:
+
+    void setAllParameters(double alpha_shape, double alpha_pos,
+                          double Tact, double Tinact, double Tfree,
+                          double Tevent, double SigX, double SigY,
+                          double SigXY, bool Fixedshape, int Regrate,
+                          double Maxdist, double decay_tau,
+                          double clusterLimit);
+
+    /// \brief updates the trackers with AddressEvents and outputs the
+    /// cluster events
+    void process(const ev::vQueue &in, ev::vQueue &out);
+
+};
+
+#endif
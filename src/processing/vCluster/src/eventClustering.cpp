@@ -133,22 +133,9 @@ void EventBottleManager::setAllParameters(double alpha_shape, double alpha_pos,
                                           double Maxdist, double decay_tau,
                                           double clusterLimit)
 {
-    //left
-    tracker_pool_left.setComparisonParams(Maxdist);
-    tracker_pool_left.setDecayParams(decay_tau, Tact, Tinact, Tfree, Tevent,
-                                     Regrate);
-    tracker_pool_left.setInitialParams(SigX, SigY, SigXY, alpha_pos,
-                                       alpha_shape, Fixedshape);
-    tracker_pool_left.setClusterLimit(clusterLimit);
-
-    //right
-    tracker_pool_right.setComparisonParams(Maxdist);
-    tracker_pool_right.setDecayParams(decay_tau, Tact, Tinact, Tfree, Tevent,
-                                     Regrate);
-    tracker_pool_right.setInitialParams(SigX, SigY, SigXY, alpha_pos,
-                                       alpha_shape, Fixedshape);
-    tracker_pool_right.setClusterLimit(clusterLimit);
-
+    processor.setAllParameters(alpha_shape, alpha_pos, Tact, Tinact, Tfree,
+                               Tevent, SigX, SigY, SigXY, Fixedshape, Regrate,
+                               Maxdist, decay_tau, clusterLimit);
 }
 
 /******************************************************************************/
@@ -189,74 +176,16 @@ void EventBottleManager::interrupt()
 void EventBottleManager::onRead(ev::vBottle &bot)
 {
 
-    // prepare output vBottle with address events extended with
-    // cluster ID (aec) and cluster events (clep)
+    // prepare output vBottle with the cluster events
     ev::vBottle &evtCluster = outPort.prepare();
     evtCluster.clear();
-    std::vector<ev::event<ev::GaussianAE> > clEvts;
-    std::vector<ev::event<ev::GaussianAE> >::iterator ceit;
-
 
-    //create event queue and iterator
     ev::vQueue q = bot.getAll();
-    ev::vQueue::iterator qi;
-    //bot.getAll(q);
-
-    // checks for empty or non valid queue????
-    for(qi = q.begin(); qi != q.end(); qi++)
-    {
-        auto aep = ev::as_event<ev::AddressEvent>(*qi);
-        if(!aep) continue;
-
-        short channel           = aep->getChannel();
-
-        if (channel == 0) //Process events for left camera
-        {
-            clEvts.clear();
-            //int clusterAssignedTo = tracker_pool_left.update(aep, clEvts);
-            tracker_pool_left.update(aep, clEvts);
-
-//            //add the event depending if it was assigned a cluster
-//            if(clusterAssignedTo >= 0) {
-//                auto aec = ev::make_event<ev::LabelledAE>(aep);
-//                aec->ID = clusterAssignedTo;
-//                evtCluster.addEvent(aec);
-//            } else {
-//                evtCluster.addEvent(aep);
-//            }
-
-            //add the clusterEvents
-            for(ceit = clEvts.begin(); ceit != clEvts.end(); ceit++) {
-                (*ceit)->setChannel(0);
-                evtCluster.addEvent(*ceit);
-            }
-
-        }
-        else
-        {
-            clEvts.clear();
-            //int clusterAssignedTo = tracker_pool_right.update(aep, clEvts);
-            tracker_pool_right.update(aep, clEvts);
-
-//            //add the event depending if it was assigned a cluster
-//            if(clusterAssignedTo >= 0) {
-//                auto aec = ev::make_event<ev::LabelledAE>(aep);
-//                aec->ID = clusterAssignedTo;
-//                evtCluster.addEvent(aec);
-//            } else {
-//                evtCluster.addEvent(aep);
-//            }
-
-            //add the clusterEvents
-            for(ceit = clEvts.begin(); ceit != clEvts.end(); ceit++) {
-                (*ceit)->setChannel(1);
-                evtCluster.addEvent(*ceit);
-
-            }
-
-        }
-    }
+    ev::vQueue clEvts;
+    processor.process(q, clEvts);
 
+    for(ev::vQueue::iterator ceit = clEvts.begin(); ceit != clEvts.end(); ceit++)
+        evtCluster.addEvent(*ceit);
 
     outPort.write();
 }
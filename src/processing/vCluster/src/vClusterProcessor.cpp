@@ -0,0 +1,78 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *           chiara.bartolozzi@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vClusterProcessor.h"
+
+/******************************************************************************/
+void vClusterProcessor::setAllParameters(double alpha_shape, double alpha_pos,
+                                         double Tact, double Tinact,
+                                         double Tfree,
+                                         double Tevent, double SigX,
+                                         double SigY,
+                                         double SigXY, bool Fixedshape,
+                                         int Regrate,
+                                         double Maxdist, double decay_tau,
+                                         double clusterLimit)
+{
+    //left
+    tracker_pool_left.setComparisonParams(Maxdist);
+    tracker_pool_left.setDecayParams(decay_tau, Tact, Tinact, Tfree, Tevent,
+                                     Regrate);
+    tracker_pool_left.setInitialParams(SigX, SigY, SigXY, alpha_pos,
+                                       alpha_shape, Fixedshape);
+    tracker_pool_left.setClusterLimit(clusterLimit);
+
+    //right
+    tracker_pool_right.setComparisonParams(Maxdist);
+    tracker_pool_right.setDecayParams(decay_tau, Tact, Tinact, Tfree, Tevent,
+                                     Regrate);
+    tracker_pool_right.setInitialParams(SigX, SigY, SigXY, alpha_pos,
+                                       alpha_shape, Fixedshape);
+    tracker_pool_right.setClusterLimit(clusterLimit);
+
+}
+
+/******************************************************************************/
+void vClusterProcessor::process(const ev::vQueue &in, ev::vQueue &out)
+{
+    std::vector<ev::event<ev::GaussianAE> > clEvts;
+    std::vector<ev::event<ev::GaussianAE> >::iterator ceit;
+
+    for(ev::vQueue::const_iterator qi = in.begin(); qi != in.end(); qi++)
+    {
+        auto aep = ev::as_event<ev::AddressEvent>(*qi);
+        if(!aep) continue;
+
+        //process events for the left or right camera
+        int channel = aep->getChannel();
+        clEvts.clear();
+        if(channel == 0)
+            tracker_pool_left.update(aep, clEvts);
+        else
+            tracker_pool_right.update(aep, clEvts);
+
+        //add the clusterEvents
+        for(ceit = clEvts.begin(); ceit != clEvts.end(); ceit++) {
+            (*ceit)->setChannel(channel ? 1 : 0);
+            out.push_back(*ceit);
+        }
+    }
+}
+
+//empty line to make gcc happy
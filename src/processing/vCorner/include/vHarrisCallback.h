@@ -30,6 +30,7 @@
 #include <iCub/eventdriven/all.h>
 #include <iCub/eventdriven/vtsHelper.h>
 #include <filters.h>
+#include "vHarrisProcessor.h"
 #include <fstream>
 #include <math.h>
 #include <iomanip>
@@ -44,22 +45,18 @@ private:
     yarp::os::BufferedPort<ev::vBottle> outPort;
     yarp::os::BufferedPort<yarp::os::Bottle> debugPort;
 
-    //data structures
-    ev::temporalSurface *surfaceleft;
-    ev::temporalSurface *surfaceright;
-
-    //parameters
-    int height;
-    int width;
-    unsigned int qlen;
-    int temporalsize;
-    int windowRad;
-    double thresh;
-
     double tout;
 
-    filters convolution;
-    bool detectcorner(const ev::vQueue subsurf, int x, int y);
+    //the port-free corner detection
+    vHarrisProcessor processor;
+
+    //timing stats
+    ev::vStats stats;
+    ev::vHistogram &delay;
+    ev::vHistogram &latency;
+    ev::vCounter &events_in;
+    ev::vCounter &events_out;
+    ev::vGauge &queue;
 
 public:
 
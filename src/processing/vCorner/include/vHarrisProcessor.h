@@ -0,0 +1,56 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: valentina.vasco@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VHARRISPROCESSOR__
+#define __VHARRISPROCESSOR__
+
+#include <iCub/eventdriven/all.h>
+#include <filters.h>
+
+/// \brief detects corner events with the Harris score computed on the
+/// surface of most recent events around each incoming event
+class vHarrisProcessor : public ev::vProcessor
+{
+private:
+
+    //data structures
+    ev::temporalSurface *surfaceleft;
+    ev::temporalSurface *surfaceright;
+
+    //parameters
+    unsigned int qlen;
+    int temporalsize;
+    int windowRad;
+    double thresh;
+
+    filters convolution;
+    bool detectcorner(const ev::vQueue &subsurf, int x, int y);
+
+public:
+
+    vHarrisProcessor(int height, int width, double temporalsize, int qlen,
+                     int sobelsize, int windowRad, double sigma, double thresh);
+    ~vHarrisProcessor();
+
+    /// \brief adds AddressEvents to the surfaces and outputs a LabelledAE
+    /// (ID = 1) for each event detected as a corner
+    void process(const ev::vQueue &in, ev::vQueue &out);
+
+};
+
+#endif
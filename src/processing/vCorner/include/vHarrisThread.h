@@ -102,6 +102,14 @@ private:
     //synchronising value
     yarp::os::Stamp yarpstamp;
 
+    //timing stats
+    ev::vStats stats;
+    ev::vHistogram &delay;
+    ev::vHistogram &latency;
+    ev::vCounter &events_in;
+    ev::vCounter &events_skipped;
+    ev::vGauge &queue;
+
     //parameters
     unsigned int height;
     unsigned int width;
@@ -21,39 +21,13 @@
 using namespace ev;
 
 vHarrisCallback::vHarrisCallback(int height, int width, double temporalsize, int qlen,
-                                 int sobelsize, int windowRad, double sigma, double thresh)
+                                 int sobelsize, int windowRad, double sigma, double thresh) :
+    processor(height, width, temporalsize, qlen, sobelsize, windowRad, sigma, thresh),
+    delay(stats.histogram("delay")), latency(stats.histogram("process")),
+    events_in(stats.counter("events_in")),
+    events_out(stats.counter("events_out")), queue(stats.gauge("queue"))
 {
     std::cout << "Using HARRIS implementation..." << std::endl;
-
-    this->height = height;
-    this->width = width;
-    this->windowRad = windowRad;
-    this->temporalsize = temporalsize / ev::vtsHelper::tsscaler;
-
-    //ensure that sobel size is an odd number
-    if(!(sobelsize % 2))
-    {
-        std::cout << "Warning: sobelsize should be odd" << std::endl;
-        sobelsize--;
-        std::cout << "sobelsize = " << sobelsize << " will be used" << std::endl;
-    }
-
-    this->qlen = qlen;
-    this->thresh = thresh;
-
-    int gaussiansize = 2*windowRad + 2 - sobelsize;
-    convolution.configure(sobelsize, gaussiansize);
-    convolution.setSobelFilters();
-    convolution.setGaussianFilter(sigma);
-
-    std::cout << "Using a " << sobelsize << "x" << sobelsize << " filter ";
-    std::cout << "and a " << 2*windowRad + 1 << "x" << 2*windowRad + 1 << " spatial window" << std::endl;
-
-    //create surface representations
-    std::cout << "Creating surfaces..." << std::endl;
-    surfaceleft = new temporalSurface(width, height, this->temporalsize);
-    surfaceright = new temporalSurface(width, height, this->temporalsize);
-
     this->tout = 0;
 
 }
@@ -77,7 +51,9 @@ bool vHarrisCallback::open(const std::string moduleName, bool strictness)
     std::string debugPortName = "/" + moduleName + "/debug:o";
     bool check3 = debugPort.open(debugPortName);
 
-    return check1 && check2 && check3;
+    bool check4 = stats.open("/" + moduleName + "/stats:o");
+
+    return check1 && check2 && check3 && check4;
 
 }
 
@@ -85,13 +61,11 @@ bool vHarrisCallback::open(const std::string moduleName, bool strictness)
 void vHarrisCallback::close()
 {
     //close ports
+    stats.close();
     debugPort.close();
     outPort.close();
     yarp::os::BufferedPort<ev::vBottle>::close();
 
-    delete surfaceleft;
-    delete surfaceright;
-
 }
 
 /**********************************************************/
@@ -107,44 +81,33 @@ void vHarrisCallback::interrupt()
 /**********************************************************/
 void vHarrisCallback::onRead(ev::vBottle &bot)
 {
+    ev::vScopedTimer timer(latency);
+    yarp::os::Stamp st;
+    this->getEnvelope(st);
+    if(st.isValid())
+        delay.record(yarp::os::Time::now() - st.getTime());
+    queue.set(this->getPendingReads());
+
     ev::vBottle fillerbottle;
-    bool isc = false;
 
     /*get the event queue in the vBottle bot*/
     ev::vQueue q = bot.get<AE>();
-    for(ev::vQueue::iterator qi = q.begin(); qi != q.end(); qi++)
-    {
-        auto ae = is_event<AE>(*qi);
-        ev::temporalSurface *cSurf;
-        if(ae->getChannel() == 0)
-            cSurf = surfaceleft;
-        else
-            cSurf = surfaceright;
-        cSurf->fastAddEvent(*qi);
-
-        vQueue subsurf;
-        subsurf = cSurf->getSurf_Clim(qlen, ae->x, ae->y, windowRad);
-        isc = detectcorner(subsurf, ae->x, ae->y);
-
-        //if it's a corner, add it to the output bottle
-        if(isc) {
-            auto ce = make_event<LabelledAE>(ae);
-            ce->ID = 1;
-            fillerbottle.addEvent(ce);
-        }
-
-        if(debugPort.getOutputCount()) {
-            yarp::os::Bottle &scorebottleout = debugPort.prepare();
-            scorebottleout.clear();
-//            scorebottleout.addDouble(cpudelay);
-            debugPort.write();
-        }
-
+    ev::vQueue corners;
+    processor.process(q, corners);
+    events_in.add(q.size());
+
+    //add the corners to the output bottle
+    for(ev::vQueue::iterator qi = corners.begin(); qi != corners.end(); qi++)
+        fillerbottle.addEvent(*qi);
+
+    if(debugPort.getOutputCount()) {
+        yarp::os::Bottle &scorebottleout = debugPort.prepare();
+        scorebottleout.clear();
+        debugPort.write();
     }
 
     if( (yarp::os::Time::now() - tout) > 0.001 && fillerbottle.size() ) {
-        yarp::os::Stamp st;
-        this->getEnvelope(st);
+        events_out.add(fillerbottle.size());
         outPort.setEnvelope(st);
         ev::vBottle &eventsout = outPort.prepare();
         eventsout.clear();
@@ -156,33 +119,4 @@ void vHarrisCallback::onRead(ev::vBottle &bot)
 
 }
 
-/**********************************************************/
-bool vHarrisCallback::detectcorner(const vQueue subsurf, int x, int y)
-{
-
-    //set the final response to be centred on the curren event
-    convolution.setResponseCenter(x, y);
-
-    //update filter response
-    for(unsigned int i = 0; i < subsurf.size(); i++)
-    {
-        //events are in the surface
-        auto vi = is_event<AE>(subsurf[i]);
-        convolution.applysobel(vi);
-
-    }
-    convolution.applygaussian();
-
-    double score = convolution.getScore();
-
-    //reset responses
-    convolution.reset();
-
-    //if score > thresh tag ae as ce
-    return score > thresh;
-
-}
-
-
 //empty line to make gcc happy
-
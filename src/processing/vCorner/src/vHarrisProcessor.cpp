@@ -0,0 +1,111 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: valentina.vasco@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vHarrisProcessor.h"
+
+using namespace ev;
+
+vHarrisProcessor::vHarrisProcessor(int height, int width, double temporalsize,
+                                   int qlen, int sobelsize, int windowRad,
+                                   double sigma, double thresh)
+{
+    this->windowRad = windowRad;
+    this->temporalsize = temporalsize / ev::vtsHelper::tsscaler;
+
+    //ensure that sobel size is an odd number
+    if(!(sobelsize % 2))
+    {
+        std::cout << "Warning: sobelsize should be odd" << std::endl;
+        sobelsize--;
+        std::cout << "sobelsize = " << sobelsize << " will be used" << std::endl;
+    }
+
+    this->qlen = qlen;
+    this->thresh = thresh;
+
+    int gaussiansize = 2*windowRad + 2 - sobelsize;
+    convolution.configure(sobelsize, gaussiansize);
+    convolution.setSobelFilters();
+    convolution.setGaussianFilter(sigma);
+
+    std::cout << "Using a " << sobelsize << "x" << sobelsize << " filter ";
+    std::cout << "and a " << 2*windowRad + 1 << "x" << 2*windowRad + 1 << " spatial window" << std::endl;
+
+    //create surface representations
+    surfaceleft = new temporalSurface(width, height, this->temporalsize);
+    surfaceright = new temporalSurface(width, height, this->temporalsize);
+}
+
+vHarrisProcessor::~vHarrisProcessor()
+{
+    delete surfaceleft;
+    delete surfaceright;
+}
+
+/**********************************************************/
+void vHarrisProcessor::process(const ev::vQueue &in, ev::vQueue &out)
+{
+    for(ev::vQueue::const_iterator qi = in.begin(); qi != in.end(); qi++)
+    {
+        auto ae = is_event<AE>(*qi);
+        ev::temporalSurface *cSurf;
+        if(ae->getChannel() == 0)
+            cSurf = surfaceleft;
+        else
+            cSurf = surfaceright;
+        cSurf->fastAddEvent(*qi);
+
+        vQueue subsurf = cSurf->getSurf_Clim(qlen, ae->x, ae->y, windowRad);
+
+        //if it's a corner, add it to the output
+        if(detectcorner(subsurf, ae->x, ae->y)) {
+            auto ce = make_event<LabelledAE>(ae);
+            ce->ID = 1;
+            out.push_back(ce);
+        }
+    }
+}
+
+/**********************************************************/
+bool vHarrisProcessor::detectcorner(const vQueue &subsurf, int x, int y)
+{
+
+    //set the final response to be centred on the curren event
+    convolution.setResponseCenter(x, y);
+
+    //update filter response
+    for(unsigned int i = 0; i < subsurf.size(); i++)
+    {
+        //events are in the surface
+        auto vi = is_event<AE>(subsurf[i]);
+        convolution.applysobel(vi);
+
+    }
+    convolution.applygaussian();
+
+    double score = convolution.getScore();
+
+    //reset responses
+    convolution.reset();
+
+    //if score > thresh tag ae as ce
+    return score > thresh;
+
+}
+
+//empty line to make gcc happy
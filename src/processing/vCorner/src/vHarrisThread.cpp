@@ -22,7 +22,11 @@ using namespace ev;
 
 vHarrisThread::vHarrisThread(unsigned int height, unsigned int width, std::string name, bool strict, int qlen,
                              double temporalsize, int windowRad, int sobelsize, double sigma, double thresh,
-                             int nthreads, double gain)
+                             int nthreads, double gain) :
+    delay(stats.histogram("delay")), latency(stats.histogram("process")),
+    events_in(stats.counter("events_in")),
+    events_skipped(stats.counter("events_skipped")),
+    queue(stats.gauge("queue"))
 {
     std::cout << "Using HARRIS implementation..." << std::endl;
 
@@ -82,6 +86,11 @@ bool vHarrisThread::threadInit()
         return false;
     }
 
+    if(!stats.open("/" + name + "/stats:o")) {
+        std::cout << "could not open stats port" << std::endl;
+        return false;
+    }
+
     std::cout << "Thread initialised" << std::endl;
     return true;
 }
@@ -89,6 +98,7 @@ bool vHarrisThread::threadInit()
 
 void vHarrisThread::onStop()
 {
+    stats.close();
     debugPort.close();
     inputPort.close();
     inputPort.releaseDataLock();
@@ -118,6 +128,12 @@ void vHarrisThread::run()
         }
         if(isStopping()) break;
 
+        double tstart = yarp::os::Time::now();
+        if(yarpstamp.isValid())
+            delay.record(tstart - yarpstamp.getTime());
+        queue.set(inputPort.queryunprocessed());
+        events_in.add(q->size());
+
         //skip events based on delay in the queue
         unsigned int delay_n = inputPort.queryDelayN();
 //        double increment = gain * (delay_n - q->size()) / minAcceptableDelay;
@@ -173,6 +189,9 @@ void vHarrisThread::run()
             }
         }
 
+        events_skipped.add(q->size() - countProcessed);
+        latency.record(yarp::os::Time::now() - tstart);
+
         static double prevtime = yarp::os::Time::now();
         if(debugPort.getOutputCount()) {
 
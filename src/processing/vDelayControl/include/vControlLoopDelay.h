@@ -80,12 +80,24 @@ private:
 
     yarp::os::BufferedPort< yarp::sig::ImageOf< yarp::sig::PixelBgr> > debugPort;
 
+    //the publisher is asked only for the events around the target
+    std::string name;
+    bool roi_filter;
+    double roi_margin;
+    vPortFilterClient roiFilter;
+    vPortFilter requested;
+
+    void requestROI(double roisize, int channel);
+
 
 public:
 
-    delayControl() {}
+    delayControl() : roi_filter(false), roi_margin(2.0) {}
 
     bool open(std::string name, unsigned int qlimit = 0);
+    /// \brief ask the publisher (a vFilteredWritePort) for only the events
+    /// within margin times the region of interest, while the target is found
+    bool setROISource(std::string publisher, double margin);
     void initFilter(int width, int height, int nparticles,
                     int bins, bool adaptive, int nthreads,
                     double minlikelihood, double inlierThresh, double randoms, double negativeBias);
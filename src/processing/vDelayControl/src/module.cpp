@@ -103,6 +103,10 @@ bool module::configure(yarp::os::ResourceFinder &rf)
     }
     if(!delaycontrol.open(getName(), qlimit))
         return false;
+    if(rf.check("roiSource") &&
+            !delaycontrol.setROISource(rf.find("roiSource").asString(),
+                                       rf.check("roiMargin", yarp::os::Value(2.0)).asDouble()))
+        return false;
     return delaycontrol.start();
 
 }
@@ -117,6 +117,7 @@ yarp::sig::Vector delayControl::getTrackingStats()
 
 bool delayControl::open(std::string name, unsigned int qlimit)
 {
+    this->name = name;
     inputPort.setQLimit(qlimit);
     if(!inputPort.open(name + "/vBottle:i"))
         return false;
@@ -131,8 +132,41 @@ bool delayControl::open(std::string name, unsigned int qlimit)
     return true;
 }
 
+bool delayControl::setROISource(std::string publisher, double margin)
+{
+    if(!roiFilter.open(name, name + "/vBottle:i"))
+        return false;
+    if(!roiFilter.connect(publisher)) {
+        yError() << "Could not connect to" << publisher + "/filter";
+        return false;
+    }
+    roi_filter = true;
+    roi_margin = std::max(margin, 1.0);
+    return true;
+}
+
+void delayControl::requestROI(double roisize, int channel)
+{
+    //the request is only moved when the region of interest leaves it (or is
+    //much smaller), as a new request takes a round trip to the publisher
+    int x0 = avgx - roisize, x1 = avgx + roisize;
+    int y0 = avgy - roisize, y1 = avgy + roisize;
+    if(requested.roi && requested.channel == channel &&
+            x0 >= requested.x0 && x1 <= requested.x1 &&
+            y0 >= requested.y0 && y1 <= requested.y1 &&
+            requested.x1 - requested.x0 < 2 * roi_margin * (x1 - x0))
+        return;
+
+    double margin = roisize * roi_margin;
+    requested.channel = channel;
+    requested.setROI(avgx - margin, avgy - margin, avgx + margin,
+                     avgy + margin);
+    roiFilter.request(requested);
+}
+
 void delayControl::onStop()
 {
+    if(roi_filter) roiFilter.close();
     inputPort.close();
     outputPort.close();
     //scopePort.close();
@@ -243,6 +277,11 @@ void delayControl::run()
 
             if(!stagnantstart) {
                 stagnantstart = yarp::os::Time::now();
+                //the full stream is needed to find the target again
+                if(roi_filter && requested.roi) {
+                    roiFilter.release();
+                    requested = vPortFilter();
+                }
             } else {
                 if(yarp::os::Time::now() - stagnantstart > resetTimeout) {
                     vpf.resetToSeed();
@@ -252,6 +291,7 @@ void delayControl::run()
 
         } else {
             stagnantstart = 0;
+            if(roi_filter) requestROI(roisize, channel);
         }
 
 
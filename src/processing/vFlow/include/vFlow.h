@@ -23,41 +23,29 @@
 
 #include <yarp/os/all.h>
 #include <yarp/sig/all.h>
-#include <yarp/math/Math.h>
-#include <yarp/math/SVD.h>
 #include <iCub/eventdriven/all.h>
+#include "vFlowProcessor.h"
 
 class vFlowManager : public yarp::os::BufferedPort<ev::vBottle>
 {
 private:
 
     //parameters
-    int fRad;               //! radius of the fitted plane
-    unsigned int planeSize; //! area of the fitted plane
-    int minEvtsOnPlane;     //! minimum number of events for a valid plane
     bool strictness;        //! don't lose events!
 
     //ports
     yarp::os::BufferedPort<ev::vBottle> outPort;
 
-    //data structures
-    ev::vSurface2 *surfaceOnL;
-    ev::vSurface2 *surfaceOfL;
-    ev::vSurface2 *surfaceOnR;
-    ev::vSurface2 *surfaceOfR;
-
-    yarp::sig::Matrix At;
-    yarp::sig::Matrix AtA;
-    yarp::sig::Matrix A2;
-    yarp::sig::Vector abc;
-
-    //coputation functions
-    bool compute(ev::vSurface2 *surf, double &vx, double &vy);
-    int computeGrads(yarp::sig::Matrix &A, yarp::sig::Vector &Y,
-                      double cx, double cy, double cz,
-                      double &dtdy, double &dtdx);
-    int computeGrads(const ev::vQueue &subsurf, ev::event<ev::AddressEvent> cen,
-                      double &dtdy, double &dtdx);
+    //the port-free flow computation
+    vFlowProcessor processor;
+
+    //timing stats
+    ev::vStats stats;
+    ev::vHistogram &delay;
+    ev::vHistogram &latency;
+    ev::vCounter &events_in;
+    ev::vCounter &events_out;
+    ev::vGauge &queue;
 
 public:
 
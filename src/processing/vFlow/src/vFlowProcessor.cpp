@@ -0,0 +1,213 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vFlowProcessor.h"
+
+using yarp::math::outerProduct;
+using namespace ev;
+
+vFlowProcessor::vFlowProcessor(int height, int width, int filterSize,
+                               int minEvtsOnPlane)
+{
+    //ensure sobel size is at least 3 and an odd number
+    if(filterSize < 5) filterSize = 3;
+    if(!(filterSize % 2)) filterSize--;
+    this->fRad = filterSize / 2;
+    this->planeSize = pow(filterSize, 2.0);
+
+    this->minEvtsOnPlane = minEvtsOnPlane;
+
+    //for speed we predefine the mememory for some matricies
+    At = yarp::sig::Matrix(3, filterSize * filterSize);
+    AtA = yarp::sig::Matrix(3,3);
+    abc = yarp::sig::Vector(3);
+    A2 = yarp::sig::Matrix(3, 3);
+
+
+    //create our surface in synchronous mode
+    surfaceOnL = new ev::temporalSurface(width, height);
+    surfaceOfL = new ev::temporalSurface(width, height);
+    surfaceOnR = new ev::temporalSurface(width, height);
+    surfaceOfR = new ev::temporalSurface(width, height);
+}
+
+vFlowProcessor::~vFlowProcessor()
+{
+    delete surfaceOnL;
+    delete surfaceOfL;
+    delete surfaceOnR;
+    delete surfaceOfR;
+}
+
+void vFlowProcessor::process(const ev::vQueue &in, ev::vQueue &out)
+{
+    for(vQueue::const_iterator qi = in.begin(); qi != in.end(); qi++)
+    {
+        auto aep = is_event<AE>(*qi);
+
+        //add the event to the appropriate surface
+        vSurface2 * cSurf;
+        if(aep->getChannel()) {
+            if(aep->polarity)
+                cSurf = surfaceOfR;
+            else
+                cSurf = surfaceOnR;
+        } else {
+            if(aep->polarity)
+                cSurf = surfaceOfL;
+            else
+                cSurf = surfaceOnL;
+        }
+
+        //compute the flow
+        cSurf->fastAddEvent(aep);
+        double vx, vy;
+        if(compute(cSurf, vx, vy)) {
+            //successfully computed a flow event
+            auto vf = make_event<FlowEvent>(aep);
+            vf->vx = vx;
+            vf->vy = vy;
+            out.push_back(vf);
+        }
+    }
+}
+
+bool vFlowProcessor::compute(ev::vSurface2 *surf, double &vx, double &vy)
+{
+
+    //get the most recent event
+    auto vr = is_event<AE>(surf->getMostRecent());
+
+
+    //find the side of this event that has the collection of temporally nearby
+    //events. Heuristically more likely to be the correct plane.
+    double bestscore = ev::vtsHelper::max_stamp+1;
+    int besti = 0, bestj = 0;
+
+    for(int i = vr->x-fRad; i <= vr->x+fRad; i+=fRad) {
+        for(int j = vr->y-fRad; j <= vr->y+fRad; j+=fRad) {
+            //get the surface around the recent event
+            double sobeltsdiff = 0;
+            const vQueue subsurf = surf->getSurf(i, j, fRad);
+            if(subsurf.size() < planeSize) continue;
+
+            for(unsigned int k = 0; k < subsurf.size(); k++) {
+                sobeltsdiff += vr->stamp - subsurf[k]->stamp;
+                if(subsurf[k]->stamp > vr->stamp) {
+                    //subsurf[k]->setStamp(subsurf[k]->stamp -
+                    //                     eventdriven::vtsHelper::maxStamp());
+                    sobeltsdiff += ev::vtsHelper::max_stamp;
+                }
+            }
+            sobeltsdiff /= subsurf.size();
+            if(sobeltsdiff < bestscore) {
+                bestscore = sobeltsdiff;
+                besti = i; bestj = j;
+            }
+        }
+    }
+    //return if we don't find a good candidate plane
+    if(bestscore > ev::vtsHelper::max_stamp) return false;
+
+
+    //get the events
+    const vQueue &subsurf = surf->getSurf(besti, bestj, fRad);
+    //const vQueue &subsurf = surf->getSurf(vr->x, vr->y, fRad);
+
+    //and compute the gradients of the plane
+    if(computeGrads(subsurf, vr, vy, vx) < minEvtsOnPlane)
+        return false;
+
+    return true;
+}
+
+int vFlowProcessor::computeGrads(const ev::vQueue &subsurf,
+                                     event<ev::AddressEvent> cen,
+                                     double &dtdy, double &dtdx)
+{
+
+    yarp::sig::Matrix A(subsurf.size(), 3);
+    yarp::sig::Vector Y(subsurf.size());
+    for(unsigned int vi = 0; vi < subsurf.size(); vi++) {
+        event<ev::AddressEvent> v = as_event<ev::AddressEvent>(subsurf[vi]);
+        A(vi, 0) = v->x;
+        A(vi, 1) = v->y;
+        A(vi, 2) = 1;
+        if(v->stamp > cen->stamp) {
+            Y(vi) = (v->stamp - ev::vtsHelper::max_stamp) * ev::vtsHelper::tstosecs();
+        } else {
+            Y(vi) = v->stamp * ev::vtsHelper::tstosecs();
+        }
+    }
+
+    return computeGrads(A, Y, cen->x, cen->y, cen->stamp *
+                        ev::vtsHelper::tstosecs(), dtdy, dtdx);
+}
+
+int vFlowProcessor::computeGrads(yarp::sig::Matrix &A, yarp::sig::Vector &Y,
+                                     double cx, double cy, double cz,
+                                     double &dtdy, double &dtdx)
+{
+
+    At=A.transposed();
+    AtA=At*A;
+
+    double* dataATA=AtA.data();
+    double DET=*dataATA*( *(dataATA+8)**(dataATA+4)-*(dataATA+7)**(dataATA+5))-
+            *(dataATA+3)*(*(dataATA+8)**(dataATA+1)-*(dataATA+7)**(dataATA+2))+
+            *(dataATA+6)*(*(dataATA+5)**(dataATA+1)-*(dataATA+4)**(dataATA+2));
+    if(DET < 1) return 0;
+
+
+    double *dataA=A2.data();
+    DET=1.0/DET;
+    *(dataA+0)=DET*(*(dataATA+8)**(dataATA+4)-*(dataATA+7)**(dataATA+5));
+    *(dataA+1)=DET*(*(dataATA+7)**(dataATA+2)-*(dataATA+8)**(dataATA+1));
+    *(dataA+2)=DET*(*(dataATA+5)**(dataATA+1)-*(dataATA+4)**(dataATA+2));
+    *(dataA+3)=DET*(*(dataATA+6)**(dataATA+5)-*(dataATA+8)**(dataATA+3));
+    *(dataA+4)=DET*(*(dataATA+8)**(dataATA+0)-*(dataATA+6)**(dataATA+2));
+    *(dataA+5)=DET*(*(dataATA+3)**(dataATA+2)-*(dataATA+5)**(dataATA+0));
+    *(dataA+6)=DET*(*(dataATA+7)**(dataATA+3)-*(dataATA+6)**(dataATA+4));
+    *(dataA+7)=DET*(*(dataATA+6)**(dataATA+1)-*(dataATA+7)**(dataATA+0));
+    *(dataA+8)=DET*(*(dataATA+4)**(dataATA+0)-*(dataATA+3)**(dataATA+1));
+
+    abc=A2*At*Y;
+
+    double dtdp = sqrt(pow(abc(0), 2.0) + pow(abc(1), 2.0));
+    int inliers = 0;
+    for(unsigned int i = 0; i < A.rows(); i++) {
+        //so I think that abc(0) and abc(1) are already scaled to the magnitude
+        //of the slope of the plane. E.g. when only using abc(0) and abc(1) and
+        //fitting a 3-point plane we always get 0 error. Therefore the differ-
+        //ence in time is perfect with only abc(0,1) and the speed should also
+        //be.
+        double planedt = (abc(0) * (A(i, 0) - cx) + abc(1) * (A(i, 1) - cy));
+        double actualdt =  Y(i) - cz;
+        if(fabs(planedt - actualdt) < dtdp/2) inliers++;
+
+    }
+
+    double speed = 1.0 / dtdp;
+
+    double angle = atan2(abc(0), abc(1));
+    dtdx = speed * cos(angle);
+    dtdy = speed * sin(angle);
+
+
+    return inliers;
+}
@@ -0,0 +1,75 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// \defgroup Modules Modules
+// \defgroup vFrameDecoder vFrameDecoder
+// \ingroup Modules
+// \brief decompresses the compressed images of vFramer and DualCamTransform
+
+#ifndef __VFRAMEDECODER__
+#define __VFRAMEDECODER__
+
+#include <yarp/os/all.h>
+#include <yarp/sig/all.h>
+#include <iCub/eventdriven/all.h>
+#include <iCub/eventdriven/vImageCodecCV.h>
+
+/// \brief decompresses each image received and publishes it as an
+/// uncompressed image with the same envelope (e.g. to be shown by yarpview)
+class vFrameDecoder : public yarp::os::BufferedPort<ev::vEncodedImage>
+{
+private:
+
+    yarp::os::BufferedPort< yarp::sig::ImageOf<yarp::sig::PixelBgr> > image_port;
+
+    unsigned int n_decoded;
+    unsigned int n_failed;
+    unsigned long int bytes_in;
+    unsigned long int bytes_out;
+
+public:
+
+    vFrameDecoder();
+
+    bool open(const std::string &name);
+    void close();
+    void interrupt();
+
+    /// \brief print the compression ratio since the last report
+    void report(double period);
+
+    void onRead(ev::vEncodedImage &encoded);
+
+};
+
+class vFrameDecoderModule : public yarp::os::RFModule
+{
+    vFrameDecoder decoder;
+
+public:
+
+    //the virtual functions that need to be overloaded
+    virtual bool configure(yarp::os::ResourceFinder &rf);
+    virtual bool interruptModule();
+    virtual bool close();
+    virtual double getPeriod();
+    virtual bool updateModule();
+
+};
+
+#endif
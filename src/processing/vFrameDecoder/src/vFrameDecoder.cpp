@@ -0,0 +1,144 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vFrameDecoder.h"
+
+using namespace yarp::os;
+using namespace yarp::sig;
+
+int main(int argc, char * argv[])
+{
+    /* initialize yarp network */
+    yarp::os::Network yarp;
+    if(!yarp.checkNetwork()) {
+        yError() << "Could not find YARP";
+        return 1;
+    }
+
+    /* prepare and configure the resource finder */
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose();
+    rf.setDefaultContext( "eventdriven" );
+    rf.setDefaultConfigFile( "vFrameDecoder.ini" );
+    rf.configure( argc, argv );
+
+    /* create the module */
+    vFrameDecoderModule decoderModule;
+    /* run the module: runModule() calls configure first and, if successful, it then runs */
+    return decoderModule.runModule(rf);
+}
+
+/******************************************************************************/
+//vFrameDecoder
+/******************************************************************************/
+vFrameDecoder::vFrameDecoder()
+{
+    n_decoded = 0;
+    n_failed = 0;
+    bytes_in = 0;
+    bytes_out = 0;
+    useCallback();
+}
+
+bool vFrameDecoder::open(const std::string &name)
+{
+    if(!BufferedPort<ev::vEncodedImage>::open(name + "/compressed:i"))
+        return false;
+    return image_port.open(name + "/image:o");
+}
+
+void vFrameDecoder::interrupt()
+{
+    image_port.interrupt();
+    BufferedPort<ev::vEncodedImage>::interrupt();
+}
+
+void vFrameDecoder::close()
+{
+    image_port.close();
+    BufferedPort<ev::vEncodedImage>::close();
+}
+
+void vFrameDecoder::onRead(ev::vEncodedImage &encoded)
+{
+    if(encoded.width <= 0 || encoded.height <= 0) {
+        n_failed++;
+        return;
+    }
+
+    ImageOf<PixelBgr> &image = image_port.prepare();
+    image.resize(encoded.width, encoded.height);
+    if(!ev::decodeImage(encoded, image.getRawImage(),
+                        image.getRowSize(), ev::cvDecodeImage)) {
+        image_port.unprepare();
+        n_failed++;
+        return;
+    }
+
+    n_decoded++;
+    bytes_in += encoded.data.size();
+    bytes_out += encoded.width * encoded.height * 3;
+
+    Stamp ystamp;
+    getEnvelope(ystamp);
+    image_port.setEnvelope(ystamp);
+    image_port.write();
+}
+
+void vFrameDecoder::report(double period)
+{
+    if(n_decoded || n_failed) {
+        yInfo() << getName() << n_decoded / period << "images/s, compressed to"
+                << (bytes_out ? 100.0 * bytes_in / bytes_out : 0.0) << "%"
+                << "(" << n_failed << "failed )";
+    }
+    n_decoded = n_failed = 0;
+    bytes_in = bytes_out = 0;
+}
+
+/******************************************************************************/
+//vFrameDecoderModule
+/******************************************************************************/
+bool vFrameDecoderModule::configure(yarp::os::ResourceFinder &rf)
+{
+    setName(rf.check("name", yarp::os::Value("/vFrameDecoder")).asString().c_str());
+    return decoder.open(getName());
+}
+
+bool vFrameDecoderModule::interruptModule()
+{
+    decoder.interrupt();
+    return yarp::os::RFModule::interruptModule();
+}
+
+bool vFrameDecoderModule::close()
+{
+    decoder.close();
+    return yarp::os::RFModule::close();
+}
+
+bool vFrameDecoderModule::updateModule()
+{
+    decoder.report(getPeriod());
+    return !isStopping();
+}
+
+double vFrameDecoderModule::getPeriod()
+{
+    return 5.0;
+}
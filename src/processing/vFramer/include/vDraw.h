@@ -23,7 +23,10 @@
 #define __vDraw__
 
 #include <iCub/eventdriven/all.h>
+#include <iCub/eventdriven/vImageCodecCV.h>
 #include <string>
+#include <deque>
+#include <vector>
 #include <opencv2/opencv.hpp>
 
 class vDraw;
@@ -102,6 +105,11 @@ public:
     ///
     virtual void draw(cv::Mat &canvas, const ev::vQueue &eSet, int vTime) = 0;
 
+    /// \brief true if the drawer only paints marks over the canvas, without
+    /// reading it or changing its size, such that it can be drawn on a
+    /// separate layer in parallel with the other drawers
+    virtual bool isOverlay() { return false; }
+
     ///
     /// \brief getTag returns the unique code for this drawing method. The
     /// arguments given on the command line must match this code exactly
@@ -114,17 +122,95 @@ public:
 
 };
 
-class addressDraw : public vDraw {
+/**
+ * @brief addressDrawBase draws the polarity of address events. It is
+ * templated on the event-type so that the timestamp arithmetic (with or
+ * without wrap correction) is resolved at compile time.
+ */
+template <typename V> class addressDrawBase : public vDraw {
 
 public:
 
-    static const std::string drawtype;
     virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
+    virtual std::string getEventType();
+
+};
+
+class addressDraw : public addressDrawBase<ev::AddressEvent> {
+
+public:
+
+    static const std::string drawtype;
     virtual std::string getDrawType();
+
+};
+
+class address64Draw : public addressDrawBase<ev::AddressEvent64> {
+
+public:
+
+    static const std::string drawtype;
+    virtual std::string getDrawType();
+
+};
+
+/**
+ * @brief accumulationDraw keeps the activity of each pixel (and polarity) in
+ * persistent planes. Only the events that arrived since the last frame are
+ * added, and the decay is applied to the whole plane at once, so the cost of
+ * a frame depends on the new events and the image size, not the window.
+ */
+class accumulationDraw : public vDraw {
+
+protected:
+
+    //the decay is exponential (time constant display_window) or a window
+    bool windowed;
+
+    //per-pixel activity of each polarity
+    cv::Mat planes[2];
+
+    //the last event accumulated
+    ev::event<> last_event;
+    unsigned int last_stamp;
+
+    //the events inside the window (windowed only)
+    struct entry {
+        unsigned int stamp;
+        float *pixel;
+    };
+    std::deque<entry> window_events;
+
+public:
+
+    accumulationDraw(bool windowed = false) : windowed(windowed), last_stamp(0) {}
+
+    void initialise();
+    virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
     virtual std::string getEventType();
 
 };
 
+class decayDraw : public accumulationDraw {
+
+public:
+
+    static const std::string drawtype;
+    virtual std::string getDrawType();
+
+};
+
+class windowDraw : public accumulationDraw {
+
+public:
+
+    windowDraw() : accumulationDraw(true) {}
+
+    static const std::string drawtype;
+    virtual std::string getDrawType();
+
+};
+
 class skinDraw : public vDraw {
 
 public:
@@ -144,6 +230,7 @@ public:
     virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
+    virtual bool isOverlay() { return true; }
 
 };
 
@@ -171,6 +258,7 @@ public:
     virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
+    virtual bool isOverlay() { return true; }
 
 };
 
@@ -187,6 +275,7 @@ public:
     virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
+    virtual bool isOverlay() { return true; }
 
 };
 
@@ -209,6 +298,7 @@ public:
     virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
     virtual std::string getDrawType();
     virtual std::string getEventType();
+    virtual bool isOverlay() { return true; }
 
 };
 
@@ -246,10 +336,25 @@ protected:
     //image with warped square drawn
     cv::Mat baseimage;
 
+    //the projection split into the pixel index of each (x, y) at t = 0 and
+    //the index offset of each time bin of (1 << bin_shift) ticks
+    std::vector<int> xy_index;
+    std::vector<int> t_offset;
+    int bin_shift;
+
+    //draw each (x, y, time bin) only once
+    bool occupancy;
+    std::vector<int> occupied;
+
 public:
 
+    isoDraw() : occupancy(false) {}
+
     void initialise();
 
+    /// \brief draw only the newest event of each pixel in each time bin
+    void setOccupancy(bool value = true) { occupancy = value; }
+
     static const std::string drawtype;
     virtual void draw(cv::Mat &image, const ev::vQueue &eSet, int vTime);
     virtual std::string getDrawType();
@@ -64,10 +64,22 @@ private:
     std::vector<yarp::os::BufferedPort<
         yarp::sig::ImageOf<yarp::sig::PixelBgr> > *> outports;
 
+    //! optional compressed copies of the images
+    std::vector<ev::vImageEncoder *> encoders;
+
+    //! timing stats
+    ev::vStats stats;
+    ev::vHistogram &delay;
+    ev::vHistogram &render;
+    ev::vCounter &frames;
+    ev::vCounter &blanks;
+    ev::vGauge &queue;
+
     void sendBlanks();
 
 public:
 
+    vFramerModule();
     virtual ~vFramerModule();
 
     // configure all the module parameters and return true if successful
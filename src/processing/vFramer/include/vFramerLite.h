@@ -41,7 +41,62 @@ using std::deque;
 using std::string;
 using std::map;
 
-class channelInstance : public RateThread {
+/// \brief drawers to render in order onto an image: the canvas of a channel,
+/// or the layer of an overlay
+struct renderTask
+{
+    vector<vDraw *> drawers;
+    vector<const vQueue *> qs;
+    cv::Mat *layer;
+
+    void render() const;
+};
+
+class renderPool;
+
+class renderWorker : public Thread {
+
+private:
+
+    renderPool *pool;
+
+public:
+
+    renderWorker(renderPool *pool) : pool(pool) {}
+    void run();
+
+};
+
+/// \brief a pool of threads shared by all channels. The thread calling
+/// render() also works on the tasks until they are all finished.
+class renderPool {
+
+private:
+
+    vector<renderWorker *> workers;
+    deque<renderTask> tasks;
+    Mutex m;
+    Semaphore available;
+    Semaphore finished;
+    bool stopping;
+
+    bool take(renderTask &task);
+
+    friend class renderWorker;
+
+public:
+
+    renderPool() : available(0), finished(0), stopping(false) {}
+
+    bool start(unsigned int n_threads);
+    void stop();
+
+    /// \brief render all tasks and wait until they are finished
+    void render(const vector<renderTask> &batch);
+
+};
+
+class channelInstance {
 
 private:
 
@@ -52,8 +107,14 @@ private:
     map<string, vQueue> event_qs;
     vector<vDraw *> drawers;
     BufferedPort< ImageOf<PixelBgr> > image_port;
+    vImageEncoder encoder;
+    string compress;
+    int quality;
 
-    bool updateQs();
+    //the drawers that read or resize the image are drawn in order on the
+    //canvas, the overlays that follow them each on a layer
+    cv::Mat canvas;
+    vector<cv::Mat> layers;
 
     //events are removed in batches corresponding to packets to reduce
     //the amount of timestamp comparisons required.
@@ -62,20 +123,62 @@ private:
     map<string, deque<unsigned int> > bookmark_n_events;
     map<string, int> prev_vstamp;
 
+    bool updateQs();
+
 public:
 
     channelInstance(string channel_name);
     bool addDrawer(string drawer_name, unsigned int width,
-                   unsigned int height, unsigned int window_size, bool flip);
+                   unsigned int height, unsigned int window_size, bool flip,
+                   bool iso_occupancy = false);
 
-    bool threadInit();
-    void run();
-    void threadRelease();
+    /// \brief also publish compressed images (sparse, jpg or png)
+    void setCompression(string format, int quality);
+
+    bool open();
+    void close();
+
+    /// \brief read the new events and add a task per drawer.
+    /// \returns false if there is nothing to draw
+    bool prepareFrame(vector<renderTask> &tasks);
+
+    /// \brief composite the layers and send the image. The frame is dropped
+    /// (returns false) if the previous image is still being sent.
+    bool publishFrame();
 
     string getName();
 
 };
 
+/// \brief renders all channels each period on a shared renderPool
+class frameScheduler : public RateThread {
+
+private:
+
+    string name;
+    vector<channelInstance *> &channels;
+    renderPool pool;
+    unsigned int n_threads;
+    vector<renderTask> tasks;
+    vector<bool> ready;
+
+    //timing stats
+    ev::vStats stats;
+    ev::vHistogram &render;
+    ev::vCounter &frames;
+    ev::vCounter &dropped;
+    ev::vCounter &late;
+
+public:
+
+    frameScheduler(string name, vector<channelInstance *> &channels,
+                   double period, unsigned int n_threads);
+
+    bool threadInit();
+    void run();
+    void threadRelease();
+
+};
 
 /**
  * @brief The vFramerModule class runs the event reading and channel splitting,
@@ -87,9 +190,11 @@ class vFramerModule : public yarp::os::RFModule {
 private:
 
     vector<channelInstance *> publishers;
+    frameScheduler *scheduler;
 
 public:
 
+    vFramerModule() : scheduler(0) {}
     virtual ~vFramerModule();
 
     // configure all the module parameters and return true if successful
@@ -24,30 +24,41 @@
 using namespace ev;
 
 const std::string addressDraw::drawtype = "AE";
+const std::string address64Draw::drawtype = "AE64";
 
 std::string addressDraw::getDrawType()
 {
     return addressDraw::drawtype;
 }
 
-std::string addressDraw::getEventType()
+std::string address64Draw::getDrawType()
 {
-    return AddressEvent::tag;
+    return address64Draw::drawtype;
 }
 
-void addressDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
+template <typename V>
+std::string addressDrawBase<V>::getEventType()
 {
+    return V::tag;
+}
+
+template <typename V>
+void addressDrawBase<V>::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
+{
+    typedef stampTraits<V> st;
+
     if(eSet.empty()) return;
-    if(vTime < 0) vTime = eSet.back()->stamp;
+    //vTime is a wrapped stamp, converted to the stamp-type of the event
+    typename st::type ctime = st::get(*read_as<V>(eSet.back()));
+    if(vTime >= 0) ctime = st::fromWrapped(ctime, vTime);
+    typename st::delta_type window = display_window;
+
     ev::vQueue::const_reverse_iterator qi;
     for(qi = eSet.rbegin(); qi != eSet.rend(); qi++) {
 
-        int dt = vTime - (*qi)->stamp;
-        if(dt < 0) dt += ev::vtsHelper::max_stamp;
-        if((unsigned int)dt > display_window) break;
-
+        V *aep = read_as<V>(*qi);
+        if(st::delta(ctime, st::get(*aep)) > window) break;
 
-        auto aep = is_event<AddressEvent>(*qi);
         int y = aep->y;
         int x = aep->x;
         if(flip) {
@@ -84,3 +95,6 @@ void addressDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
         }
     }
 }
+
+template class addressDrawBase<AddressEvent>;
+template class addressDrawBase<AddressEvent64>;
@@ -0,0 +1,140 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vDraw.h"
+#include <cmath>
+
+using namespace ev;
+
+const std::string decayDraw::drawtype = "AE-DECAY";
+const std::string windowDraw::drawtype = "AE-WIN";
+
+std::string decayDraw::getDrawType()
+{
+    return decayDraw::drawtype;
+}
+
+std::string windowDraw::getDrawType()
+{
+    return windowDraw::drawtype;
+}
+
+std::string accumulationDraw::getEventType()
+{
+    return AE::tag;
+}
+
+void accumulationDraw::initialise()
+{
+    planes[0] = cv::Mat::zeros(Ylimit, Xlimit, CV_32F);
+    planes[1] = cv::Mat::zeros(Ylimit, Xlimit, CV_32F);
+    window_events.clear();
+    last_event.reset();
+}
+
+void accumulationDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
+{
+    typedef stampTraits<AE> st;
+
+    if(planes[0].empty()) initialise();
+
+    //the retained window is empty once the stream stops, and nothing of
+    //the window (or the decay) is left to show
+    if(eSet.empty() && last_event) {
+        planes[0].setTo(0);
+        planes[1].setTo(0);
+        window_events.clear();
+        last_event.reset();
+    }
+
+    if(!eSet.empty()) {
+
+        unsigned int ctime = eSet.back()->stamp;
+        if(vTime >= 0) ctime = vTime;
+        double tau = display_window;
+
+        //the events are only added once. Older events of the decay (or the
+        //window) have no effect on the image.
+        int horizon = windowed ? display_window : 5 * display_window;
+        unsigned int n_new = 0;
+        ev::vQueue::const_reverse_iterator qi;
+        for(qi = eSet.rbegin(); qi != eSet.rend(); qi++, n_new++) {
+            if(*qi == last_event) break;
+            unsigned int stamp = (*qi)->stamp;
+            if(st::delta(ctime, stamp) > horizon) break;
+            if(last_event && stamp != last_stamp &&
+                    st::delta(last_stamp, stamp) < (int)(vtsHelper::max_stamp / 2))
+                break;
+        }
+
+        //decay what was there, then add the new events
+        if(!windowed && last_event) {
+            int dt = st::delta(ctime, last_stamp);
+            if(dt > horizon) {
+                planes[0].setTo(0);
+                planes[1].setTo(0);
+            } else {
+                float decay = std::exp(-dt / tau);
+                planes[0] *= decay;
+                planes[1] *= decay;
+            }
+        }
+
+        for(unsigned int i = eSet.size() - n_new; i < eSet.size(); i++) {
+            AE *v = read_as<AE>(eSet[i]);
+            int y = v->y;
+            int x = v->x;
+            if(flip) {
+                y = Ylimit - 1 - y;
+                x = Xlimit - 1 - x;
+            }
+            float &pixel = planes[v->polarity].at<float>(y, x);
+            if(windowed) {
+                pixel += 1.0f;
+                entry e = {v->stamp, &pixel};
+                window_events.push_back(e);
+            } else {
+                pixel += std::exp(-st::delta(ctime, v->stamp) / tau);
+            }
+        }
+
+        //remove the events that left the window
+        while(window_events.size() &&
+              st::delta(ctime, window_events.front().stamp) > horizon) {
+            *(window_events.front().pixel) -= 1.0f;
+            window_events.pop_front();
+        }
+
+        last_event = eSet.back();
+        last_stamp = eSet.back()->stamp;
+    }
+
+    //colour the planes in a single pass
+    static const cv::Scalar colours[2] = {cv::Scalar(160, 0, 255),
+                                          cv::Scalar(0, 60, 0)};
+    cv::Mat fimage;
+    image.convertTo(fimage, CV_32FC3);
+    for(int p = 0; p < 2; p++) {
+        cv::Mat w, w3;
+        cv::min(planes[p], 1.0, w);
+        cv::Mat wc[3] = {w, w, w};
+        cv::merge(wc, 3, w3);
+        fimage += w3.mul(cv::Mat(fimage.size(), CV_32FC3, colours[p]) - fimage);
+    }
+    fimage.convertTo(image, CV_8UC3);
+}
@@ -159,6 +159,30 @@ void isoDraw::initialise()
 
     }
 
+    //the projection is linear, so it is split into a table over (x, y) and a
+    //table over time bins no longer than a pixel of the t axis
+    xy_index.resize(Xlimit * Ylimit);
+    for(int yi = 0; yi < Ylimit; yi++) {
+        for(int xi = 0; xi < Xlimit; xi++) {
+            x = xi; y = yi; z = 0; pttr(x, y, z);
+            xy_index[yi * Xlimit + xi] = (y + imageyshift) * imagewidth +
+                    x + imagexshift;
+        }
+    }
+
+    bin_shift = 0;
+    while((2 << bin_shift) * ts_to_axis <= 1.0) bin_shift++;
+    t_offset.resize((max_window >> bin_shift) + 1);
+    for(unsigned int bi = 0; bi < t_offset.size(); bi++) {
+        int zc = ((double)bi * (1 << bin_shift)) * ts_to_axis + 0.5;
+        double tx = zc * SY;
+        double ty = -SX * CY * zc;
+        t_offset[bi] = (int)std::floor(ty + 0.5) * imagewidth +
+                (int)std::floor(tx + 0.5);
+    }
+
+    occupied.resize(Xlimit * Ylimit);
+
     yInfo() << "Finished setting up ISO draw";
 
 
@@ -176,6 +200,11 @@ void isoDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
 
     int skip = 1 + eSet.size() / 100000;
 
+    cv::Vec3b *iso = isoimage.ptr<cv::Vec3b>();
+    const cv::Vec3b colours[2] = {cv::Vec3b(255, 160, 255),
+                                  cv::Vec3b(160, 255, 160)};
+    if(occupancy) std::fill(occupied.begin(), occupied.end(), -1);
+
     for(int i = eSet.size() - 1; i >= 0; i -= skip) {
 
         AE *aep = read_as<AE>(eSet[i]);
@@ -184,44 +213,34 @@ void isoDraw::draw(cv::Mat &image, const ev::vQueue &eSet, int vTime)
         int dt = vTime - aep->stamp;
         if(dt < 0) dt += ev::vtsHelper::max_stamp;
         if((unsigned int)dt > max_window) continue;
-        dt = dt * ts_to_axis + 0.5;
+        int bin = dt >> bin_shift;
         int px = aep->x;
         int py = aep->y;
         if(flip) {
             px = Xlimit - 1 - px;
             py = Ylimit - 1 - py;
         }
-        int pz = dt;
-        pttr(px, py, pz);
-        px += imagexshift;
-        py += imageyshift;
-
-        if(px < 0 || px >= imagewidth || py < 0 || py >= imageheight) {
+        if((unsigned int)px >= (unsigned int)Xlimit ||
+                (unsigned int)py >= (unsigned int)Ylimit)
             continue;
-        }
+        int pixel = py * Xlimit + px;
 
-        if(!aep->polarity) {
-            isoimage.at<cv::Vec3b>(py, px) = cv::Vec3b(255, 160, 255);
-        } else {
-            isoimage.at<cv::Vec3b>(py, px) = cv::Vec3b(160, 255, 160);
+        //the newest event in the bin is kept
+        if(occupancy) {
+            if(occupied[pixel] == bin) continue;
+            occupied[pixel] = bin;
         }
+
+        iso[xy_index[pixel] + t_offset[bin]] = colours[aep->polarity ? 1 : 0];
     }
 
     if(!image.empty()) {
-        for(int y = 0; y < image.rows; y++) {
-            for(int x = 0; x < image.cols; x++) {
+        for(int y = 0; y < image.rows && y < Ylimit; y++) {
+            for(int x = 0; x < image.cols && x < Xlimit; x++) {
                 cv::Vec3b &pixel = image.at<cv::Vec3b>(y, x);
 
-                if(pixel[0] != 255 || pixel[1] != 255 || pixel[2] != 255) {
-
-                    int px = x, py = y, pz = 0; pttr(px, py, pz);
-                    px += imagexshift;
-                    py += imageyshift;
-                    if(px < 0 || px >= imagewidth || py < 0 || py >= imageheight)
-                        continue;
-
-                    isoimage.at<cv::Vec3b>(py, px) = pixel;
-                }
+                if(pixel[0] != 255 || pixel[1] != 255 || pixel[2] != 255)
+                    iso[xy_index[y * Xlimit + x]] = pixel;
             }
         }
     }
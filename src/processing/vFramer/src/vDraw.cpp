@@ -30,6 +30,12 @@ vDraw * createDrawer(std::string tag)
 
     if(tag == addressDraw::drawtype)
         return new addressDraw();
+    if(tag == address64Draw::drawtype)
+        return new address64Draw();
+    if(tag == decayDraw::drawtype)
+        return new decayDraw();
+    if(tag == windowDraw::drawtype)
+        return new windowDraw();
     if(tag == isoDraw::drawtype)
         return new isoDraw();
     if(tag == interestDraw::drawtype)
@@ -42,7 +42,12 @@ int main(int argc, char * argv[])
 /*////////////////////////////////////////////////////////////////////////////*/
 //vFramerModule
 /*////////////////////////////////////////////////////////////////////////////*/
-
+vFramerModule::vFramerModule() :
+    delay(stats.histogram("delay")), render(stats.histogram("render")),
+    frames(stats.counter("frames")), blanks(stats.counter("blanks")),
+    queue(stats.gauge("queue"))
+{
+}
 
 bool vFramerModule::configure(yarp::os::ResourceFinder &rf)
 {
@@ -71,6 +76,12 @@ bool vFramerModule::configure(yarp::os::ResourceFinder &rf)
 
     bool flip = rf.check("flip") &&
             rf.check("flip", yarp::os::Value(true)).asBool();
+    bool isoOccupancy = rf.check("isoOccupancy") &&
+            rf.check("isoOccupancy", yarp::os::Value(true)).asBool();
+
+    //also publish compressed images (sparse, jpg or png)
+    std::string compress = rf.check("compress", yarp::os::Value("")).asString();
+    int quality = rf.check("quality", yarp::os::Value(90)).asInt();
 
     bool forceRender = rf.check("forcerender") &&
             rf.check("forcerender", yarp::os::Value(true)).asBool();
@@ -122,6 +133,13 @@ bool vFramerModule::configure(yarp::os::ResourceFinder &rf)
         if(!outports[i]->open(moduleName + outportname))
             return false;
 
+        if(compress.size()) {
+            encoders.push_back(new ev::vImageEncoder);
+            if(!encoders.back()->open(moduleName + outportname + "/compressed:o",
+                                      compress, quality, cvEncodeImage))
+                return false;
+        }
+
         //create the draw types
         yarp::os::Bottle * drawtypelist = displayList->get(i*3 + 2).asList();
         for(unsigned j = 0; j < drawtypelist->size(); j++) {
@@ -130,6 +148,8 @@ bool vFramerModule::configure(yarp::os::ResourceFinder &rf)
                 newDrawer->setRetinaLimits(retinaWidth, retinaHeight);
                 newDrawer->setTemporalLimits(eventWindow, 2.0*vtsHelper::vtsscaler);
                 newDrawer->setFlip(flip);
+                isoDraw *isoDrawer = dynamic_cast<isoDraw *>(newDrawer);
+                if(isoDrawer) isoDrawer->setOccupancy(isoOccupancy);
                 newDrawer->initialise();
                 drawers[i].push_back(newDrawer);
                 if(!vReader.open(moduleName, newDrawer->getEventType()))
@@ -145,6 +165,11 @@ bool vFramerModule::configure(yarp::os::ResourceFinder &rf)
         q_snaps[i].resize(drawtypelist->size());
     }
 
+    if(!stats.open(moduleName + "/stats:o")) {
+        yError() << "Could not open stats port";
+        return false;
+    }
+
     return true;
 
 }
@@ -157,9 +182,15 @@ bool vFramerModule::interruptModule()
 
 bool vFramerModule::close()
 {
+    stats.close();
     vReader.close();
     for(unsigned int i = 0; i < outports.size(); i++)
         outports[i]->close();
+    for(unsigned int i = 0; i < encoders.size(); i++) {
+        encoders[i]->close();
+        delete encoders[i];
+    }
+    encoders.clear();
     return true;
 }
 
@@ -179,6 +210,7 @@ void vFramerModule::sendBlanks() {
         yarp::os::Stamp cEnv = vReader.getystamp();
         if(cEnv.isValid()) outports[i]->setEnvelope(cEnv);
         outports[i]->write();
+        blanks.add();
     }
 
 }
@@ -212,6 +244,7 @@ bool vFramerModule::updateModule()
     //check if we have unprocessed events
     static int puqs = 0;
     int uqs = vReader.queryMaxUnproced();
+    queue.set(uqs);
     if(uqs || puqs) {
         //yInfo() << uqs << "unprocessed queues";
         if(uqs)
@@ -227,6 +260,7 @@ bool vFramerModule::updateModule()
     vReader.updateStamps();
     int current_vts = vReader.getvstamp();
     yarp::os::Stamp cEnv = vReader.getystamp();
+    if(cEnv.isValid()) delay.record(yarp::os::Time::now() - cEnv.getTime());
 
 
     //trim eSet based on the synchronisation time
@@ -242,10 +276,9 @@ bool vFramerModule::updateModule()
 //    }
 
     //for each output image needed
-    double acct2 = 0;
     for(unsigned int i = 0; i < channels.size(); i++) {
 
-        double dt2 = Time::now();
+        ev::vScopedTimer timer(render);
         //get the image to be written and make a cv::Mat pointing to the same
         yarp::sig::ImageOf<yarp::sig::PixelBgr> &o = outports[i]->prepare();
         cv::Mat canvas = cv::cvarrToMat((IplImage *)o.getIplImage());
@@ -268,8 +301,6 @@ bool vFramerModule::updateModule()
                                     -1);
             }
         }
-        acct2 += Time::now() - dt2;
-
 
         //tell the actual YARP image what size the final image became
         o.resize(canvas.cols, canvas.rows);
@@ -277,9 +308,13 @@ bool vFramerModule::updateModule()
         //write
         if(cEnv.isValid()) outports[i]->setEnvelope(cEnv);
         outports[i]->write();
-    }
+        frames.add();
 
-    //std::cout << "Drawing: " << 1.0 / acct2 << std::endl;
+        //compressed on the encoder thread
+        if(encoders.size() && encoders[i]->isConnected())
+            encoders[i]->send(canvas.data, canvas.cols, canvas.rows,
+                              canvas.step, cEnv);
+    }
 
     return true;
 }
@@ -18,6 +18,7 @@
 
 #include "vFramerLite.h"
 #include <sstream>
+#include <thread>
 
 using namespace ev;
 
@@ -42,10 +43,17 @@ int main(int argc, char * argv[])
 /*////////////////////////////////////////////////////////////////////////////*/
 //channelInstance
 /*////////////////////////////////////////////////////////////////////////////*/
-channelInstance::channelInstance(string channel_name) : RateThread(0.1)
+channelInstance::channelInstance(string channel_name)
 {
     this->channel_name = channel_name;
     this->limit_time = 1.0 * vtsHelper::vtsscaler;
+    this->quality = 90;
+}
+
+void channelInstance::setCompression(string format, int quality)
+{
+    this->compress = format;
+    this->quality = quality;
 }
 
 string channelInstance::getName()
@@ -55,7 +63,7 @@ string channelInstance::getName()
 
 bool channelInstance::addDrawer(string drawer_name, unsigned int width,
                                 unsigned int height, unsigned int window_size,
-                                bool flip)
+                                bool flip, bool iso_occupancy)
 {
     //make the drawer
     vDraw * new_drawer = createDrawer(drawer_name);
@@ -63,6 +71,8 @@ bool channelInstance::addDrawer(string drawer_name, unsigned int width,
         new_drawer->setRetinaLimits(width, height);
         new_drawer->setTemporalLimits(window_size, limit_time);
         new_drawer->setFlip(flip);
+        isoDraw *iso_drawer = dynamic_cast<isoDraw *>(new_drawer);
+        if(iso_drawer) iso_drawer->setOccupancy(iso_occupancy);
         new_drawer->initialise();
         drawers.push_back(new_drawer);
     } else {
@@ -82,8 +92,11 @@ bool channelInstance::addDrawer(string drawer_name, unsigned int width,
 
 }
 
-bool channelInstance::threadInit()
+bool channelInstance::open()
 {
+    if(compress.size() && !encoder.open(channel_name + "/compressed:o",
+                                        compress, quality, cvEncodeImage))
+        return false;
     return image_port.open(channel_name + "/image:o");
 }
 
@@ -128,38 +141,75 @@ bool channelInstance::updateQs()
 }
 
 
-void channelInstance::run()
+bool channelInstance::prepareFrame(vector<renderTask> &tasks)
 {
-
     if(!updateQs())
-        return;
-
+        return false;
 
-    //get the image to be written and make a cv::Mat pointing to the same
-    ImageOf<PixelBgr> &o = image_port.prepare();
-    cv::Mat canvas = cv::cvarrToMat((IplImage *)o.getIplImage());
+    //the overlays after the last drawer that uses the canvas can be drawn in
+    //parallel, on layers of the size the canvas had in the previous frame
+    unsigned int n_canvas = drawers.size();
+    while(n_canvas > 1 && drawers[n_canvas - 1]->isOverlay())
+        n_canvas--;
 
-    //the first drawer will reset the base image, then drawing proceeds
     drawers.front()->resetImage(canvas);
-
-    vector<vDraw *>::iterator drawer_i;
-    for(drawer_i = drawers.begin(); drawer_i != drawers.end(); drawer_i++) {
-        (*drawer_i)->draw(canvas, event_qs[(*drawer_i)->getEventType()], -1);
+    renderTask task;
+    task.layer = &canvas;
+    for(unsigned int i = 0; i < n_canvas; i++) {
+        task.drawers.push_back(drawers[i]);
+        task.qs.push_back(&event_qs[drawers[i]->getEventType()]);
+    }
+    tasks.push_back(task);
+
+    layers.resize(drawers.size() - n_canvas);
+    for(unsigned int i = 0; i < layers.size(); i++) {
+        vDraw *overlay = drawers[n_canvas + i];
+        layers[i].create(canvas.size(), canvas.type());
+        layers[i].setTo(255);
+        renderTask overlay_task;
+        overlay_task.drawers.push_back(overlay);
+        overlay_task.qs.push_back(&event_qs[overlay->getEventType()]);
+        overlay_task.layer = &layers[i];
+        tasks.push_back(overlay_task);
     }
 
+    return true;
+}
 
-    //tell the actual YARP image what size the final image became
-    o.resize(canvas.cols, canvas.rows);
+bool channelInstance::publishFrame()
+{
+    //a newer frame is more useful than queueing this one
+    if(image_port.isWriting())
+        return false;
+
+    //anything drawn on a layer is placed over the image. If the canvas
+    //changed size this frame, the layer covers the top-left of the canvas
+    //(where the overlay would have drawn on the canvas itself)
+    for(unsigned int i = 0; i < layers.size(); i++) {
+        cv::Rect common(0, 0, std::min(layers[i].cols, canvas.cols),
+                        std::min(layers[i].rows, canvas.rows));
+        cv::Mat layer = layers[i](common), mask;
+        cv::inRange(layer, cv::Scalar(255, 255, 255),
+                    cv::Scalar(255, 255, 255), mask);
+        cv::Mat target = canvas(common);
+        layer.copyTo(target, ~mask);
+    }
 
-    //write
-    //if(cEnv.isValid()) outports[i]->setEnvelope(cEnv);
+    ImageOf<PixelBgr> &o = image_port.prepare();
+    o.resize(canvas.cols, canvas.rows);
+    cv::Mat image = cv::cvarrToMat((IplImage *)o.getIplImage());
+    canvas.copyTo(image);
     image_port.write();
 
-    //updateQs();
+    //compressed on the encoder thread
+    if(compress.size() && encoder.isConnected())
+        encoder.send(canvas.data, canvas.cols, canvas.rows, canvas.step,
+                     Stamp());
 
+    return true;
 }
 
-void channelInstance::threadRelease()
+void channelInstance::close()
 {
     //close input ports
     std::map<string, vGenReadPort>::iterator port_i;
@@ -167,17 +217,155 @@ void channelInstance::threadRelease()
         port_i->second.close();
     }
 
-    //close output port
+    //close output ports
     image_port.close();
+    if(compress.size())
+        encoder.close();
 
     //delete allocated memory
     std::vector<vDraw *>::iterator drawer_i;
     for(drawer_i = drawers.begin(); drawer_i != drawers.end(); drawer_i++) {
         delete *drawer_i;
     }
+    drawers.clear();
+
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+//renderPool
+/*////////////////////////////////////////////////////////////////////////////*/
+void renderTask::render() const
+{
+    for(unsigned int i = 0; i < drawers.size(); i++)
+        drawers[i]->draw(*layer, *qs[i], -1);
+}
+
+void renderWorker::run()
+{
+    renderTask task;
+    while(true) {
+        pool->available.wait();
+        if(pool->stopping) return;
+        if(!pool->take(task)) continue;
+        task.render();
+        pool->finished.post();
+    }
+}
 
+bool renderPool::start(unsigned int n_threads)
+{
+    stopping = false;
+    for(unsigned int i = 0; i < n_threads; i++) {
+        workers.push_back(new renderWorker(this));
+        if(!workers.back()->start())
+            return false;
+    }
+    return true;
 }
 
+void renderPool::stop()
+{
+    stopping = true;
+    for(unsigned int i = 0; i < workers.size(); i++)
+        available.post();
+    for(unsigned int i = 0; i < workers.size(); i++) {
+        workers[i]->stop();
+        delete workers[i];
+    }
+    workers.clear();
+}
+
+bool renderPool::take(renderTask &task)
+{
+    m.lock();
+    bool taken = !tasks.empty();
+    if(taken) {
+        task = tasks.front();
+        tasks.pop_front();
+    }
+    m.unlock();
+    return taken;
+}
+
+void renderPool::render(const vector<renderTask> &batch)
+{
+    m.lock();
+    tasks.insert(tasks.end(), batch.begin(), batch.end());
+    m.unlock();
+    for(unsigned int i = 0; i < batch.size(); i++)
+        available.post();
+
+    renderTask task;
+    while(take(task)) {
+        task.render();
+        finished.post();
+    }
+
+    for(unsigned int i = 0; i < batch.size(); i++)
+        finished.wait();
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+//frameScheduler
+/*////////////////////////////////////////////////////////////////////////////*/
+frameScheduler::frameScheduler(string name, vector<channelInstance *> &channels,
+                               double period, unsigned int n_threads) :
+    RateThread(period), name(name), channels(channels), n_threads(n_threads),
+    render(stats.histogram("render")), frames(stats.counter("frames")),
+    dropped(stats.counter("dropped")), late(stats.counter("late"))
+{
+}
+
+bool frameScheduler::threadInit()
+{
+    for(unsigned int i = 0; i < channels.size(); i++) {
+        if(!channels[i]->open()) {
+            yError() << "Could not open" << channels[i]->getName();
+            return false;
+        }
+    }
+    if(!stats.open(name + "/stats:o"))
+        yWarning() << "Could not open stats port";
+    yInfo() << "Rendering" << channels.size() << "channels with"
+            << n_threads + 1 << "threads";
+    return pool.start(n_threads);
+}
+
+void frameScheduler::run()
+{
+    double deadline = Time::now() + getRate() * 0.001;
+
+    //all drawers of all channels are rendered together
+    tasks.clear();
+    ready.resize(channels.size());
+    for(unsigned int i = 0; i < channels.size(); i++)
+        ready[i] = channels[i]->prepareFrame(tasks);
+    if(tasks.empty()) return;
+
+    {
+        vScopedTimer timer(render);
+        pool.render(tasks);
+    }
+
+    for(unsigned int i = 0; i < channels.size(); i++) {
+        if(!ready[i]) continue;
+        if(channels[i]->publishFrame())
+            frames.add();
+        else
+            dropped.add();
+    }
+
+    if(Time::now() > deadline)
+        late.add();
+}
+
+void frameScheduler::threadRelease()
+{
+    pool.stop();
+    stats.close();
+    for(unsigned int i = 0; i < channels.size(); i++)
+        channels[i]->close();
+}
 
 /*////////////////////////////////////////////////////////////////////////////*/
 //channelInstance
@@ -202,10 +390,21 @@ bool vFramerModule::configure(yarp::os::ResourceFinder &rf)
     int frameRate = rf.check("frameRate", Value(30)).asInt();
     double period = 1000.0 / frameRate;
 
+    //also publish compressed images (sparse, jpg or png)
+    string compress = rf.check("compress", Value("")).asString();
+    int quality = rf.check("quality", Value(90)).asInt();
+
+    //the thread running the scheduler also renders
+    int threads = rf.check("threads",
+                           Value((int)std::thread::hardware_concurrency())).asInt();
+    threads = std::max(threads - 1, 0);
+
     //bool useTimeout =
     //        rf.check("timeout") && rf.check("timeout", Value(true)).asBool();
     bool flip =
             rf.check("flip") && rf.check("flip", Value(true)).asBool();
+    bool isoOccupancy = rf.check("isoOccupancy") &&
+            rf.check("isoOccupancy", Value(true)).asBool();
     //bool forceRender =
     //        rf.check("forcerender") &&
     //        rf.check("forcerender", Value(true)).asBool();
@@ -244,13 +443,14 @@ bool vFramerModule::configure(yarp::os::ResourceFinder &rf)
                 moduleName + displayList->get(i*2).asString();
 
         channelInstance * new_ci = new channelInstance(channel_name);
-        new_ci->setRate(period);
+        new_ci->setCompression(compress, quality);
 
         Bottle * drawtypelist = displayList->get(i*2 + 1).asList();
         for(unsigned int j = 0; j < drawtypelist->size(); j++)
         {
             string draw_type = drawtypelist->get(j).asString();
-            if(!new_ci->addDrawer(draw_type, width, height, eventWindow, flip))
+            if(!new_ci->addDrawer(draw_type, width, height, eventWindow, flip,
+                                  isoOccupancy))
             {
                 yError() << "Could not create specified publisher"
                          << channel_name << draw_type;
@@ -262,12 +462,10 @@ bool vFramerModule::configure(yarp::os::ResourceFinder &rf)
 
     }
 
-    vector<channelInstance *>::iterator pub_i;
-    for(pub_i = publishers.begin(); pub_i != publishers.end(); pub_i++) {
-        if(!(*pub_i)->start()) {
-            yError() << "Could not start publisher" << (*pub_i)->getName();
-            return false;
-        }
+    scheduler = new frameScheduler(moduleName, publishers, period, threads);
+    if(!scheduler->start()) {
+        yError() << "Could not start the frame scheduler";
+        return false;
     }
 
     return true;
@@ -275,18 +473,24 @@ bool vFramerModule::configure(yarp::os::ResourceFinder &rf)
 
 bool vFramerModule::interruptModule()
 {
-    vector<channelInstance *>::iterator pub_i;
-    for(pub_i = publishers.begin(); pub_i != publishers.end(); pub_i++)
-        (*pub_i)->stop();
+    if(scheduler)
+        scheduler->stop();
 
     return true;
 }
 
 bool vFramerModule::close()
 {
+    if(scheduler) {
+        scheduler->stop();
+        delete scheduler;
+        scheduler = 0;
+    }
+
     vector<channelInstance *>::iterator pub_i;
     for(pub_i = publishers.begin(); pub_i != publishers.end(); pub_i++)
-        (*pub_i)->stop();
+        delete *pub_i;
+    publishers.clear();
 
     return true;
 }
@@ -0,0 +1,86 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// \defgroup Modules Modules
+// \defgroup vGenerator vGenerator
+// \ingroup Modules
+// \brief generates synthetic event streams for load testing
+
+#ifndef __VGENERATORMODULE__
+#define __VGENERATORMODULE__
+
+#include <yarp/os/all.h>
+#include <iCub/eventdriven/all.h>
+#include <string>
+#include <vector>
+
+using namespace ev;
+
+class vGenerator : public yarp::os::Thread
+{
+private:
+
+    vEventGenerator generator;
+    vGenWritePort outPort;
+    vLogWriter writer;
+    std::vector<std::int32_t> buffer;
+
+    //parameters
+    bool todisk;
+    double speed;
+    std::uint64_t packet_time;
+    unsigned int max_packet;
+    std::uint64_t duration;
+
+    //state
+    unsigned long int events_sent;
+    int packet_count;
+
+    void pace(std::uint64_t time, double wall0);
+
+public:
+
+    vGenerator();
+
+    vEventGenerator & getGenerator() { return generator; }
+    bool initialise(std::string name, std::string file, double speed,
+                    double packet_time, double duration);
+    unsigned long int getEventsSent() { return events_sent; }
+    void run();
+    void threadRelease();
+
+};
+
+class vGeneratorModule : public yarp::os::RFModule
+{
+    vGenerator generator;
+    unsigned long int prev_events;
+
+public:
+
+    //the virtual functions that need to be overloaded
+    virtual bool configure(yarp::os::ResourceFinder &rf);
+    virtual bool interruptModule();
+    virtual bool close();
+
+    virtual double getPeriod();
+    virtual bool updateModule();
+
+};
+
+#endif
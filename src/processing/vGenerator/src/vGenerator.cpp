@@ -0,0 +1,227 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vGenerator.h"
+#include <algorithm>
+
+int main(int argc, char * argv[])
+{
+    /* initialize yarp network */
+    yarp::os::Network yarp;
+    if(!yarp.checkNetwork()) {
+        yError() << "Could not find YARP";
+        return false;
+    }
+
+    /* prepare and configure the resource finder */
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose();
+    rf.setDefaultContext( "eventdriven" );
+    rf.setDefaultConfigFile( "vGenerator.ini" );
+    rf.configure( argc, argv );
+
+    /* create the module */
+    vGeneratorModule generatorModule;
+    /* run the module: runModule() calls configure first and, if successful, it then runs */
+    return generatorModule.runModule(rf);
+}
+
+/******************************************************************************/
+//vGenerator
+/******************************************************************************/
+vGenerator::vGenerator()
+{
+    todisk = false;
+    speed = 1.0;
+    packet_time = 0;
+    max_packet = 0;
+    duration = 0;
+    events_sent = 0;
+    packet_count = 0;
+}
+
+bool vGenerator::initialise(std::string name, std::string file, double speed,
+                            double packet_time, double duration)
+{
+    this->speed = speed;
+    this->packet_time = packet_time * 0.000001 * vtsHelper::vtsscaler;
+    this->duration = duration * vtsHelper::vtsscaler;
+
+    //packets are capped so the buffer is allocated once
+    max_packet = 1000000;
+    buffer.resize(max_packet * packetSize(AddressEvent::tag));
+
+    todisk = !file.empty();
+    if(todisk)
+        return writer.open(file);
+
+    outPort.setWriteType(AddressEvent::tag);
+    return outPort.open(name + "/" + AddressEvent::tag + ":o");
+}
+
+void vGenerator::pace(std::uint64_t time, double wall0)
+{
+    //speed 0 generates as fast as the output allows
+    if(speed <= 0) return;
+
+    double target = wall0 + time * vtsHelper::tsscaler / speed;
+    double dt = target - yarp::os::Time::now();
+    if(dt > 0)
+        yarp::os::Time::delay(dt);
+}
+
+void vGenerator::run()
+{
+    std::uint64_t t0 = generator.currentTime();
+    double wall0 = yarp::os::Time::now();
+
+    while(!isStopping()) {
+
+        //each packet holds packet_time of events at the current rate
+        double n = generator.currentRate() * packet_time * vtsHelper::tsscaler;
+        unsigned int n_events = std::max(1.0, std::min(n, (double)max_packet));
+        unsigned int n_ints = generator.generate(buffer.data(), n_events);
+        std::uint64_t t = generator.currentTime() - t0;
+
+        if(todisk) {
+            writer.write(AddressEvent::tag, buffer.data(), n_ints,
+                         yarp::os::Stamp(++packet_count,
+                                         t * vtsHelper::tsscaler));
+        } else {
+            pace(t, wall0);
+            outPort.write(buffer.data(), n_ints,
+                          yarp::os::Stamp(++packet_count,
+                                          yarp::os::Time::now()));
+        }
+        events_sent += n_events;
+
+        if(duration && t >= duration) {
+            yInfo() << "Generated" << t * vtsHelper::tsscaler
+                    << "seconds of events";
+            break;
+        }
+    }
+}
+
+void vGenerator::threadRelease()
+{
+    if(todisk)
+        writer.close();
+    else
+        outPort.close();
+}
+
+/******************************************************************************/
+//vGeneratorModule
+/******************************************************************************/
+bool vGeneratorModule::configure(yarp::os::ResourceFinder &rf)
+{
+    vEventGenerator &g = generator.getGenerator();
+
+    g.setResolution(rf.check("width", yarp::os::Value(304)).asInt(),
+                    rf.check("height", yarp::os::Value(240)).asInt());
+    g.setRate(rf.check("rate", yarp::os::Value(1000000.0)).asDouble());
+    g.setSeed(rf.check("seed", yarp::os::Value(1)).asInt());
+
+    vAddressCodec codec;
+    std::string codecname = rf.check("codec", yarp::os::Value("304x240_24")).asString();
+    if(!vEventGenerator::parseCodec(codecname, codec)) {
+        yError() << "Unknown codec" << codecname;
+        return false;
+    }
+    g.setCodec(codec);
+
+    vEventGenerator::channelMode channels;
+    std::string channelname = rf.check("channels", yarp::os::Value("left")).asString();
+    if(!vEventGenerator::parseChannels(channelname, channels)) {
+        yError() << "Unknown channel mode" << channelname;
+        return false;
+    }
+    g.setChannels(channels);
+
+    //bursts (period length gain)
+    yarp::os::Bottle *bursts = rf.find("bursts").asList();
+    if(bursts && bursts->size() == 3)
+        g.setBursts(bursts->get(0).asDouble(), bursts->get(1).asDouble(),
+                    bursts->get(2).asDouble());
+
+    //patterns ((type weight speed size angle) ...)
+    yarp::os::Bottle *patterns = rf.find("patterns").asList();
+    for(int i = 0; patterns && i < patterns->size(); i++) {
+        yarp::os::Bottle *p = patterns->get(i).asList();
+        vEventGenerator::patternType type;
+        if(!p || !vEventGenerator::parsePattern(p->get(0).asString(), type)) {
+            yError() << "Unknown pattern" << patterns->get(i).toString();
+            return false;
+        }
+        g.addPattern(type, p->size() > 1 ? p->get(1).asDouble() : 1.0,
+                     p->size() > 2 ? p->get(2).asDouble() : 100.0,
+                     p->size() > 3 ? p->get(3).asDouble() : 20.0,
+                     p->size() > 4 ? p->get(4).asDouble() : 0.0);
+    }
+
+    double speed = rf.check("speed", yarp::os::Value(1.0)).asDouble();
+    double packet_time = rf.check("packet_time", yarp::os::Value(1000)).asDouble();
+    double duration = rf.check("duration", yarp::os::Value(0.0)).asDouble();
+    std::string file = rf.check("file", yarp::os::Value("")).asString();
+
+    if(!file.empty())
+        yInfo() << "Writing" << duration << "seconds of events to" << file;
+    else if(speed > 0)
+        yInfo() << "Generating" << g.currentRate() * speed << "events/s";
+    else
+        yInfo() << "Generating as fast as possible";
+
+    if(!file.empty() && duration <= 0) {
+        yError() << "Provide the duration of the events to write to disk";
+        return false;
+    }
+
+    if(!generator.initialise(rf.check("name", yarp::os::Value("/vGenerator")).asString(),
+                             file, speed, packet_time, duration))
+        return false;
+
+    prev_events = 0;
+    return generator.start();
+}
+
+bool vGeneratorModule::interruptModule()
+{
+    generator.stop();
+    return yarp::os::RFModule::interruptModule();
+}
+
+bool vGeneratorModule::close()
+{
+    generator.stop();
+    return yarp::os::RFModule::close();
+}
+
+bool vGeneratorModule::updateModule()
+{
+    unsigned long int events = generator.getEventsSent();
+    yInfo() << "Generating happily. kV/s =" << (int)((events - prev_events) /
+                                                    (1000.0 * getPeriod()));
+    prev_events = events;
+    return !isStopping() && generator.isRunning();
+}
+
+double vGeneratorModule::getPeriod()
+{
+    return 1.0;
+}
@@ -21,8 +21,7 @@
 
 #include <yarp/os/all.h>
 #include <iCub/eventdriven/all.h>
-#include "vParticle.h"
-#include <queue>
+#include "vParticleProcessor.h"
 
 /*////////////////////////////////////////////////////////////////////////////*/
 //VPARTICLEREADER
@@ -39,55 +38,32 @@ private:
     yarp::os::Bottle weights;
     yarp::os::Stamp pstamp;
 
-    //event reps
-    ev::temporalSurface surfaceLeft;
-    ev::vtsHelper unwrap;
-    preComputedBins pcb;
-
-    //particle storage and variables
-    //std::priority_queue<vParticle> sortedlist;
-    std::vector<vParticle> indexedlist;
-    vParticle pmax;
-    double pwsum;
-    double pwsumsq;
-    double avgx;
-    double avgy;
-    double avgr;
-    double avgtw;
-
-    double seedx;
-    double seedy;
-    double seedr;
-
-    int rbound_min;
-    int rbound_max;
+    //the tracker
+    vParticleProcessor tracker;
 
     //parameters
     ev::resolution res;
     bool strict;
-    int nparticles;
-    int rate;
-    double nRandomise;
-    bool adaptive;
-    int camera;
     bool useroi;
 
-    double obsThresh;
-    double obsInlier;
-    double obsOutlier;
-
-    bool inbounds(vParticle &p);
+    //timing stats
+    ev::vStats stats;
+    ev::vHistogram &delay;
+    ev::vHistogram &latency;
+    ev::vCounter &events_in;
+    ev::vCounter &bottles_lost;
+    ev::vGauge &queue;
 
 public:
 
     vParticleReader();
     void initialise(unsigned int width , unsigned int height, unsigned int nParticles, unsigned int rate, double nRands, bool adaptive, double pVariance, int camera, bool useROI);
     void setObservationParameters(double minLikelihood, double inlierPar, double outlierPar) {
-        obsThresh = minLikelihood; obsInlier = inlierPar; obsOutlier = outlierPar; }
+        tracker.setObservationParameters(minLikelihood, inlierPar, outlierPar); }
 
     void setSeed(int x, int y, int r)
     {
-        seedx = x; seedy = y; seedr = r;
+        tracker.setSeed(x, y, r);
     }
 
     bool    open(const std::string &name, bool strictness = false);
@@ -40,6 +40,8 @@ class vParticleModule : public yarp::os::RFModule
     particleProcessor *leftThread;
     hSurfThread eventhandler;
     collectorPort outport;
+    ev::vStats stats;
+    ev::vClockReader clock;
 
 public:
 
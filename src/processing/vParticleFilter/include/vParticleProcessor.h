@@ -0,0 +1,108 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VPARTICLEPROCESSOR__
+#define __VPARTICLEPROCESSOR__
+
+#include <iCub/eventdriven/all.h>
+#include "vParticle.h"
+
+/// \brief tracks a circular target in one camera with a particle filter.
+/// Every rate timestamps of events the particles are resampled, predicted and
+/// observed on the temporal surface, and a GaussianAE (sigx = sigy = radius)
+/// is output at the weighted average position. This is the core of the
+/// vFixedRate tracker, shared by the module and ev-offline.
+class vParticleProcessor : public ev::vProcessor
+{
+public:
+
+    /// \brief the filter state after an update
+    struct track {
+        unsigned long int t;
+        double x, y, r, tw;
+    };
+
+private:
+
+    //event reps
+    ev::temporalSurface surface;
+    ev::vtsHelper unwrap;
+    preComputedBins pcb;
+    ev::vQueue stw;
+
+    //particle storage and variables
+    std::vector<vParticle> indexedlist;
+    vParticle pmax;
+    double pwsum;
+    double pwsumsq;
+    double avgx;
+    double avgy;
+    double avgr;
+    double avgtw;
+    std::vector<track> tracks;
+
+    double seedx;
+    double seedy;
+    double seedr;
+
+    int rbound_min;
+    int rbound_max;
+
+    //parameters
+    ev::resolution res;
+    int nparticles;
+    int rate;
+    double nRandomise;
+    bool adaptive;
+    int camera;
+
+    double obsThresh;
+    double obsInlier;
+    double obsOutlier;
+
+    bool inbounds(vParticle &p);
+    void update(unsigned long int t, unsigned int ctime);
+
+public:
+
+    vParticleProcessor();
+    void initialise(unsigned int width, unsigned int height,
+                    unsigned int nParticles, unsigned int rate, double nRands,
+                    bool adaptive, double pVariance, int camera);
+    void setObservationParameters(double minLikelihood, double inlierPar,
+                                  double outlierPar) {
+        obsThresh = minLikelihood; obsInlier = inlierPar;
+        obsOutlier = outlierPar; }
+    void setSeed(int x, int y, int r) { seedx = x; seedy = y; seedr = r; }
+
+    /// \brief adds the events of the camera to the surface and outputs a
+    /// GaussianAE for each update of the filter
+    void process(const ev::vQueue &in, ev::vQueue &out);
+
+    /// \brief the state after each update of the last process() call
+    const std::vector<track>& getTracks() { return tracks; }
+    std::vector<vParticle>& getParticles() { return indexedlist; }
+    ev::vQueue& getWindow() { return stw; }
+    double getx() { return avgx; }
+    double gety() { return avgy; }
+    double getr() { return avgr; }
+    double gettw() { return avgtw; }
+
+};
+
+#endif
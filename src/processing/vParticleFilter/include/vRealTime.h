@@ -103,10 +103,19 @@ private:
     double obsInlier;
     double obsOutlier;
 
+    //timing stats
+    ev::vHistogram *delay;
+    ev::vHistogram *latency;
+    ev::vCounter *events_in;
+    ev::vCounter *updates;
+
     bool inbounds(vParticle &p);
 
 public:
 
+    /// \brief register the statistics of this camera's filter. Must be
+    /// called before the thread is started.
+    void setStats(ev::vStats &stats);
     void setComputeOptions(int camera, int threads, bool useROI) {
         this->camera = camera; nThreads = threads; useroi = useROI; }
     void setFilterParameters(int nParticles, double nRandomise, bool adaptive, double variance) {
@@ -118,6 +118,7 @@ bool vParticleModule::configure(yarp::os::ResourceFinder &rf)
                 std::cout << "Using initial seed location: " << seed->toString() << std::endl;
                 leftThread->setSeed(seed->get(0).asDouble(), seed->get(1).asDouble(), seed->get(2).asDouble());
             }
+            leftThread->setStats(stats);
             if(!leftThread->start())
                 return false;
         }
@@ -133,6 +134,7 @@ bool vParticleModule::configure(yarp::os::ResourceFinder &rf)
                 std::cout << "Using initial seed location: " << seed->toString() << std::endl;
                 rightThread->setSeed(seed->get(0).asDouble(), seed->get(1).asDouble(), seed->get(2).asDouble());
             }
+            rightThread->setStats(stats);
             if(!rightThread->start())
                 return false;
         }
@@ -142,10 +144,15 @@ bool vParticleModule::configure(yarp::os::ResourceFinder &rf)
             return false;
         if(!outport.start())
             return false;
+        if(!clock.open(getName() + "/clock:i"))
+            return false;
+        eventhandler.setClock(&clock.model());
         if(!eventhandler.open(getName() + "/vBottle:i"))
             return false;
         if(!eventhandler.start())
             return false;
+        if(!stats.open(getName() + "/stats:o"))
+            return false;
 
     }
 
@@ -160,6 +167,8 @@ bool vParticleModule::interruptModule()
     if(particleCallback) particleCallback->interrupt();
     if(leftThread) leftThread->stop();
     if(rightThread) rightThread->stop();
+    if(!particleCallback) stats.close();
+    if(!particleCallback) clock.close();
 
     std::cout << "Interrupt Successful" << std::endl;
     return true;
@@ -0,0 +1,233 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vParticleProcessor.h"
+
+using namespace ev;
+
+/******************************************************************************/
+vParticleProcessor::vParticleProcessor()
+{
+    pmax.resetWeight(0.0);
+    srand(yarp::os::Time::now());
+
+    avgx = 64;
+    avgy = 64;
+    avgr = 20;
+    avgtw = 50000;
+    nparticles = 50;
+    pwsum = 1.0;
+    pwsumsq = nparticles * pow(1.0 / nparticles, 2.0);
+    rate = 1000;
+    nRandomise = 1.0;
+    adaptive = false;
+    camera = 0;
+    seedx = 0; seedy = 0; seedr = 0;
+
+    obsThresh = 30.0;
+    obsInlier = 1.5;
+    obsOutlier = 3.0;
+
+    rbound_max = 50;
+    rbound_min = 10;
+}
+
+/******************************************************************************/
+void vParticleProcessor::initialise(unsigned int width, unsigned int height,
+                                    unsigned int nParticles, unsigned int rate,
+                                    double nRands, bool adaptive,
+                                    double pVariance, int camera)
+{
+    //parameters
+    res.width = width;
+    res.height = height;
+
+    this->camera = camera;
+
+    surface = ev::temporalSurface(width, height);
+
+    rbound_min = res.width/25;
+    rbound_max = res.width/6;
+
+    pcb.configure(res.height, res.width, rbound_max, 128);
+
+    nparticles = nParticles;
+    this->nRandomise = 1.0 + nRands;
+    this->adaptive = adaptive;
+    this->rate = rate;
+
+    pwsumsq = nparticles * pow(1.0 / nparticles, 2.0);
+
+    //initialise the particles
+    vParticle p;
+
+    indexedlist.clear();
+    for(int i = 0; i < nparticles; i++) {
+        p.initialiseParameters(i, obsThresh, obsOutlier, obsInlier, pVariance, 128);
+        p.attachPCB(&pcb);
+
+        if(seedr)
+            p.initialiseState(seedx, seedy, seedr, 50000);
+        else
+            p.randomise(res.width, res.height, 30, 50000);
+
+        p.resetWeight(1.0/nparticles);
+
+        indexedlist.push_back(p);
+    }
+}
+
+/******************************************************************************/
+bool vParticleProcessor::inbounds(vParticle &p)
+{
+    int r = p.getr();
+
+    if(r < rbound_min) {
+        p.resetRadius(rbound_min);
+        r = rbound_min;
+    }
+    if(r > rbound_max) {
+        p.resetRadius(rbound_max);
+        r = rbound_max;
+    }
+    if(p.getx() < -r || p.getx() > res.width + r)
+        return false;
+    if(p.gety() < -r || p.gety() > res.height + r)
+        return false;
+
+    return true;
+}
+
+/******************************************************************************/
+void vParticleProcessor::update(unsigned long int t, unsigned int ctime)
+{
+    //RESAMPLE
+    if(!adaptive || pwsumsq * nparticles > 2.0) {
+        std::vector<vParticle> indexedSnap = indexedlist;
+        for(int i = 0; i < nparticles; i++) {
+            double rn = this->nRandomise * pwsum * (double)rand() / RAND_MAX;
+            if(rn > pwsum)
+                indexedlist[i].randomise(res.width, res.height, 30.0, avgtw);
+            else {
+                double accum = 0.0; int j = 0;
+                for(j = 0; j < nparticles; j++) {
+                    accum += indexedSnap[j].getw();
+                    if(accum > rn) break;
+                }
+                indexedlist[i] = indexedSnap[j];
+            }
+        }
+    }
+
+    //PREDICT
+    unsigned int maxtw = 0;
+    for(int i = 0; i < nparticles; i++) {
+        indexedlist[i].predict(t);
+        if(!inbounds(indexedlist[i])) {
+            indexedlist[i].randomise(res.width, res.height, 30.0, avgtw);
+        }
+        if(indexedlist[i].gettw() > maxtw)
+            maxtw = indexedlist[i].gettw();
+    }
+
+    //OBSERVE
+    for(int i = 0; i < nparticles; i++) {
+        indexedlist[i].initLikelihood();
+    }
+
+    stw = surface.getSurf_Tlim(maxtw);
+    for(unsigned int i = 0; i < stw.size(); i++) {
+        //calc dt
+        double dt = ctime - stw[i]->stamp;
+        if(dt < 0) dt += ev::vtsHelper::max_stamp;
+        auto v = is_event<AE>(stw[i]);
+        for(int i = 0; i < nparticles; i++) {
+            if(dt < indexedlist[i].gettw())
+                indexedlist[i].incrementalLikelihood(v->x, v->y, dt);
+        }
+    }
+
+    //NORMALISE
+    double normval = 0.0;
+    for(int i = 0; i < nparticles; i++) {
+        indexedlist[i].concludeLikelihood();
+        normval += indexedlist[i].getw();
+    }
+
+    //FIND THE AVERAGE POSITION
+    pwsum = 0;
+    pwsumsq = 0;
+    avgx = 0;
+    avgy = 0;
+    avgr = 0;
+    avgtw = 0;
+
+    pmax = indexedlist[0];
+    for(int i = 0; i < nparticles; i ++) {
+        indexedlist[i].updateWeightSync(normval);
+        if(indexedlist[i].getw() > pmax.getw()) {
+            pmax = indexedlist[i];
+        }
+
+        pwsum += indexedlist[i].getw();
+        pwsumsq += pow(indexedlist[i].getw(), 2.0);
+        avgx += indexedlist[i].getx() * indexedlist[i].getw();
+        avgy += indexedlist[i].gety() * indexedlist[i].getw();
+        avgr += indexedlist[i].getr() * indexedlist[i].getw();
+        avgtw += indexedlist[i].gettw() * indexedlist[i].getw();
+    }
+}
+
+/******************************************************************************/
+void vParticleProcessor::process(const ev::vQueue &in, ev::vQueue &out)
+{
+    tracks.clear();
+
+    unsigned long int pt = 0;
+    unsigned long int t = 0;
+
+    for(vQueue::const_iterator qi = in.begin(); qi != in.end(); qi++) {
+
+        if((*qi)->getChannel() != camera) continue;
+        if(!is_event<AE>(*qi)) continue;
+
+        surface.addEvent(*qi);
+
+        t = unwrap((*qi)->stamp);
+        if((int)(t - pt) < rate) continue;
+        pt = t;
+
+        update(t, (*qi)->stamp);
+
+        auto ceg = make_event<GaussianAE>();
+        ceg->stamp = stw.front()->stamp;
+        ceg->setChannel(camera);
+        ceg->x = avgx;
+        ceg->y = avgy;
+        ceg->sigx = avgr;
+        ceg->sigy = avgr;
+        ceg->sigxy = 0;
+        ceg->polarity = 1;
+        out.push_back(ceg);
+
+        track state = {t, avgx, avgy, avgr, avgtw};
+        tracks.push_back(state);
+    }
+}
+
+//empty line to make gcc happy
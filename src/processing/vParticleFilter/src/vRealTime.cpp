@@ -49,6 +49,11 @@ particleProcessor::particleProcessor(std::string name, unsigned int height, unsi
     seedy = 0;
     seedr = 0;
 
+    delay = 0;
+    latency = 0;
+    events_in = 0;
+    updates = 0;
+
     avgx = 64;
     avgy = 64;
     avgr = 12;
@@ -61,6 +66,15 @@ particleProcessor::particleProcessor(std::string name, unsigned int height, unsi
 
 }
 
+void particleProcessor::setStats(ev::vStats &stats)
+{
+    std::string suffix = camera ? "_right" : "_left";
+    delay = &stats.histogram("delay" + suffix);
+    latency = &stats.histogram("update" + suffix);
+    events_in = &stats.counter("events" + suffix);
+    updates = &stats.counter("updates" + suffix);
+}
+
 bool particleProcessor::threadInit()
 {
     std::cout << "Initialising thread" << std::endl;
@@ -152,6 +166,12 @@ void particleProcessor::run()
 
     while(!isStopping()) {
 
+        ev::vScopedTimer timer(*latency);
+        if(yarpstamp.isValid())
+            delay->record(yarp::os::Time::now() - yarpstamp.getTime());
+        events_in->add(stw2.size());
+        updates->add();
+
         Twincopy = yarp::os::Time::now();
         stw = stw2;
         Twincopy = yarp::os::Time::now() - Twincopy;
@@ -0,0 +1,96 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// \defgroup Modules Modules
+// \defgroup vPlayer vPlayer
+// \ingroup Modules
+// \brief plays recorded event datasets at high rates
+
+#ifndef __VPLAYER__
+#define __VPLAYER__
+
+#include <yarp/os/all.h>
+#include <iCub/eventdriven/all.h>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace ev;
+
+class vPlayer : public yarp::os::Thread
+{
+private:
+
+    //an output per event-type in the log
+    struct output {
+        vGenWritePort port;
+        std::vector<std::int32_t> buffer;
+        std::uint64_t packet_start;
+        std::uint64_t packet_end;
+        int count;
+    };
+
+    std::map<std::string, output *> outputs;
+    vLogReader reader;
+
+    //parameters
+    std::string name;
+    double speed;
+    std::uint64_t packet_time;
+    bool loop;
+
+    //playback state
+    std::uint64_t t0;
+    double wall0;
+    unsigned long int events_sent;
+
+    output *getOutput(const std::string &tag);
+    void pace(std::uint64_t time);
+    void send(output *out, const std::string &tag);
+    void repacketise(const vLogChunk &chunk, output *out);
+
+public:
+
+    vPlayer();
+    ~vPlayer();
+
+    bool initialise(std::string name, std::string file, double speed,
+                    double packet_time, bool loop);
+    unsigned long int getEventsSent();
+    void run();
+
+};
+
+class vPlayerModule : public yarp::os::RFModule
+{
+    vPlayer player;
+    unsigned long int prev_events;
+
+public:
+
+    //the virtual functions that need to be overloaded
+    virtual bool configure(yarp::os::ResourceFinder &rf);
+    virtual bool interruptModule();
+    virtual bool close();
+
+    virtual double getPeriod();
+    virtual bool updateModule();
+
+};
+
+#endif
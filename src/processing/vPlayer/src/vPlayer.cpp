@@ -0,0 +1,248 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vPlayer.h"
+
+int main(int argc, char * argv[])
+{
+    /* initialize yarp network */
+    yarp::os::Network yarp;
+    if(!yarp.checkNetwork()) {
+        yError() << "Could not find YARP";
+        return false;
+    }
+
+    /* prepare and configure the resource finder */
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose();
+    rf.setDefaultContext( "eventdriven" );
+    rf.setDefaultConfigFile( "vPlayer.ini" );
+    rf.configure( argc, argv );
+
+    /* create the module */
+    vPlayerModule playerModule;
+    /* run the module: runModule() calls configure first and, if successful, it then runs */
+    return playerModule.runModule(rf);
+}
+
+/******************************************************************************/
+//vPlayer
+/******************************************************************************/
+vPlayer::vPlayer()
+{
+    speed = 1.0;
+    packet_time = 0;
+    loop = false;
+    t0 = 0;
+    wall0 = 0;
+    events_sent = 0;
+}
+
+vPlayer::~vPlayer()
+{
+    std::map<std::string, output *>::iterator i;
+    for(i = outputs.begin(); i != outputs.end(); i++) {
+        i->second->port.close();
+        delete i->second;
+    }
+}
+
+bool vPlayer::initialise(std::string name, std::string file, double speed,
+                         double packet_time, bool loop)
+{
+    this->name = name;
+    this->speed = speed;
+    this->packet_time = packet_time * 0.000001 * vtsHelper::vtsscaler;
+    this->loop = loop;
+
+    //text logs are converted once to a binary log alongside them, which is
+    //then memory mapped for playback
+    std::string binlog = findBinaryLog(file);
+    if(binlog.empty())
+        return false;
+
+    if(!reader.open(binlog))
+        return false;
+
+    yInfo() << "Loaded" << (reader.lastTime() - reader.firstTime()) *
+               vtsHelper::tsscaler << "seconds of events";
+    return true;
+}
+
+unsigned long int vPlayer::getEventsSent()
+{
+    return events_sent;
+}
+
+vPlayer::output * vPlayer::getOutput(const std::string &tag)
+{
+    std::map<std::string, output *>::iterator i = outputs.find(tag);
+    if(i != outputs.end())
+        return i->second;
+
+    output *out = new output;
+    out->packet_start = 0;
+    out->packet_end = 0;
+    out->count = 0;
+    out->port.setWriteType(tag);
+    if(!out->port.open(name + "/" + tag + ":o"))
+        yError() << "Could not open output for" << tag;
+    outputs[tag] = out;
+    return out;
+}
+
+void vPlayer::pace(std::uint64_t time)
+{
+    //speed 0 plays as fast as the output ports allow
+    if(speed <= 0) return;
+
+    double target = wall0 + (time - t0) * vtsHelper::tsscaler / speed;
+    double dt = target - yarp::os::Time::now();
+    if(dt > 0)
+        yarp::os::Time::delay(dt);
+}
+
+void vPlayer::send(output *out, const std::string &tag)
+{
+    if(out->buffer.empty()) return;
+
+    pace(out->packet_end);
+    out->port.write(out->buffer.data(), out->buffer.size(),
+                    yarp::os::Stamp(++out->count,
+                                    out->packet_end * vtsHelper::tsscaler));
+    events_sent += out->buffer.size() / packetSize(tag);
+    out->buffer.clear();
+}
+
+void vPlayer::repacketise(const vLogChunk &chunk, output *out)
+{
+    //packets are cut every packet_time of event time, across chunks
+    std::string tag = chunk.tag();
+    unsigned int event_size = packetSize(tag);
+    const std::int32_t *data = chunk.data;
+    std::uint32_t first_stamp = chunk.header->first_stamp;
+
+    for(unsigned int i = 0; i < chunk.header->n_ints; i += event_size) {
+
+        std::uint64_t t = chunk.header->first_time +
+                stampTraits<AE>::delta(data[i] & vtsHelper::max_stamp,
+                                       first_stamp);
+
+        if(out->buffer.empty())
+            out->packet_start = t;
+        else if(t >= out->packet_start + packet_time) {
+            send(out, tag);
+            out->packet_start = t;
+        }
+
+        out->buffer.insert(out->buffer.end(), data + i, data + i + event_size);
+        out->packet_end = t;
+    }
+}
+
+void vPlayer::run()
+{
+    do {
+
+        reader.rewind();
+        t0 = reader.firstTime();
+        wall0 = yarp::os::Time::now();
+
+        vLogChunk chunk;
+        while(!isStopping() && reader.next(chunk)) {
+
+            std::string tag = chunk.tag();
+            output *out = getOutput(tag);
+
+            if(packet_time) {
+                repacketise(chunk, out);
+                continue;
+            }
+
+            //keep the original packets and envelopes
+            pace(chunk.header->last_time);
+            out->port.write(chunk.data, chunk.header->n_ints, chunk.envelope());
+            events_sent += chunk.header->n_ints / packetSize(tag);
+        }
+
+        std::map<std::string, output *>::iterator i;
+        for(i = outputs.begin(); i != outputs.end(); i++)
+            send(i->second, i->first);
+
+    } while(loop && !isStopping());
+
+    yInfo() << "Playback finished";
+}
+
+/******************************************************************************/
+//vPlayerModule
+/******************************************************************************/
+bool vPlayerModule::configure(yarp::os::ResourceFinder &rf)
+{
+    if(!rf.check("file")) {
+        yError() << "Please provide a data.log or binary log with --file";
+        return false;
+    }
+
+    bool loop = rf.check("loop") &&
+            rf.check("loop", yarp::os::Value(true)).asBool();
+    double speed = rf.check("speed", yarp::os::Value(1.0)).asDouble();
+    double packet_time = rf.check("packet_time", yarp::os::Value(0)).asDouble();
+
+    if(speed > 0)
+        yInfo() << "Playing at" << speed << "x real-time";
+    else
+        yInfo() << "Playing as fast as possible";
+    if(packet_time > 0)
+        yInfo() << "Re-packetising every" << packet_time << "us";
+    else
+        yInfo() << "Keeping original packets";
+
+    if(!player.initialise(rf.check("name", yarp::os::Value("/vPlayer")).asString(),
+                          rf.find("file").asString(), speed, packet_time, loop))
+        return false;
+
+    prev_events = 0;
+    return player.start();
+}
+
+bool vPlayerModule::interruptModule()
+{
+    player.stop();
+    return yarp::os::RFModule::interruptModule();
+}
+
+bool vPlayerModule::close()
+{
+    player.stop();
+    return yarp::os::RFModule::close();
+}
+
+bool vPlayerModule::updateModule()
+{
+    unsigned long int events = player.getEventsSent();
+    yInfo() << "Playing happily. kV/s =" << (int)((events - prev_events) /
+                                                 (1000.0 * getPeriod()));
+    prev_events = events;
+    return !isStopping();
+}
+
+double vPlayerModule::getPeriod()
+{
+    return 1.0;
+}
@@ -32,6 +32,142 @@
 #include <opencv2/opencv.hpp>
 using namespace::ev;
 
+/// \brief the events of an input bottle as they pass through the stages of
+/// the pre-processing
+struct eventPacket
+{
+    vTrace trace;
+    double received;
+    std::vector<AE> events;
+    std::vector<std::uint64_t> ustamps;
+};
+
+/// \brief an output of the router, sending the events that meet all of its
+/// conditions: (channel c) (polarity p) (type t) (roi x0 y0 x1 y1) and
+/// (decimate n) to send only one in every n of them. Each reader of the route
+/// can also ask for a part of the events (see ev::vFilteredWritePort).
+class eventRoute
+{
+private:
+
+    std::string name;
+    int channel;
+    int polarity;
+    int type;
+    bool roi;
+    int x0, y0, x1, y1;
+    unsigned int decimate;
+    unsigned int count;
+
+    bool unwrap;
+    //readers can ask each port for a part of its events
+#if DECODE_METHOD != 2
+    vGenFilteredWritePort port;
+    vQueue q;
+#else
+    vFilteredWritePort< std::deque<AE>, vWritePort<AE> > port;
+    std::deque<AE> q;
+#endif
+    vFilteredWritePort< std::deque<AE64>, vWritePort<AE64> > portU;
+    std::deque<AE64> qU;
+
+public:
+
+    eventRoute(const std::string &name);
+
+    /// \brief set the conditions from a list of (key value) pairs
+    bool configure(const yarp::os::Bottle &conditions);
+    bool open(const std::string &module_name, bool unwrap);
+    void close();
+
+    /// \brief add the event if it meets the conditions
+    inline void route(const AE &v, std::uint64_t ustamp)
+    {
+        if(channel >= 0 && v.channel != channel) return;
+        if(polarity >= 0 && v.polarity != polarity) return;
+        if(type >= 0 && v.type != type) return;
+        if(roi && (v.x < x0 || v.x > x1 || v.y < y0 || v.y > y1)) return;
+        if(decimate > 1 && ++count % decimate) return;
+
+        if(unwrap) {
+            qU.push_back(AE64(v));
+            qU.back().setUnwrappedStamp(ustamp);
+        } else {
+#if DECODE_METHOD != 2
+            q.push_back(std::make_shared<AE>(v));
+#else
+            q.push_back(v);
+#endif
+        }
+    }
+
+    /// \brief send the events routed since the last write
+    /// \returns the number of events sent
+    unsigned int write(const vTrace &trace);
+
+    const std::string & getName() { return name; }
+
+};
+
+/// \brief a bounded single-producer single-consumer queue of packets. push()
+/// blocks if the queue is full, and pop() if it is empty.
+class packetQueue
+{
+private:
+
+    std::vector<eventPacket *> ring;
+    unsigned int head;
+    unsigned int tail;
+    yarp::os::Semaphore items;
+    yarp::os::Semaphore spaces;
+
+public:
+
+    packetQueue(unsigned int size) : ring(size), head(0), tail(0), items(0),
+        spaces(size) {}
+
+    void push(eventPacket *packet)
+    {
+        spaces.wait();
+        ring[head] = packet;
+        head = (head + 1) % ring.size();
+        items.post();
+    }
+
+    eventPacket * pop()
+    {
+        items.wait();
+        eventPacket *packet = ring[tail];
+        tail = (tail + 1) % ring.size();
+        spaces.post();
+        return packet;
+    }
+
+};
+
+class vPreProcess;
+
+/// \brief runs a stage of the vPreProcess pipeline on its own thread
+class preProcessStage : public yarp::os::Thread
+{
+public:
+
+    enum stage { FILTER, REMAP, OUTPUT };
+
+private:
+
+    vPreProcess *owner;
+    stage role;
+    unsigned int index;
+
+public:
+
+    preProcessStage(vPreProcess *owner, stage role, unsigned int index = 0) :
+        owner(owner), role(role), index(index) {}
+    void run();
+
+};
+
 class vPreProcess : public yarp::os::Thread
 {
 private:
@@ -40,16 +176,10 @@ private:
 
 #if DECODE_METHOD == 0
     ev::queueAllocator inPort;
-    vGenWritePort outPort;
-    vGenWritePort outPort2;
 #elif DECODE_METHOD == 1
     vGenReadPort inPort;
-    vGenWritePort outPort;
-    vGenWritePort outPort2;
 #else
     vReadPort<AE> inPort;
-    vWritePort<AE> outPort;
-    vWritePort<AE> outPort2;
 #endif
 
     //parameters
@@ -65,20 +195,60 @@ private:
     bool pepper;
     ev::vNoiseFilter thefilter;
 
-    //we store an openCV map to use as a look-up table for the undistortion
-    //given the camera parameters provided
+    //counts the events of each pixel (at the filter stage) and drops the
+    //pixels found to fire persistently in the remap table
+    bool hotpixels;
+    ev::vHotPixels hot;
+
+    //the flips, the undistortion (computed with openCV from the camera
+    //parameters provided) and the truncation are folded into one look-up
+    //table from the sensor address to the output address
     bool undistort;
-    cv::Mat leftMap;
-    cv::Mat rightMap;
     bool truncate;
+    ev::vRemapTable remap;
 
-    //output
+    //output: each event is given to every route (by default, left/right if
+    //split, or all events to vBottle:o)
     bool split;
+    std::vector<eventRoute *> routes;
+
+    //unwrap the timestamps once here and send 64-bit stamped events
+    bool unwrap;
+    ev::vtsHelper unwrapper;
 
     //timing stats
-    std::deque<double> delays;
-    std::deque<double> rates;
-    std::deque<double> intervals;
+    ev::vStats stats;
+    ev::vHistogram &delay;
+    ev::vHistogram &interval;
+    ev::vHistogram &latency;
+    ev::vCounter &events_in;
+    ev::vCounter &events_out;
+    ev::vCounter &dropped;
+    ev::vGauge &queue;
+    ev::vGauge &hot_pixels;
+
+    //the packets are read on this thread, then pass through the filter,
+    //remap (dealt in turn to n_remap threads) and output stages. The output
+    //collects the remap queues in the same turn, so the order is kept.
+    bool pipelined;
+    unsigned int n_remap;
+    std::vector<eventPacket> pool;
+    packetQueue *free_packets;
+    packetQueue *to_filter;
+    std::vector<packetQueue *> to_remap;
+    std::vector<packetQueue *> to_output;
+    std::vector<preProcessStage *> stages;
+
+    //stages
+    void filterPacket(eventPacket &packet);
+    void remapPacket(eventPacket &packet);
+    void writePacket(eventPacket &packet);
+
+    void runFilter();
+    void runRemap(unsigned int index);
+    void runOutput();
+
+    friend class preProcessStage;
 
 public:
 
@@ -87,17 +257,27 @@ public:
 
     void initBasic(std::string name, int height, int width, bool precheck,
                    bool flipx, bool flipy, bool pepper, bool undistort,
-                   bool split);
+                   bool split, bool unwrap);
     void initPepper(int spatialSize, int temporalSize);
+    /// \brief detect and mask hot pixels (see ev::vHotPixels)
+    void initHotPixels(double period, double factor, double min_rate,
+                       int persistence, std::string file);
     void initUndistortion(const yarp::os::Bottle &left,
                           const yarp::os::Bottle &right, bool truncate);
+    /// \brief drop the events outside of x0 <= x <= x1, y0 <= y <= y1 (after
+    /// flips and undistortion)
+    void initROI(int x0, int y0, int x1, int y1);
+    /// \brief add an output port <name>/<route>:o of the events meeting the
+    /// conditions (see eventRoute)
+    bool addRoute(const std::string &route, const yarp::os::Bottle &conditions);
+    /// \brief run the filter, remap and output on their own threads (with
+    /// remap_threads for the remap), with at most n_packets in flight
+    void initPipeline(unsigned int remap_threads, unsigned int n_packets);
     int queryUnprocessed();
-    std::deque<double> getDelays();
-    std::deque<double> getRates();
-    std::deque<double> getIntervals();
     void run();
     void onStop();
     bool threadInit();
+    void threadRelease();
 
 };
 
@@ -58,6 +58,12 @@ bool vPreProcessModule::configure(yarp::os::ResourceFinder &rf)
             rf.check("precheck", yarp::os::Value(true)).asBool();
     bool split = rf.check("split") &&
             rf.check("split", yarp::os::Value(true)).asBool();
+    bool unwrap = rf.check("unwrap") &&
+            rf.check("unwrap", yarp::os::Value(true)).asBool();
+    bool hotPixels = rf.check("hotPixels") &&
+            rf.check("hotPixels", yarp::os::Value(true)).asBool();
+    bool pipeline = rf.check("pipeline") &&
+            rf.check("pipeline", yarp::os::Value(true)).asBool();
 
     if(precheck)
         yInfo() << "Performing precheck for event corruption";
@@ -73,6 +79,12 @@ bool vPreProcessModule::configure(yarp::os::ResourceFinder &rf)
         yInfo() << "Applying camera undistortion - without truncation";
     if(split)
         yInfo() << "Splitting into left/right streams";
+    if(unwrap)
+        yInfo() << "Unwrapping timestamps - sending" << AE64::tag;
+    if(pipeline)
+        yInfo() << "Running the stages on separate threads";
+    if(hotPixels)
+        yInfo() << "Detecting and masking hot pixels";
 
 #if DECODE_METHOD == 0
     yInfo() << "Decoding with vBottle";
@@ -86,13 +98,32 @@ bool vPreProcessModule::configure(yarp::os::ResourceFinder &rf)
     eventManager.initBasic(rf.check("name", yarp::os::Value("/vPreProcess")).asString(),
                            rf.check("height", yarp::os::Value(240)).asInt(),
                            rf.check("width", yarp::os::Value(304)).asInt(),
-                           precheck, flipx, flipy, pepper, undistort, split);
+                           precheck, flipx, flipy, pepper, undistort, split,
+                           unwrap);
+
+    //the routing table, a line for each output: <route> [channel c]
+    //[polarity p] [type t] [roi (x0 y0 x1 y1)] [decimate n]
+    yarp::os::Bottle &routeGroup = rf.findGroup("ROUTES");
+    for(size_t i = 1; i < routeGroup.size(); i++) {
+        yarp::os::Bottle *route = routeGroup.get(i).asList();
+        if(!route || !route->size()) continue;
+        if(!eventManager.addRoute(route->get(0).asString(), route->tail()))
+            return false;
+    }
 
     if(pepper) {
         eventManager.initPepper(rf.check("spatialSize", yarp::os::Value(1)).asDouble(),
                                 rf.check("temporalSize", yarp::os::Value(100000)).asDouble());
     }
 
+    if(hotPixels) {
+        eventManager.initHotPixels(rf.check("hotPixelPeriod", yarp::os::Value(2.0)).asDouble(),
+                                   rf.check("hotPixelFactor", yarp::os::Value(20.0)).asDouble(),
+                                   rf.check("hotPixelRate", yarp::os::Value(20.0)).asDouble(),
+                                   rf.check("hotPixelPersistence", yarp::os::Value(3)).asInt(),
+                                   rf.check("hotPixelFile", yarp::os::Value("")).asString());
+    }
+
     if(undistort) {
         yarp::os::ResourceFinder calibfinder;
         calibfinder.setVerbose();
@@ -111,6 +142,19 @@ bool vPreProcessModule::configure(yarp::os::ResourceFinder &rf)
         eventManager.initUndistortion(leftParams, rightParams, truncate);
     }
 
+    if(pipeline) {
+        eventManager.initPipeline(rf.check("threads", yarp::os::Value(1)).asInt(),
+                                  rf.check("packets", yarp::os::Value(16)).asInt());
+    }
+
+    //only pass events inside a region (of the output image)
+    yarp::os::Bottle *roi = rf.find("roi").asList();
+    if(roi && roi->size() == 4) {
+        yInfo() << "Cropping to" << roi->toString();
+        eventManager.initROI(roi->get(0).asInt(), roi->get(1).asInt(),
+                             roi->get(2).asInt(), roi->get(3).asInt());
+    }
+
     return eventManager.start();
 
 }
@@ -132,70 +176,99 @@ bool vPreProcessModule::updateModule()
     }
 
     return true;
+}
 
-    //delays
-    std::deque<double> dcopy = eventManager.getDelays();
-
-    if(!dcopy.size())
-        return true;
-
-    double mind = 1e6;
-    double maxd = -1e6;
-    double meand = 0;
-    for(size_t i = 0; i < dcopy.size(); i++) {
-        mind = std::min(mind, dcopy[i]);
-        maxd = std::max(maxd, dcopy[i]);
-        meand += dcopy[i];
-    }
-    meand /= dcopy.size();
-    meand *= 1000;
-    mind *= 1000;
-    maxd *= 1000;
-
-    double meanr = 0;
-    std::deque<double> rcopy = eventManager.getRates();
-    for(size_t i = 0; i < rcopy.size(); i++) {
-        meanr += rcopy[i];
-    }
-    meanr /= rcopy.size();
-    meanr *= vtsHelper::vtsscaler;
+double vPreProcessModule::getPeriod()
+{
+    return 0.1;
+}
+/******************************************************************************/
+//eventRoute
+/******************************************************************************/
+eventRoute::eventRoute(const std::string &name) : name(name), channel(-1),
+    polarity(-1), type(-1), roi(false), x0(0), y0(0), x1(0), y1(0),
+    decimate(1), count(0), unwrap(false)
+{
+}
 
-    double meani = 0;
-    std::deque<double> icopy = eventManager.getIntervals();
-    for(size_t i = 0; i < icopy.size(); i++) {
-        meani += icopy[i];
+bool eventRoute::configure(const yarp::os::Bottle &conditions)
+{
+    if(conditions.check("channel"))
+        channel = conditions.find("channel").asInt();
+    if(conditions.check("polarity"))
+        polarity = conditions.find("polarity").asInt();
+    if(conditions.check("type"))
+        type = conditions.find("type").asInt();
+    if(conditions.check("decimate"))
+        decimate = std::max(conditions.find("decimate").asInt(), 1);
+    if(conditions.check("roi")) {
+        yarp::os::Bottle *r = conditions.find("roi").asList();
+        if(!r || r->size() != 4)
+            return false;
+        roi = true;
+        x0 = r->get(0).asInt(); y0 = r->get(1).asInt();
+        x1 = r->get(2).asInt(); y1 = r->get(3).asInt();
     }
-    meani /= icopy.size();
-    meani *= 1000;
+    return true;
+}
 
-    //yInfo() << mind << meand << maxd << " : min | mean | max";
-    std::cout << std::fixed << mind << " " << meand << " " << maxd << " " << meanr << " " << meani << std::endl;
+bool eventRoute::open(const std::string &module_name, bool unwrap)
+{
+    this->unwrap = unwrap;
+    port.setWriteType(AE::tag);
+    if(unwrap)
+        return portU.open(module_name + "/" + name + ":o");
+    return port.open(module_name + "/" + name + ":o");
+}
 
-    return true;
+void eventRoute::close()
+{
+    port.close();
+    portU.close();
 }
 
-double vPreProcessModule::getPeriod()
+unsigned int eventRoute::write(const vTrace &trace)
 {
-    return 0.1;
+    //a route sends either the AE or the AE64 stream, never both
+    unsigned int n = 0;
+    if(unwrap && qU.size()) {
+        n = qU.size();
+        portU.write(qU, trace);
+        qU.clear();
+    } else if(!unwrap && q.size()) {
+        n = q.size();
+        port.write(q, trace);
+        q.clear();
+    }
+    return n;
 }
+
 /******************************************************************************/
-vPreProcess::vPreProcess(): name("/vPreProcess")
+vPreProcess::vPreProcess(): name("/vPreProcess"),
+    delay(stats.histogram("delay")), interval(stats.histogram("interval")),
+    latency(stats.histogram("process")), events_in(stats.counter("events_in")),
+    events_out(stats.counter("events_out")), dropped(stats.counter("bottles_dropped")),
+    queue(stats.gauge("queue")), hot_pixels(stats.gauge("hot_pixels")),
+    pipelined(false), n_remap(1), pool(1), free_packets(nullptr),
+    to_filter(nullptr)
 {
-    leftMap.deallocate();
-    rightMap.deallocate();
+    hotpixels = false;
 }
 
 
 vPreProcess::~vPreProcess()
 {
     inPort.close();
-    outPort.close();
-    outPort2.close();
+    for(unsigned int i = 0; i < routes.size(); i++) {
+        routes[i]->close();
+        delete routes[i];
+    }
 }
 
 void vPreProcess::initBasic(std::string name, int height, int width,
                             bool precheck, bool flipx, bool flipy,
-                            bool pepper, bool undistort, bool split)
+                            bool pepper, bool undistort, bool split,
+                            bool unwrap)
 {
 
     this->name = name;
@@ -207,6 +280,9 @@ void vPreProcess::initBasic(std::string name, int height, int width,
     this->pepper = pepper;
     this->undistort = undistort;
     this->split = split;
+    this->unwrap = unwrap;
+
+    remap.initialise(width, height, flipx, flipy);
 
 }
 
@@ -215,12 +291,20 @@ void vPreProcess::initPepper(int spatialSize, int temporalSize)
     thefilter.initialise(res.width, res.height, temporalSize, spatialSize);
 }
 
+void vPreProcess::initHotPixels(double period, double factor,
+                                double min_rate, int persistence,
+                                std::string file)
+{
+    hotpixels = true;
+    hot.initialise(res.width, res.height, period, factor, min_rate,
+                   persistence, file);
+}
+
 void vPreProcess::initUndistortion(const yarp::os::Bottle &left,
                                const yarp::os::Bottle &right, bool truncate)
 {
     this->truncate = truncate;
     const yarp::os::Bottle *coeffs[2] = { &left, &right};
-    cv::Mat *maps[2] = {&leftMap, &rightMap};
 
     //create camera matrix
     for(int i = 0; i < 2; i++) {
@@ -257,179 +341,314 @@ void vPreProcess::initUndistortion(const yarp::os::Bottle &left,
         cv::undistortPoints(allpoints, mappoints, cameraMatrix, distCoeffs,
                             cv::noArray(), defCamMat);
 
-        *(maps[i]) = cv::Mat(res.height, res.width, CV_32SC2);
-        for(unsigned int y = 0; y < res.height; y++) {
-            for(unsigned int x = 0; x < res.width; x++) {
-                maps[i]->at<cv::Vec2i>(y, x) =
-                        mappoints.at<cv::Vec2f>(y * res.width + x);
-            }
-        }
+        cv::Mat map(res.height, res.width, CV_32SC2);
+        mappoints.reshape(2, res.height).convertTo(map, CV_32SC2);
+        remap.compose(i, map.ptr<std::int32_t>(), truncate);
     }
 
 }
 
-int vPreProcess::queryUnprocessed()
+void vPreProcess::initROI(int x0, int y0, int x1, int y1)
 {
-    return inPort.queryunprocessed();
+    remap.crop(x0, y0, x1, y1);
 }
 
-std::deque<double> vPreProcess::getDelays()
+bool vPreProcess::addRoute(const std::string &route,
+                           const yarp::os::Bottle &conditions)
 {
-    std::deque<double> dcopy = delays;
-    delays.clear();
-    return dcopy;
+    eventRoute *new_route = new eventRoute(route);
+    if(!new_route->configure(conditions)) {
+        yError() << "Could not configure route" << route << conditions.toString();
+        delete new_route;
+        return false;
+    }
+    routes.push_back(new_route);
+    return true;
 }
 
-std::deque<double> vPreProcess::getRates()
+int vPreProcess::queryUnprocessed()
 {
-    std::deque<double> rcopy = rates;
-    rates.clear();
-    return rcopy;
+    return inPort.queryunprocessed();
 }
 
-std::deque<double> vPreProcess::getIntervals()
+void vPreProcess::initPipeline(unsigned int remap_threads,
+                               unsigned int n_packets)
 {
-    std::deque<double> icopy = intervals;
-    intervals.clear();
-    return icopy;
+    pipelined = true;
+    n_remap = std::max(remap_threads, 1u);
+    pool.resize(std::max(n_packets, n_remap + 2));
 }
 
 void vPreProcess::run()
 {
-    yarp::os::Stamp ystamp;
+    //the envelope (and any trace) of the packet being read
+    vTrace trace;
+    yarp::os::Stamp &ystamp = trace.stamp;
 
-    resolution resmod = res;
-    resmod.height -= 1;
-    resmod.width -= 1;
     int prev_bottle_n = 0;
 
-#if DECODE_METHOD != 2
-    outPort.setWriteType(AE::tag);
-    outPort2.setWriteType(AE::tag);
-#endif
-
     while(true) {
 
         double pyt = ystamp.getTime();
 
-#if DECODE_METHOD != 2
-        vQueue qleft, qright;
+#if DECODE_METHOD == 0
         const vQueue *q = inPort.read(ystamp);
+#elif DECODE_METHOD == 1
+        const vQueue *q = inPort.read(trace);
 #else
-        std::deque<AE> qleft, qright;
-        const std::vector<AE> *q = inPort.read(ystamp);
+        const std::vector<AE> *q = inPort.read(trace);
 #endif
         if(!q) break;
-        delays.push_back((Time::now() - ystamp.getTime()));
-        if(pyt) intervals.push_back(ystamp.getTime() - pyt);
-
-#if DECODE_METHOD != 2
-        rates.push_back((double)q->size() / (q->back()->stamp - q->front()->stamp));
-#else
-        rates.push_back((double)q->size() / (q->back().stamp - q->front().stamp));
-#endif
-
-
-
-//        ev::vQueue *q = 0;
-//        while(!q && !isStopping()) {
-//            q = inPort.getNextQ(ystamp);
-//        }
-//        if(isStopping()) break;
+        if(ystamp.isValid()) {
+            delay.record(Time::now() - ystamp.getTime());
+            if(pyt) interval.record(ystamp.getTime() - pyt);
+        }
+        events_in.add(q->size());
+        queue.set(inPort.queryunprocessed());
 
         if(precheck && prev_bottle_n + 1 != ystamp.getCount() && ystamp.getCount() && prev_bottle_n) {
             yWarning() << "Dropped bottle:" << prev_bottle_n << "to" << ystamp.getCount();
+            dropped.add(ystamp.getCount() - prev_bottle_n - 1);
         }
         prev_bottle_n = ystamp.getCount();
 
-
+        //a free packet (waits if all packets are in the pipeline)
+        eventPacket *packet = pipelined ? free_packets->pop() : &pool[0];
+        packet->trace = trace;
+        packet->received = Time::now();
 #if DECODE_METHOD != 2
-        for(ev::vQueue::const_iterator qi = q->begin(); qi != q->end(); qi++) {
-            auto v = is_event<AE>(*qi);
+        packet->events.clear();
+        for(ev::vQueue::const_iterator qi = q->begin(); qi != q->end(); qi++)
+            packet->events.push_back(*is_event<AE>(*qi));
 #else
-        for(std::vector<AE>::const_iterator qi = q->begin(); qi != q->end(); qi++) {
-            AE vcopy = *qi;
-            AE *v = &vcopy;
+        packet->events.assign(q->begin(), q->end());
 #endif
 
-            //precheck
-            if(precheck && (v->x < 0 || v->x > resmod.width || v->y < 0 || v->y > resmod.height)) {
-                yWarning() << "Event Corruption:" << v->getContent().toString();
-                continue;
-            }
+        if(pipelined) {
+            to_filter->push(packet);
+        } else {
+            filterPacket(*packet);
+            remapPacket(*packet);
+            writePacket(*packet);
+        }
+    }
 
-            //flipx
-            if(flipx) v->x = resmod.width - v->x;
-            //flipy
-            if(flipy) v->y = resmod.height - v->y;
-
-            //salt and pepper filter
-            if(pepper && !thefilter.check(v->x, v->y, v->polarity, v->channel, v->stamp))
-                continue;
-
-            //undistortion
-            if(undistort) {
-                cv::Vec2i mapPix;
-                if(v->getChannel() == 0)
-                    mapPix = leftMap.at<cv::Vec2i>(v->y, v->x);
-                else
-                    mapPix = rightMap.at<cv::Vec2i>(v->y, v->x);
-                v->x = mapPix[0];
-                v->y = mapPix[1];
-
-                //truncate to sensor bounds after mapping?
-                if(truncate && (v->x < 0 || v->x > resmod.width || v->y < 0 || v->y > resmod.height)) {
-                    continue;
-                }
+    //the stages finish once the packets before have been written
+    if(pipelined)
+        to_filter->push(nullptr);
 
-            }
+}
 
+void vPreProcess::filterPacket(eventPacket &packet)
+{
+    std::vector<AE> &events = packet.events;
+    packet.ustamps.resize(events.size());
 
-#if DECODE_METHOD != 2
-            if(split && v->channel)
-                qright.push_back(v);
-            else
-                qleft.push_back(v);
-#else
-            if(split && v->channel)
-                qright.push_back(*v);
-            else
-                qleft.push_back(*v);
-#endif
+    //hot pixels found are dropped by the remap table
+    if(hotpixels) {
+        hot.update(Time::now(), remap);
+        hot_pixels.set(hot.masked());
+    }
+
+    unsigned int k = 0;
+    for(unsigned int i = 0; i < events.size(); i++) {
+
+        AE &v = events[i];
+
+        //every event must pass through the unwrapper to catch each wrap
+        unsigned long int ustamp = 0;
+        if(unwrap) ustamp = unwrapper.unwrapUnordered(v.stamp);
+
+        //precheck
+        if(!remap.inside(v.channel, v.x, v.y)) {
+            if(precheck)
+                yWarning() << "Event Corruption:" << v.getContent().toString();
+            continue;
         }
 
-        if(qleft.size()) {
-            outPort.write(qleft, ystamp);
+        if(hotpixels)
+            hot.count(v.channel, v.x, v.y);
+
+        //salt and pepper filter (the neighbourhood of the sensor address)
+        if(pepper && !thefilter.check(v.x, v.y, v.polarity, v.channel, v.stamp))
+            continue;
+
+        if(k != i) events[k] = v;
+        packet.ustamps[k] = ustamp;
+        k++;
+    }
+
+    events.resize(k);
+}
+
+void vPreProcess::remapPacket(eventPacket &packet)
+{
+    std::vector<AE> &events = packet.events;
+
+    //flips, undistortion and truncation
+    unsigned int k = 0;
+    for(unsigned int i = 0; i < events.size(); i++) {
+        AE &v = events[i];
+        int x = v.x, y = v.y;
+        if(!remap.lookup(v.channel, x, y))
+            continue;
+        v.x = x;
+        v.y = y;
+        if(k != i) {
+            events[k] = v;
+            packet.ustamps[k] = packet.ustamps[i];
         }
-        if(qright.size()) {
-            outPort2.write(qright, ystamp);
+        k++;
+    }
+
+    events.resize(k);
+}
+
+void vPreProcess::writePacket(eventPacket &packet)
+{
+    //a single pass gives each event to all routes
+    const std::vector<AE> &events = packet.events;
+    for(unsigned int i = 0; i < events.size(); i++) {
+        for(unsigned int r = 0; r < routes.size(); r++)
+            routes[r]->route(events[i], packet.ustamps[i]);
+    }
+
+    unsigned int n_out = 0;
+    for(unsigned int r = 0; r < routes.size(); r++)
+        n_out += routes[r]->write(packet.trace);
+    events_out.add(n_out);
+
+    latency.record(Time::now() - packet.received);
+}
+
+void vPreProcess::runFilter()
+{
+    for(unsigned int turn = 0; true; turn = (turn + 1) % n_remap) {
+        eventPacket *packet = to_filter->pop();
+        if(!packet) {
+            for(unsigned int i = 0; i < n_remap; i++)
+                to_remap[i]->push(nullptr);
+            return;
         }
+        filterPacket(*packet);
+        to_remap[turn]->push(packet);
+    }
+}
+
+void vPreProcess::runRemap(unsigned int index)
+{
+    while(true) {
+        eventPacket *packet = to_remap[index]->pop();
+        if(packet) remapPacket(*packet);
+        to_output[index]->push(packet);
+        if(!packet) return;
+    }
+}
+
+void vPreProcess::runOutput()
+{
+    for(unsigned int turn = 0; true; turn = (turn + 1) % n_remap) {
+        eventPacket *packet = to_output[turn]->pop();
+        if(!packet) return;
+        writePacket(*packet);
+        free_packets->push(packet);
     }
+}
 
+void preProcessStage::run()
+{
+    if(role == FILTER)
+        owner->runFilter();
+    else if(role == REMAP)
+        owner->runRemap(index);
+    else
+        owner->runOutput();
 }
 
 void vPreProcess::onStop()
 {
+    //the routes are closed once the packets in the pipeline are written
     inPort.close();
-    outPort.close();
-    outPort2.close();
 
     //inPort.releaseDataLock();
 }
 
 bool vPreProcess::threadInit()
 {
-    if(split) {
-        if(!outPort.open(name + "/left:o"))
-            return false;
-        if(!outPort2.open(name + "/right:o"))
-            return false;
-    } else {
-        if(!outPort.open(name + "/vBottle:o"))
+    if(routes.empty() && split) {
+        addRoute("left", yarp::os::Bottle("channel 0"));
+        addRoute("right", yarp::os::Bottle("channel 1"));
+    } else if(routes.empty()) {
+        addRoute("vBottle", yarp::os::Bottle());
+    }
+    for(unsigned int i = 0; i < routes.size(); i++) {
+        if(!routes[i]->open(name, unwrap))
             return false;
     }
     if(!inPort.open(name + "/vBottle:i"))
         return false;
+    if(!stats.open(name + "/stats:o"))
+        return false;
+
+    if(hotpixels && !hot.start())
+        return false;
+
+    if(!pipelined)
+        return true;
+
+    unsigned int n_packets = pool.size();
+    free_packets = new packetQueue(n_packets);
+    to_filter = new packetQueue(n_packets);
+    for(unsigned int i = 0; i < n_packets; i++)
+        free_packets->push(&pool[i]);
+
+    stages.push_back(new preProcessStage(this, preProcessStage::FILTER));
+    for(unsigned int i = 0; i < n_remap; i++) {
+        to_remap.push_back(new packetQueue(n_packets + 1));
+        to_output.push_back(new packetQueue(n_packets + 1));
+        stages.push_back(new preProcessStage(this, preProcessStage::REMAP, i));
+    }
+    stages.push_back(new preProcessStage(this, preProcessStage::OUTPUT));
+
+    for(unsigned int i = 0; i < stages.size(); i++) {
+        if(stages[i]->start()) continue;
+        //end the stages already started
+        for(unsigned int j = i; j < stages.size(); j++)
+            delete stages[j];
+        stages.resize(i);
+        to_filter->push(nullptr);
+        threadRelease();
+        return false;
+    }
+
+    yInfo() << "Pipelined with" << n_remap << "remap threads and"
+            << n_packets << "packets";
     return true;
 }
 
+void vPreProcess::threadRelease()
+{
+    if(hotpixels)
+        hot.stop();
+
+    //the stages stop once the end of the packets has reached them
+    for(unsigned int i = 0; i < stages.size(); i++) {
+        stages[i]->join();
+        delete stages[i];
+    }
+    stages.clear();
+
+    for(unsigned int i = 0; i < to_remap.size(); i++) {
+        delete to_remap[i];
+        delete to_output[i];
+    }
+    to_remap.clear();
+    to_output.clear();
+    delete to_filter; to_filter = nullptr;
+    delete free_packets; free_packets = nullptr;
+
+    for(unsigned int i = 0; i < routes.size(); i++)
+        routes[i]->close();
+    stats.close();
+}
+
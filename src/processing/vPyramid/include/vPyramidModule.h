@@ -0,0 +1,97 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// \defgroup Modules Modules
+// \defgroup vPyramid vPyramid
+// \ingroup Modules
+// \brief downsamples the event-stream to 1/2, 1/4 ... resolution streams
+
+#ifndef __VPYRAMID_MODULE__
+#define __VPYRAMID_MODULE__
+
+#include <yarp/os/all.h>
+#include <iCub/eventdriven/all.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+using namespace ev;
+
+/// \brief reads the address events and publishes each level of a vPyramid
+/// on <name>/level<l>/vBottle:o. Each level is a filtered port (see
+/// ev::vFilteredWritePort) such that readers can also ask for a region.
+class vPyramidProcess : public yarp::os::Thread
+{
+private:
+
+    typedef vFilteredWritePort< std::deque<AE>, vWritePort<AE> > levelPort;
+
+    std::string name;
+    vReadPort<AE> inPort;
+    std::vector<levelPort *> outPorts;
+
+    vPyramid pyramid;
+    std::vector< std::deque<AE> > levels;
+
+    //timing stats
+    ev::vStats stats;
+    ev::vHistogram &delay;
+    ev::vHistogram &latency;
+    ev::vCounter &events_in;
+    std::vector<ev::vCounter *> events_out;
+    ev::vGauge &queue;
+
+public:
+
+    vPyramidProcess();
+    ~vPyramidProcess();
+
+    /// \brief set the sensor size and the number of levels
+    void initialise(const std::string &name, int width, int height,
+                    unsigned int levels);
+
+    /// \brief keep an event if its cell has not fired for period seconds
+    void setRefractory(double period);
+
+    /// \brief keep one in threshold events of a cell, leaking an event every
+    /// leak seconds
+    void setIntegrate(double threshold, double leak);
+
+    int queryUnprocessed();
+
+    bool threadInit();
+    void run();
+    void onStop();
+
+};
+
+class vPyramidModule : public yarp::os::RFModule
+{
+    vPyramidProcess downsampler;
+
+public:
+
+    //the virtual functions that need to be overloaded
+    virtual bool configure(yarp::os::ResourceFinder &rf);
+    virtual bool close();
+    virtual double getPeriod();
+    virtual bool updateModule();
+
+};
+
+#endif
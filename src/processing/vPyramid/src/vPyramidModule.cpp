@@ -0,0 +1,194 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vPyramidModule.h"
+#include <sstream>
+
+int main(int argc, char * argv[])
+{
+    /* initialize yarp network */
+    yarp::os::Network yarp;
+    if(!yarp.checkNetwork()) {
+        yError() << "Could not find YARP";
+        return 1;
+    }
+
+    /* prepare and configure the resource finder */
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose();
+    rf.setDefaultContext( "eventdriven" );
+    rf.setDefaultConfigFile( "vPyramid.ini" );
+    rf.configure( argc, argv );
+
+    /* create the module */
+    vPyramidModule pyramidModule;
+    /* run the module: runModule() calls configure first and, if successful, it then runs */
+    return pyramidModule.runModule(rf);
+}
+
+/******************************************************************************/
+//vPyramidModule
+/******************************************************************************/
+bool vPyramidModule::configure(yarp::os::ResourceFinder &rf)
+{
+    setName(rf.check("name", yarp::os::Value("/vPyramid")).asString().c_str());
+
+    downsampler.initialise(getName(),
+                           rf.check("width", yarp::os::Value(304)).asInt(),
+                           rf.check("height", yarp::os::Value(240)).asInt(),
+                           rf.check("levels", yarp::os::Value(3)).asInt());
+
+    std::string mode = rf.check("mode", yarp::os::Value("refractory")).asString();
+    if(mode == "refractory") {
+        downsampler.setRefractory(rf.check("refractory",
+                                           yarp::os::Value(0.001)).asDouble());
+    } else if(mode == "integrate") {
+        downsampler.setIntegrate(rf.check("threshold", yarp::os::Value(4)).asDouble(),
+                                 rf.check("leak", yarp::os::Value(0.01)).asDouble());
+    } else {
+        yError() << "Unknown mode" << mode << "(refractory or integrate)";
+        return false;
+    }
+
+    return downsampler.start();
+}
+
+bool vPyramidModule::close()
+{
+    downsampler.stop();
+    return yarp::os::RFModule::close();
+}
+
+bool vPyramidModule::updateModule()
+{
+    //unprocessed data
+    static int puqs = 0;
+    int uqs = downsampler.queryUnprocessed();
+    if(uqs || puqs) {
+        yInfo() << uqs << "unprocessed queues";
+        puqs = uqs;
+    }
+
+    return !isStopping();
+}
+
+double vPyramidModule::getPeriod()
+{
+    return 1.0;
+}
+
+/******************************************************************************/
+//vPyramidProcess
+/******************************************************************************/
+vPyramidProcess::vPyramidProcess() : name("/vPyramid"),
+    delay(stats.histogram("delay")), latency(stats.histogram("process")),
+    events_in(stats.counter("events_in")), queue(stats.gauge("queue"))
+{
+}
+
+vPyramidProcess::~vPyramidProcess()
+{
+    inPort.close();
+    for(unsigned int i = 0; i < outPorts.size(); i++) {
+        outPorts[i]->close();
+        delete outPorts[i];
+    }
+}
+
+void vPyramidProcess::initialise(const std::string &name, int width,
+                                 int height, unsigned int levels)
+{
+    this->name = name;
+    pyramid.initialise(width, height, levels);
+
+    for(unsigned int l = 1; l <= pyramid.levels(); l++) {
+        std::stringstream level;
+        level << "level" << l;
+        outPorts.push_back(new levelPort);
+        events_out.push_back(&stats.counter("events_" + level.str()));
+        resolution res = pyramid.levelSize(l);
+        yInfo() << level.str() << "is" << (int)res.width << "x"
+                << (int)res.height;
+    }
+}
+
+void vPyramidProcess::setRefractory(double period)
+{
+    pyramid.setRefractory(period);
+}
+
+void vPyramidProcess::setIntegrate(double threshold, double leak)
+{
+    pyramid.setIntegrate(threshold, leak);
+}
+
+int vPyramidProcess::queryUnprocessed()
+{
+    return inPort.queryunprocessed();
+}
+
+bool vPyramidProcess::threadInit()
+{
+    for(unsigned int l = 0; l < outPorts.size(); l++) {
+        std::stringstream port;
+        port << name << "/level" << l + 1 << "/vBottle:o";
+        outPorts[l]->setWriteType(AE::tag);
+        if(!outPorts[l]->open(port.str()))
+            return false;
+    }
+    if(!inPort.open(name + "/vBottle:i"))
+        return false;
+    return stats.open(name + "/stats:o");
+}
+
+void vPyramidProcess::run()
+{
+    //the envelope (and any trace) of the packet being read
+    vTrace trace;
+
+    while(true) {
+
+        const std::vector<AE> *q = inPort.read(trace);
+        if(!q) break;
+        if(trace.stamp.isValid())
+            delay.record(yarp::os::Time::now() - trace.stamp.getTime());
+        events_in.add(q->size());
+        queue.set(inPort.queryunprocessed());
+
+        vScopedTimer timer(latency);
+
+        //every level from one pass over the events
+        for(unsigned int l = 0; l < levels.size(); l++)
+            levels[l].clear();
+        pyramid.process(*q, levels);
+
+        for(unsigned int l = 0; l < levels.size(); l++) {
+            if(levels[l].empty()) continue;
+            events_out[l]->add(levels[l].size());
+            outPorts[l]->write(levels[l], trace);
+        }
+    }
+}
+
+void vPyramidProcess::onStop()
+{
+    inPort.close();
+    for(unsigned int l = 0; l < outPorts.size(); l++)
+        outPorts[l]->close();
+    stats.close();
+}
@@ -0,0 +1,119 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// \defgroup Modules Modules
+// \defgroup vTraceCollector vTraceCollector
+// \ingroup Modules
+// \brief reconstructs pipeline latencies from the traces in the envelopes
+
+#ifndef __VTRACECOLLECTOR__
+#define __VTRACECOLLECTOR__
+
+#include <yarp/os/all.h>
+#include <iCub/eventdriven/all.h>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <string>
+
+using namespace ev;
+
+/// \brief the per-hop and end-to-end latency distributions of the traces
+/// received, grouped by the path (the list of modules) they took
+class traceAnalysis
+{
+private:
+
+    struct segment {
+        std::string name;
+        vHistogram latency;
+    };
+
+    struct path {
+        std::deque<segment> segments;
+        unsigned long int count;
+        double watermark;
+        path() : count(0), watermark(0) {}
+    };
+
+    std::map<std::string, path> paths;
+    unsigned long int untraced;
+
+    vHistogram & getSegment(path &p, unsigned int i, const std::string &name);
+
+public:
+
+    traceAnalysis() : untraced(0) {}
+
+    /// \brief add a trace that arrived at the given (wall) time
+    void add(const vTrace &trace, double arrival);
+
+    /// \brief add the traces recorded by a vTraceReader
+    bool load(const std::string &file);
+
+    /// \brief print the distributions since the last report
+    void report();
+
+};
+
+/// \brief reads the envelope of each packet without decoding the events
+class envelopeOnly : public yarp::os::Portable
+{
+public:
+
+    bool read(yarp::os::ConnectionReader &connection) { return true; }
+    bool write(yarp::os::ConnectionWriter &connection) const { return false; }
+
+};
+
+class vTraceReader : public yarp::os::Thread
+{
+private:
+
+    yarp::os::Port port;
+    envelopeOnly payload;
+    std::ofstream recording;
+    yarp::os::Mutex m;
+    traceAnalysis analysis;
+
+public:
+
+    bool open(const std::string &name, const std::string &record);
+    void report();
+    void onStop();
+    void run();
+
+};
+
+class vTraceCollectorModule : public yarp::os::RFModule
+{
+    vTraceReader reader;
+    double period;
+
+public:
+
+    //the virtual functions that need to be overloaded
+    virtual bool configure(yarp::os::ResourceFinder &rf);
+    virtual bool interruptModule();
+    virtual bool close();
+    virtual double getPeriod();
+    virtual bool updateModule();
+
+};
+
+#endif
@@ -0,0 +1,245 @@
+/*
+ *   Copyright (C) 2017 Event-driven Perception for Robotics
+ *   Author: arren.glover@iit.it
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "vTraceCollector.h"
+#include <algorithm>
+#include <cstdio>
+
+int main(int argc, char * argv[])
+{
+    /* prepare and configure the resource finder */
+    yarp::os::ResourceFinder rf;
+    rf.setVerbose();
+    rf.setDefaultContext( "eventdriven" );
+    rf.setDefaultConfigFile( "vTraceCollector.ini" );
+    rf.configure( argc, argv );
+
+    /* a recording is analysed without a yarp network */
+    if(rf.check("file")) {
+        yarp::os::Network::init();
+        traceAnalysis analysis;
+        if(!analysis.load(rf.find("file").asString()))
+            return 1;
+        analysis.report();
+        return 0;
+    }
+
+    /* initialize yarp network */
+    yarp::os::Network yarp;
+    if(!yarp.checkNetwork()) {
+        yError() << "Could not find YARP";
+        return 1;
+    }
+
+    /* create the module */
+    vTraceCollectorModule collectorModule;
+    /* run the module: runModule() calls configure first and, if successful, it then runs */
+    return collectorModule.runModule(rf);
+}
+
+/******************************************************************************/
+//traceAnalysis
+/******************************************************************************/
+vHistogram & traceAnalysis::getSegment(path &p, unsigned int i,
+                                       const std::string &name)
+{
+    if(i >= p.segments.size()) {
+        p.segments.emplace_back();
+        p.segments.back().name = name;
+    }
+    return p.segments[i].latency;
+}
+
+void traceAnalysis::add(const vTrace &trace, double arrival)
+{
+    if(!trace.isTraced() || trace.hops.empty()) {
+        untraced++;
+        return;
+    }
+
+    //packets are grouped by the modules they passed through
+    std::string key;
+    for(size_t i = 0; i < trace.hops.size(); i++) {
+        if(i) key += " > ";
+        key += trace.hops[i].name;
+    }
+    path &p = paths[key];
+    p.count++;
+    p.watermark = std::max(p.watermark, trace.device_time);
+
+    //transport to each hop, and the time spent in each hop. A hop that has
+    //not recorded sending the packet is counted as sending it immediately
+    unsigned int s = 0;
+    double previous = trace.source_time;
+    for(size_t i = 0; i < trace.hops.size(); i++) {
+        const vTrace::hop &h = trace.hops[i];
+        getSegment(p, s++, "-> " + h.name).record(h.received - previous);
+        double sent = h.sent > 0 ? h.sent : h.received;
+        getSegment(p, s++, h.name).record(sent - h.received);
+        previous = sent;
+    }
+    getSegment(p, s++, "-> collector").record(arrival - previous);
+    getSegment(p, s++, "end-to-end").record(arrival - trace.source_time);
+}
+
+bool traceAnalysis::load(const std::string &file)
+{
+    std::ifstream input(file.c_str());
+    if(!input.is_open()) {
+        yError() << "Could not open" << file;
+        return false;
+    }
+
+    std::string line;
+    unsigned long int n = 0;
+    while(std::getline(input, line)) {
+        yarp::os::Bottle b;
+        b.fromString(line);
+        yarp::os::Bottle *record = b.get(1).asList();
+        vTrace trace;
+        if(!record || !trace.fromBottle(*record))
+            continue;
+        add(trace, b.get(0).asDouble());
+        n++;
+    }
+
+    yInfo() << "Read" << n << "traces from" << file;
+    return true;
+}
+
+void traceAnalysis::report()
+{
+    if(untraced)
+        std::printf("%lu packets without a trace\n", untraced);
+    untraced = 0;
+
+    std::map<std::string, path>::iterator pi;
+    for(pi = paths.begin(); pi != paths.end(); pi++) {
+        path &p = pi->second;
+        if(!p.count) continue;
+
+        std::printf("\n%s\n%lu packets, device time %.3fs\n", pi->first.c_str(),
+                    p.count, p.watermark);
+        std::printf("%-40s %10s %10s %10s %10s\n", "segment", "p50 (ms)",
+                    "p99 (ms)", "max (ms)", "mean (ms)");
+        for(size_t i = 0; i < p.segments.size(); i++) {
+            vHistogram::snapshot s = p.segments[i].latency.drain();
+            std::printf("%-40s %10.3f %10.3f %10.3f %10.3f\n",
+                        p.segments[i].name.c_str(), s.percentile(0.5) * 1e3,
+                        s.percentile(0.99) * 1e3, s.max() * 1e3,
+                        s.mean() * 1e3);
+        }
+        p.count = 0;
+    }
+    std::fflush(stdout);
+}
+
+/******************************************************************************/
+//vTraceReader
+/******************************************************************************/
+bool vTraceReader::open(const std::string &name, const std::string &record)
+{
+    if(record.size()) {
+        recording.open(record.c_str());
+        if(!recording.is_open()) {
+            yError() << "Could not open" << record;
+            return false;
+        }
+        yInfo() << "Recording traces to" << record;
+    }
+
+    return port.open(name + "/AE:i");
+}
+
+void vTraceReader::report()
+{
+    m.lock();
+    analysis.report();
+    m.unlock();
+}
+
+void vTraceReader::onStop()
+{
+    port.interrupt();
+    port.close();
+}
+
+void vTraceReader::run()
+{
+    while(!isStopping()) {
+
+        //the events themselves are skipped
+        if(!port.read(payload))
+            break;
+        double arrival = yarp::os::Time::now();
+
+        vTrace trace;
+        port.getEnvelope(trace);
+
+        if(recording.is_open()) {
+            yarp::os::Bottle b;
+            b.addDouble(arrival);
+            trace.toBottle(b.addList());
+            recording << b.toString() << std::endl;
+        }
+
+        m.lock();
+        analysis.add(trace, arrival);
+        m.unlock();
+    }
+
+    if(recording.is_open())
+        recording.close();
+}
+
+/******************************************************************************/
+//vTraceCollectorModule
+/******************************************************************************/
+bool vTraceCollectorModule::configure(yarp::os::ResourceFinder &rf)
+{
+    setName(rf.check("name", yarp::os::Value("/vTraceCollector")).asString().c_str());
+    period = rf.check("period", yarp::os::Value(5.0)).asDouble();
+
+    if(!reader.open(getName(), rf.check("record", yarp::os::Value("")).asString()))
+        return false;
+
+    return reader.start();
+}
+
+bool vTraceCollectorModule::interruptModule()
+{
+    reader.stop();
+    return yarp::os::RFModule::interruptModule();
+}
+
+bool vTraceCollectorModule::close()
+{
+    reader.stop();
+    return yarp::os::RFModule::close();
+}
+
+bool vTraceCollectorModule::updateModule()
+{
+    reader.report();
+    return !isStopping();
+}
+
+double vTraceCollectorModule::getPeriod()
+{
+    return period;
+}